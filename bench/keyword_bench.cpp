@@ -0,0 +1,158 @@
+// keyword_bench.cpp - 关键字查找微基准
+//
+// 对比旧实现（逐个 string_view 比较）与 keyword_type（编译期完美哈希）。
+// 用法: keyword_bench [file.prim ...]
+//   不带参数时使用内置的合成标识符集合；带参数时从源文件中提取标识符。
+
+#include "token.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+using namespace prim;
+
+namespace {
+
+// 旧实现：依次比较十个关键字
+TokenType check_keyword_linear(std::string_view text) {
+    if (text == "let")    return TokenType::KW_LET;
+    if (text == "del")    return TokenType::KW_DEL;
+    if (text == "if")     return TokenType::KW_IF;
+    if (text == "else")   return TokenType::KW_ELSE;
+    if (text == "loop")   return TokenType::KW_LOOP;
+    if (text == "break")  return TokenType::KW_BREAK;
+    if (text == "return") return TokenType::KW_RETURN;
+    if (text == "true")   return TokenType::KW_TRUE;
+    if (text == "false")  return TokenType::KW_FALSE;
+    if (text == "null")   return TokenType::KW_NULL;
+    return TokenType::IDENT;
+}
+
+bool is_ident_start(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool is_ident_char(char c) {
+    return is_ident_start(c) || (c >= '0' && c <= '9');
+}
+
+// 从源码中粗略提取标识符（含关键字）
+void extract_identifiers(std::string_view src, std::vector<std::string_view>& out) {
+    size_t i = 0;
+    while (i < src.size()) {
+        if (is_ident_start(src[i])) {
+            size_t j = i + 1;
+            while (j < src.size() && is_ident_char(src[j])) ++j;
+            out.push_back(src.substr(i, j - i));
+            i = j;
+        } else {
+            ++i;
+        }
+    }
+}
+
+// 合成标识符：从固定词表按 Zipf 分布抽样（源码中的名字大量重复），约 20% 为关键字
+std::vector<std::string> synthetic_identifiers(size_t count) {
+    static const char* keywords[] = {
+        "let", "del", "if", "else", "loop", "break", "return", "true", "false", "null",
+    };
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz_0123456789";
+
+    std::mt19937 rng(42);
+    std::vector<std::string> vocab;
+    for (size_t i = 0; i < 512; ++i) {
+        size_t len = 1 + rng() % 12;
+        std::string name(1, alphabet[rng() % 26]);
+        while (name.size() < len) name.push_back(alphabet[rng() % (sizeof(alphabet) - 1)]);
+        vocab.push_back(std::move(name));
+    }
+    std::vector<double> weights;
+    for (size_t i = 0; i < vocab.size(); ++i) weights.push_back(1.0 / static_cast<double>(i + 1));
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+
+    std::vector<std::string> idents;
+    idents.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (rng() % 5 == 0) {
+            idents.emplace_back(keywords[rng() % 10]);
+        } else {
+            idents.push_back(vocab[pick(rng)]);
+        }
+    }
+    return idents;
+}
+
+template <typename Fn>
+double measure(const std::vector<std::string_view>& idents, size_t rounds, Fn&& lookup, size_t& sink) {
+    auto start = std::chrono::steady_clock::now();
+    size_t keywords = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        for (std::string_view id : idents) {
+            keywords += lookup(id) != TokenType::IDENT;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    sink += keywords;
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(idents.size() * rounds) / seconds;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> storage;
+    std::vector<std::string_view> idents;
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            std::ifstream file(argv[i], std::ios::binary);
+            if (!file) {
+                fmt::print(stderr, "Error: cannot open {}\n", argv[i]);
+                return 1;
+            }
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            storage.push_back(buffer.str());
+        }
+        for (const auto& src : storage) extract_identifiers(src, idents);
+    } else {
+        storage = synthetic_identifiers(1 << 16);
+        for (const auto& s : storage) idents.push_back(s);
+    }
+
+    if (idents.empty()) {
+        fmt::print(stderr, "Error: no identifiers found\n");
+        return 1;
+    }
+
+    // 两种实现必须给出相同结果
+    for (std::string_view id : idents) {
+        if (check_keyword_linear(id) != keyword_type(id)) {
+            fmt::print(stderr, "Mismatch on '{}'\n", id);
+            return 1;
+        }
+    }
+
+    const size_t rounds = std::max<size_t>(1, (size_t{20} << 20) / idents.size());
+    size_t sink = 0;
+
+    // 预热
+    measure(idents, 1, check_keyword_linear, sink);
+    measure(idents, 1, keyword_type, sink);
+
+    double linear = measure(idents, rounds, check_keyword_linear, sink);
+    double hashed = measure(idents, rounds, keyword_type, sink);
+
+    fmt::print("identifiers: {} x {} rounds\n", idents.size(), rounds);
+    fmt::print("  linear compare : {:8.1f} M ident/s\n", linear / 1e6);
+    fmt::print("  perfect hash   : {:8.1f} M ident/s\n", hashed / 1e6);
+    fmt::print("  speedup        : {:8.2f}x\n", hashed / linear);
+    return sink == 0;  // 防止查找结果被优化掉
+}
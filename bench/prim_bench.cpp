@@ -0,0 +1,961 @@
+// prim_bench.cpp - 词法 / 语法分析吞吐量基准
+//
+// 对几类合成语料分别测量：
+//   lexer    - Lexer::next() 的 MB/s 与 tokens/s
+//   lexer_parallel - lex_parallel() 分块并行词法分析的 MB/s 与重新扫描的块数
+//   lexer_intern - 设置了 Interner 的 Lexer::next()（标识符 / 标签 / 字符串驻留）的 MB/s 与符号数
+//   parser   - Parser::parse()（token-buffer 模式）的 nodes/s 与堆分配字节数
+//   pipeline - Parser::parse(Lexer&)（词法与语法分析交替进行）的 MB/s 与 nodes/s
+//   parser_pratt / pipeline_pratt - 同上，使用 ParserBackend::Pratt
+//   edit     - Document::edit() 单字符编辑的平均延迟与重新分析的字节数
+//   ast_file - serialize_ast() 的 MB/s，以及 AstView::from_bytes() 校验 + 遍历全部节点的 nodes/s
+//   vm       - 与 prim/prime.prim 相同写法的素数循环、纯整数循环在 VM 上执行的 ops/s（每秒执行的指令数）与堆分配次数
+//   value_copy - Value 拷贝赋值的 values/s（只有直接存放的值 / 混有引用计数对象）
+// 结果以 JSON 输出到标准输出，便于记录和比较回归。
+//
+// 用法: prim_bench [--size MB] [--min-time SEC] [--filter NAME] [--simd NAME] [--out FILE] [--diff] [--programs N] [file.prim ...]
+//   --size      每类合成语料的大小（默认 4 MB，0 表示不生成合成语料）
+//   --min-time  每项测量至少运行的时间（默认 0.5 秒）
+//   --filter    只运行名称中包含 NAME 的语料（另有 "vm"、"value_copy" 两项）
+//   --simd      指定扫描内核（scalar / sse2 / avx2），默认按 CPU 自动选择
+//   --out       同时把 JSON 写入文件
+//   --diff      不测吞吐量，改为比较两个语法分析后端的结果（见 run_diff），有差异时返回 1
+//   --programs  --diff 时 grammar 生成器产生的语句数（默认 20000）
+//   file.prim   额外把这些源文件作为语料（每个文件单独一项）
+
+#include "ast_file.hpp"
+#include "compiler.hpp"
+#include "document.hpp"
+#include "interner.hpp"
+#include "lexer.hpp"
+#include "parallel_lexer.hpp"
+#include "parser.hpp"
+#include "simd.hpp"
+#include "source.hpp"
+#include "vm.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+using namespace prim;
+
+// ============================================================================
+// 堆分配统计（替换全局 operator new）
+// ============================================================================
+
+namespace {
+size_t g_alloc_bytes = 0;
+size_t g_alloc_count = 0;
+}
+
+void* operator new(size_t size) {
+    g_alloc_bytes += size;
+    ++g_alloc_count;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// ============================================================================
+// 合成语料
+// ============================================================================
+//
+// 每个生成器产出语法正确的 Prim 源码，直到达到目标大小
+
+using Generator = std::function<void(std::string& out, std::mt19937& rng)>;
+
+std::string ident(std::mt19937& rng) {
+    static const char* names[] = {
+        "x", "y", "count", "total", "index", "value", "result", "item", "node", "buffer_size",
+    };
+    return fmt::format("{}{}", names[rng() % 10], rng() % 100);
+}
+
+// 深层嵌套：括号表达式、嵌套作用域、嵌套 if
+void gen_nesting(std::string& out, std::mt19937& rng) {
+    const int depth = 16 + int(rng() % 48);
+    switch (rng() % 3) {
+    case 0:
+        out += "let " + ident(rng) + " = ";
+        out.append(size_t(depth), '(');
+        out += "1";
+        for (int i = 0; i < depth; ++i) out += " + 1)";
+        out += ";\n";
+        break;
+    case 1:
+        out += "let " + ident(rng) + " = ";
+        for (int i = 0; i < depth; ++i) out += "{ ";
+        out += "42";
+        for (int i = 0; i < depth; ++i) out += " }";
+        out += ";\n";
+        break;
+    default:
+        out += "let " + ident(rng) + " = @{ ";
+        for (int i = 0; i < depth; ++i) out += "if " + ident(rng) + " < 10 { ";
+        out += "1";
+        for (int i = 0; i < depth; ++i) out += " } else { 0 }";
+        out += " };\n";
+        break;
+    }
+}
+
+// 长字符串字面量（含少量转义）
+void gen_strings(std::string& out, std::mt19937& rng) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789,.;:";
+    const size_t len = 256 + rng() % 4096;
+    out += "let " + ident(rng) + " = \"";
+    for (size_t i = 0; i < len; ++i) {
+        if (rng() % 200 == 0) {
+            out += "\\n";
+        } else {
+            out += alphabet[rng() % (sizeof(alphabet) - 1)];
+        }
+    }
+    out += "\";\n";
+}
+
+// 大量短语句
+void gen_statements(std::string& out, std::mt19937& rng) {
+    switch (rng() % 5) {
+    case 0: out += "let " + ident(rng) + " = " + ident(rng) + " + 1;\n"; break;
+    case 1: out += ident(rng) + " = " + ident(rng) + " * 2 - " + ident(rng) + ";\n"; break;
+    case 2: out += "print(" + ident(rng) + ", " + ident(rng) + ");\n"; break;
+    case 3: out += "let " + ident(rng) + " = " + ident(rng) + "." + ident(rng) + "[0];\n"; break;
+    default: out += "del " + ident(rng) + ";\n"; break;
+    }
+}
+
+// 大型字典和列表字面量
+void gen_containers(std::string& out, std::mt19937& rng) {
+    const int n = 64 + int(rng() % 960);
+    if (rng() % 2) {
+        out += "let " + ident(rng) + " = [";
+        for (int i = 0; i < n; ++i) {
+            if (i) out += ", ";
+            if (i % 16 == 15) out += "\n    ";
+            if (rng() % 8 == 0) {
+                out += fmt::format("[{}, {}, {}]", rng() % 100, rng() % 100, rng() % 100);
+            } else {
+                out += fmt::format("{}", rng() % 100000);
+            }
+        }
+        out += "];\n";
+    } else {
+        out += "let " + ident(rng) + " = {";
+        for (int i = 0; i < n; ++i) {
+            if (i) out += ", ";
+            if (i % 8 == 7) out += "\n    ";
+            out += fmt::format("\"key{}\": ", i);
+            if (rng() % 4 == 0) {
+                out += fmt::format("[{}, \"v{}\"]", rng() % 100, i);
+            } else {
+                out += fmt::format("{}", rng() % 100000);
+            }
+        }
+        out += "};\n";
+    }
+}
+
+// 数字字面量密集
+void gen_numbers(std::string& out, std::mt19937& rng) {
+    out += "let " + ident(rng) + " = ";
+    const int n = 8 + int(rng() % 24);
+    static const char* ops[] = {" + ", " - ", " * ", " / ", " % "};
+    for (int i = 0; i < n; ++i) {
+        if (i) out += ops[rng() % 5];
+        switch (rng() % 6) {
+        case 0: out += fmt::format("{}", rng()); break;
+        case 1: out += fmt::format("0x{:X}", rng()); break;
+        case 2: out += fmt::format("0o{:o}", rng() % 4096); break;
+        case 3: out += fmt::format("0b{:b}", rng() % 256); break;
+        case 4: out += fmt::format("{}.{}e-{}", rng() % 1000, rng() % 1000, rng() % 20); break;
+        default: out += fmt::format("{}'{:03}'{:03}", rng() % 1000, rng() % 1000, rng() % 1000); break;
+        }
+    }
+    out += ";\n";
+}
+
+// 覆盖全部语法的随机程序：prim、装饰器、if / loop、tuple / dict、引用、类型提示等
+// （两个语法分析后端的差分检查也以它为主要语料）
+void gen_grammar_expr(std::string& out, std::mt19937& rng, int depth);
+void gen_grammar_stmt(std::string& out, std::mt19937& rng, int depth);
+
+void gen_grammar_literal(std::string& out, std::mt19937& rng) {
+    switch (rng() % 8) {
+    case 0: out += fmt::format("{}", rng() % 1000); break;
+    case 1: out += fmt::format("0x{:x}", rng() % 4096); break;
+    case 2: out += fmt::format("{}.{}", rng() % 100, rng() % 100); break;
+    case 3: out += fmt::format("\"s{}\\n\"", rng() % 100); break;
+    case 4: out += "true"; break;
+    case 5: out += "false"; break;
+    case 6: out += "null"; break;
+    default: out += "()"; break;
+    }
+}
+
+// expr 或 ref_expr（"&" 后只能是 primary_expr）
+void gen_grammar_value(std::string& out, std::mt19937& rng, int depth) {
+    if (rng() % 6 == 0) {
+        out += "&" + ident(rng);
+    } else {
+        gen_grammar_expr(out, rng, depth);
+    }
+}
+
+void gen_grammar_block(std::string& out, std::mt19937& rng, int depth) {
+    out += "{ ";
+    const int n = 1 + int(rng() % 3);
+    for (int i = 0; i < n; ++i) {
+        if (i) out += "; ";
+        gen_grammar_stmt(out, rng, depth);
+    }
+    if (rng() % 3 == 0) out += ";";
+    out += " }";
+}
+
+void gen_grammar_type_hint(std::string& out, std::mt19937& rng) {
+    if (rng() % 2) return;
+    static const char* types[] = {"int", "float", "str", "list"};
+    out += ": ";
+    out += types[rng() % 4];
+    if (rng() % 3 == 0) out += fmt::format(" | {}", types[rng() % 4]);
+}
+
+void gen_grammar_prim(std::string& out, std::mt19937& rng, int depth) {
+    const int decorators = rng() % 3 == 0 ? 1 + int(rng() % 2) : 0;
+    for (int i = 0; i < decorators; ++i) out += "@" + ident(rng) + " ";
+    if (rng() % 2) {
+        out += "@";
+        gen_grammar_block(out, rng, depth);
+        return;
+    }
+    out += "$" + ident(rng) + "(";
+    const int params = int(rng() % 4);
+    for (int i = 0; i < params; ++i) {
+        if (i) out += ", ";
+        if (rng() % 4 == 0) out += "&";
+        out += ident(rng);
+        gen_grammar_type_hint(out, rng);
+    }
+    if (params && rng() % 4 == 0) out += ",";
+    out += ")";
+    gen_grammar_type_hint(out, rng);
+    out += rng() % 2 ? " @" : " ";
+    gen_grammar_block(out, rng, depth);
+}
+
+void gen_grammar_expr(std::string& out, std::mt19937& rng, int depth) {
+    static const char* binary_ops[] = {
+        " = ", " || ", " && ", " == ", " != ", " < ", " > ", " <= ", " >= ", " + ", " - ", " * ", " / ", " % ",
+    };
+    if (depth <= 0) {
+        if (rng() % 2) {
+            out += ident(rng);
+        } else {
+            gen_grammar_literal(out, rng);
+        }
+        return;
+    }
+    switch (rng() % 16) {
+    case 0:
+    case 1:
+    case 2:
+        gen_grammar_expr(out, rng, depth - 1);
+        out += binary_ops[rng() % 14];
+        gen_grammar_expr(out, rng, depth - 1);
+        break;
+    case 3:
+        out += "!-+"[rng() % 3];
+        gen_grammar_expr(out, rng, depth - 1);
+        break;
+    case 4:
+        out += ident(rng) + "(";
+        for (int i = 0, n = int(rng() % 3); i < n; ++i) {
+            if (i) out += ", ";
+            gen_grammar_value(out, rng, depth - 1);
+        }
+        out += ")";
+        break;
+    case 5: {
+        // x[i].f / x[i:j] / x[:j] / x[i:] / x[:]
+        out += ident(rng) + "[";
+        const unsigned form = rng() % 5;
+        if (form != 2 && form != 4) gen_grammar_expr(out, rng, depth - 1);
+        if (form == 0) {
+            out += "]." + ident(rng);
+            break;
+        }
+        out += ":";
+        if (form == 1 || form == 2) gen_grammar_expr(out, rng, depth - 1);
+        out += "]";
+        break;
+    }
+    case 6:
+        out += "(";
+        gen_grammar_expr(out, rng, depth - 1);
+        out += ")";
+        break;
+    case 7: {
+        // (a,) / (&a, b) / (a, b,)
+        out += "(";
+        gen_grammar_value(out, rng, depth - 1);
+        out += ",";
+        for (int i = 0, n = int(rng() % 3); i < n; ++i) {
+            out += " ";
+            gen_grammar_value(out, rng, depth - 1);
+            if (i + 1 < n || rng() % 2) out += ",";
+        }
+        out += ")";
+        break;
+    }
+    case 8:
+        out += "[";
+        for (int i = 0, n = int(rng() % 4); i < n; ++i) {
+            if (i) out += ", ";
+            gen_grammar_value(out, rng, depth - 1);
+        }
+        out += "]";
+        break;
+    case 9:
+        out += "{";
+        for (int i = 0, n = int(rng() % 3); i < n; ++i) {
+            if (i) out += ", ";
+            gen_grammar_expr(out, rng, depth - 1);
+            out += ": ";
+            gen_grammar_value(out, rng, depth - 1);
+        }
+        if (rng() % 4 == 0) out += out.back() == '{' ? "" : ",";
+        out += "}";
+        break;
+    case 10:
+        gen_grammar_block(out, rng, depth - 1);
+        break;
+    case 11:
+        out += "if ";
+        gen_grammar_expr(out, rng, depth - 1);
+        out += " ";
+        gen_grammar_block(out, rng, depth - 1);
+        if (rng() % 2) {
+            out += " else ";
+            if (rng() % 3 == 0) {
+                out += "if " + ident(rng) + " ";
+                gen_grammar_block(out, rng, depth - 1);
+            } else {
+                gen_grammar_block(out, rng, depth - 1);
+            }
+        }
+        break;
+    case 12:
+        out += rng() % 2 ? "loop `outer` " : "loop ";
+        gen_grammar_block(out, rng, depth - 1);
+        break;
+    case 13:
+    case 14:
+        gen_grammar_prim(out, rng, depth - 1);
+        break;
+    default:
+        gen_grammar_literal(out, rng);
+        break;
+    }
+}
+
+void gen_grammar_stmt(std::string& out, std::mt19937& rng, int depth) {
+    switch (rng() % 8) {
+    case 0:
+    case 1: {
+        out += "let ";
+        for (int i = 0, n = 1 + int(rng() % 2); i < n; ++i) {
+            if (i) out += ", ";
+            if (rng() % 4 == 0) out += "&";
+            out += ident(rng);
+            gen_grammar_type_hint(out, rng);
+        }
+        if (rng() % 5) {
+            out += " = ";
+            gen_grammar_value(out, rng, depth);
+        }
+        break;
+    }
+    case 2:
+        out += "del " + ident(rng);
+        if (rng() % 2) out += ", " + ident(rng);
+        break;
+    case 3:
+        out += "break";
+        if (rng() % 2) out += " `outer`";
+        if (rng() % 2) {
+            out += " ";
+            gen_grammar_value(out, rng, depth);
+        }
+        break;
+    case 4:
+        out += "return";
+        if (rng() % 2) {
+            out += " ";
+            gen_grammar_value(out, rng, depth);
+        }
+        break;
+    default:
+        gen_grammar_expr(out, rng, depth);
+        break;
+    }
+}
+
+void gen_grammar(std::string& out, std::mt19937& rng) {
+    gen_grammar_stmt(out, rng, 1 + int(rng() % 4));
+    out += rng() % 8 ? ";\n" : ";;\n";
+}
+
+std::string generate(const Generator& gen, size_t bytes) {
+    std::mt19937 rng(42);
+    std::string out;
+    out.reserve(bytes + 8192);
+    while (out.size() < bytes) gen(out, rng);
+    return out;
+}
+
+// ============================================================================
+// 测量
+// ============================================================================
+
+struct Corpus {
+    std::string  name;
+    SourceBuffer source;  // 带 '\0' 哨兵，Lexer 直接扫描，不计入拷贝开销
+};
+
+double now_seconds() {
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
+// 重复运行 fn 直到累计时间达到 min_time，返回 {平均耗时, 次数}
+template <typename Fn>
+std::pair<double, size_t> repeat(double min_time, Fn&& fn) {
+    fn();  // 预热
+    size_t iterations = 0;
+    const double start = now_seconds();
+    double elapsed = 0;
+    do {
+        fn();
+        ++iterations;
+        elapsed = now_seconds() - start;
+    } while (elapsed < min_time || iterations < 3);
+    return {elapsed / double(iterations), iterations};
+}
+
+size_t lex_all(const SourceBuffer& source, std::vector<Token>* out, Interner* symbols = nullptr) {
+    Lexer lexer(source);
+    lexer.set_interner(symbols);
+    size_t count = 0;
+    for (;;) {
+        Token tok = lexer.next();
+        ++count;
+        if (out) out->push_back(tok);
+        if (tok.type == TokenType::END) break;
+    }
+    return count;
+}
+
+std::string bench_lexer(const Corpus& c, double min_time) {
+    size_t tokens = 0;
+    auto [seconds, iterations] = repeat(min_time, [&] { tokens = lex_all(c.source, nullptr); });
+    const double mb = double(c.source.size()) / 1e6;
+    return fmt::format(
+        "    {{\"name\": \"lexer/{}\", \"bytes\": {}, \"tokens\": {}, \"iterations\": {}, "
+        "\"seconds\": {:.6f}, \"mb_per_s\": {:.2f}, \"tokens_per_s\": {:.0f}}}",
+        c.name, c.source.size(), tokens, iterations,
+        seconds, mb / seconds, double(tokens) / seconds);
+}
+
+std::string bench_lexer_parallel(const Corpus& c, double min_time) {
+    ParallelLexStats stats;
+    size_t tokens = 0;
+    auto [seconds, iterations] = repeat(min_time, [&] {
+        tokens = lex_parallel(c.source, 0, kParallelLexMinChunk, &stats).size();
+    });
+    const double mb = double(c.source.size()) / 1e6;
+    return fmt::format(
+        "    {{\"name\": \"lexer_parallel/{}\", \"bytes\": {}, \"tokens\": {}, \"chunks\": {}, \"relexed\": {}, "
+        "\"iterations\": {}, \"seconds\": {:.6f}, \"mb_per_s\": {:.2f}}}",
+        c.name, c.source.size(), tokens, stats.chunks, stats.relexed,
+        iterations, seconds, mb / seconds);
+}
+
+std::string bench_lexer_intern(const Corpus& c, double min_time) {
+    size_t tokens = 0;
+    size_t symbols = 0;
+    auto [seconds, iterations] = repeat(min_time, [&] {
+        Interner interner;  // 每次从空符号表开始，包含扩容开销
+        tokens = lex_all(c.source, nullptr, &interner);
+        symbols = interner.size();
+    });
+    const double mb = double(c.source.size()) / 1e6;
+    return fmt::format(
+        "    {{\"name\": \"lexer_intern/{}\", \"bytes\": {}, \"tokens\": {}, \"symbols\": {}, "
+        "\"iterations\": {}, \"seconds\": {:.6f}, \"mb_per_s\": {:.2f}}}",
+        c.name, c.source.size(), tokens, symbols,
+        iterations, seconds, mb / seconds);
+}
+
+// 结果名前缀：Bison 后端沿用原来的名字，便于与历史结果比较
+std::string bench_name(const char* kind, ParserBackend backend) {
+    return backend == ParserBackend::Pratt ? fmt::format("{}_pratt", kind) : std::string(kind);
+}
+
+std::string bench_parser(const Corpus& c, double min_time, ParserBackend backend) {
+    std::vector<Token> tokens;
+    lex_all(c.source, &tokens);
+
+    // 首次解析：新建的 Parser，所有存储都需要分配
+    size_t nodes = 0, ast_bytes = 0, errors = 0;
+    bool ok = false;
+    size_t cold_bytes = 0, cold_count = 0;
+    {
+        const size_t b0 = g_alloc_bytes, n0 = g_alloc_count;
+        Parser parser;
+        parser.set_backend(backend);
+        auto root = parser.parse(tokens);
+        cold_bytes = g_alloc_bytes - b0;
+        cold_count = g_alloc_count - n0;
+        ok = root.has_value();
+        errors = parser.get_errors().size();
+        nodes = parser.ast().size();
+        ast_bytes = parser.ast().memory_bytes();
+    }
+
+    // 稳定状态：复用同一个 Parser（AST 与 arena 保留容量）
+    Parser parser;
+    parser.set_backend(backend);
+    auto [seconds, iterations] = repeat(min_time, [&] { parser.parse(tokens); });
+    const size_t b0 = g_alloc_bytes, n0 = g_alloc_count;
+    parser.parse(tokens);
+    const size_t warm_bytes = g_alloc_bytes - b0;
+    const size_t warm_count = g_alloc_count - n0;
+
+    return fmt::format(
+        "    {{\"name\": \"{}/{}\", \"ok\": {}, \"errors\": {}, \"tokens\": {}, \"nodes\": {}, \"iterations\": {}, "
+        "\"seconds\": {:.6f}, \"nodes_per_s\": {:.0f}, \"tokens_per_s\": {:.0f}, \"ast_bytes\": {}, "
+        "\"alloc_bytes_cold\": {}, \"allocs_cold\": {}, \"alloc_bytes_warm\": {}, \"allocs_warm\": {}}}",
+        bench_name("parser", backend), c.name, ok ? "true" : "false", errors, tokens.size(), nodes, iterations,
+        seconds, double(nodes) / seconds, double(tokens.size()) / seconds, ast_bytes,
+        cold_bytes, cold_count, warm_bytes, warm_count);
+}
+
+std::string bench_pipeline(const Corpus& c, double min_time, ParserBackend backend) {
+    Parser parser;
+    parser.set_backend(backend);
+    size_t nodes = 0;
+    bool ok = false;
+    auto [seconds, iterations] = repeat(min_time, [&] {
+        Lexer lexer(c.source);
+        ok = parser.parse(lexer).has_value();
+        nodes = parser.ast().size();
+    });
+    const double mb = double(c.source.size()) / 1e6;
+    return fmt::format(
+        "    {{\"name\": \"{}/{}\", \"ok\": {}, \"bytes\": {}, \"nodes\": {}, \"iterations\": {}, "
+        "\"seconds\": {:.6f}, \"mb_per_s\": {:.2f}, \"nodes_per_s\": {:.0f}}}",
+        bench_name("pipeline", backend), c.name, ok ? "true" : "false", c.source.size(), nodes, iterations,
+        seconds, mb / seconds, double(nodes) / seconds);
+}
+
+std::string bench_edit(const Corpus& c, double min_time) {
+    const double t0 = now_seconds();
+    Document doc(c.source.view());
+    const double build_seconds = now_seconds() - t0;
+
+    // 在随机位置插入一个空格再删掉，每次迭代两次编辑
+    std::mt19937 rng(42);
+    size_t edits = 0, relexed = 0;
+    auto [seconds, iterations] = repeat(min_time, [&] {
+        const uint32_t offset = uint32_t(rng() % (doc.size() + 1));
+        relexed += doc.edit(offset, 0, " ")->relexed_bytes;
+        relexed += doc.edit(offset, 1, "")->relexed_bytes;
+        edits += 2;
+    });
+    return fmt::format(
+        "    {{\"name\": \"edit/{}\", \"bytes\": {}, \"segments\": {}, \"build_seconds\": {:.6f}, "
+        "\"iterations\": {}, \"edit_us\": {:.2f}, \"relexed_bytes_per_edit\": {:.0f}}}",
+        c.name, doc.size(), doc.segments().size(), build_seconds,
+        iterations, seconds / 2 * 1e6, double(relexed) / double(edits));
+}
+
+std::string bench_ast_file(const Corpus& c, double min_time) {
+    Parser parser;
+    Lexer lexer(c.source);
+    parser.parse(lexer);
+    const Ast& ast = parser.ast();
+
+    std::string bytes;
+    auto [write_seconds, write_iterations] = repeat(min_time, [&] { bytes = serialize_ast(ast); });
+
+    // 载入：校验后按子节点遍历一遍，读取每个 token 的文本（与 mmap 之后的访问相同）
+    const SourceBuffer copy = SourceBuffer::from_string(bytes);
+    size_t checksum = 0;
+    auto [load_seconds, load_iterations] = repeat(min_time, [&] {
+        auto view = AstView::from_bytes(copy.view());
+        for (NodeId id = 0; id < view->size(); ++id) {
+            if (const AstFileToken* tok = view->token(id)) checksum += view->text(*tok).size();
+            checksum += view->children(id).size();
+        }
+    });
+    return fmt::format(
+        "    {{\"name\": \"ast_file/{}\", \"nodes\": {}, \"file_bytes\": {}, \"ast_bytes\": {}, "
+        "\"write_iterations\": {}, \"write_mb_per_s\": {:.2f}, \"load_iterations\": {}, "
+        "\"load_seconds\": {:.6f}, \"load_nodes_per_s\": {:.0f}, \"checksum\": {}}}",
+        c.name, ast.size(), bytes.size(), ast.memory_bytes(),
+        write_iterations, double(bytes.size()) / 1e6 / write_seconds, load_iterations,
+        load_seconds, double(ast.size()) / load_seconds, checksum);
+}
+
+// ============================================================================
+// VM 与 Value
+// ============================================================================
+
+// 试除法求 limit 以内的素数：整数运算、比较、带标签的 break、命名 prim 调用、push / len
+constexpr const char* kPrimeProgram = R"(
+$is_prime(n) {
+    if n < 2 {
+        false
+    } else if n % 2 == 0 {
+        n == 2
+    } else {
+        let i = 3;
+        loop `check` {
+            if i * i > n { break `check` true; };
+            if n % i == 0 { break `check` false; };
+            i = i + 2;
+        }
+    }
+};
+
+$find_primes(limit) {
+    let primes = [];
+    let i = 2;
+    loop `collect` {
+        if i > limit { break `collect` primes; };
+        if is_prime(i) { primes.push(i); };
+        i = i + 1;
+    }
+};
+
+len(find_primes(limit))
+)";
+
+// 只有整数运算、比较和跳转的循环（快速路径的上限）
+constexpr const char* kIntLoopProgram = R"(
+$sum(limit) {
+    let total = 0;
+    let i = 0;
+    loop {
+        if i >= limit { break total; };
+        total = total + i * 3 % 7 - 1;
+        i = i + 1;
+    }
+};
+
+sum(limit)
+)";
+
+// program 读取全局变量 limit，结果应为整数
+std::string bench_vm(const char* name, const char* program, size_t limit, double min_time) {
+    const SourceBuffer source = SourceBuffer::from_string(fmt::format("let limit = {};\n", limit) + program);
+    Parser parser;
+    Lexer lexer(source);
+    parser.parse(lexer);
+    std::vector<CompileError> errors;
+    const std::optional<Module> module = compile(parser.ast(), errors);
+    if (!module) {
+        fmt::print(stderr, "Error: vm/{} failed to compile: {}\n", name, errors.front().message);
+        std::exit(1);
+    }
+
+    // 指令数用单独实例化的计数循环统计，计时的 run() 不带计数开销
+    VM vm;
+    uint64_t ops = 0;
+    const std::optional<Value> counted = vm.run_counted(*module, ops);
+    const int64_t value = counted && counted->is_int() ? counted->as_int() : -1;
+
+    auto [seconds, iterations] = repeat(min_time, [&] { vm.run(*module); });
+    const size_t n0 = g_alloc_count;
+    vm.run(*module);
+    const size_t allocs = g_alloc_count - n0;
+
+    return fmt::format(
+        "    {{\"name\": \"vm/{}\", \"dispatch\": \"{}\", \"limit\": {}, \"value\": {}, \"ops\": {}, "
+        "\"iterations\": {}, \"seconds\": {:.6f}, \"ops_per_s\": {:.0f}, \"allocs_per_run\": {}}}",
+        name, VM::dispatch_mode(), limit, value, ops,
+        iterations, seconds, double(ops) / seconds, allocs);
+}
+
+// 把 count 个值拷贝赋值到另一个数组（每 heap_every 个值中有一个是字符串或 list，0 表示没有）
+std::string bench_value_copy(const char* name, size_t count, size_t heap_every, double min_time) {
+    const Value text = make_str("shared");
+    const Value list = Value::adopt(new ListObject(ValueType::List));
+    std::vector<Value> src(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (heap_every && i % heap_every == 0) src[i] = i / heap_every % 2 ? text : list;
+        else if (i % 3 == 0)                   src[i] = Value::real(double(i) * 0.5);
+        else if (i % 3 == 1)                   src[i] = Value::integer(int64_t(i));
+        else                                   src[i] = Value::boolean(i % 2);
+    }
+    std::vector<Value> dst(count);
+
+    auto [seconds, iterations] = repeat(min_time, [&] {
+        for (size_t i = 0; i < count; ++i) dst[i] = src[i];
+    });
+    return fmt::format(
+        "    {{\"name\": \"value_copy/{}\", \"value_bytes\": {}, \"values\": {}, \"iterations\": {}, "
+        "\"seconds\": {:.6f}, \"values_per_s\": {:.0f}}}",
+        name, sizeof(Value), count, iterations, seconds, double(count) / seconds);
+}
+
+// ============================================================================
+// 差分检查（--diff）
+// ============================================================================
+//
+// 两个语法分析后端分析同一段源码：合法输入的 AST 必须逐节点相同
+// （节点类型、标志、token 下标与位置、子节点），有错误时第一个错误的位置必须相同。
+// 语料为合成语料、命令行给出的文件、grammar 生成器的单条语句，
+// 以及对这些语句和较小的语料（示例程序等）随机删除 / 替换 / 插入 token 得到的错误输入。
+
+constexpr size_t kMutateCorpusLimit = 64 * 1024;  // 不超过此大小的语料另外随机改坏
+constexpr int    kCorpusMutations   = 50;
+
+// 比较两个后端对 source 的分析结果，相同时返回空串，否则返回差异描述
+std::string compare_backends(const SourceBuffer& source, Parser& bison, Parser& pratt) {
+    Lexer bison_lexer(source);
+    Lexer pratt_lexer(source);
+    const bool bison_ok = bison.parse(bison_lexer).has_value();
+    const bool pratt_ok = pratt.parse(pratt_lexer).has_value();
+    if (bison_ok != pratt_ok) {
+        return fmt::format("bison {}, pratt {}", bison_ok ? "accepts" : "rejects", pratt_ok ? "accepts" : "rejects");
+    }
+
+    if (!bison_ok) {
+        const auto& a = bison.get_errors();
+        const auto& b = pratt.get_errors();
+        if (a.empty() || b.empty()) return {};  // 不会发生：失败时一定有错误
+        if (a.front().offset != b.front().offset) {
+            return fmt::format("first error at {} (bison: {}) vs {} (pratt: {})",
+                               a.front().offset, a.front().message, b.front().offset, b.front().message);
+        }
+        return {};
+    }
+
+    const Ast& a = bison.ast();
+    const Ast& b = pratt.ast();
+    if (a.size() != b.size() || a.root() != b.root()) {
+        return fmt::format("{} nodes (root {}) vs {} nodes (root {})", a.size(), a.root(), b.size(), b.root());
+    }
+    for (NodeId id = 0; id < a.size(); ++id) {
+        const ASTNode& x = a[id];
+        const ASTNode& y = b[id];
+        const Token* tx = a.token(id);
+        const Token* ty = b.token(id);
+        const auto cx = a.children(id);
+        const auto cy = b.children(id);
+        const bool same = x.type == y.type && x.flags == y.flags && x.token == y.token &&
+                          (tx == nullptr) == (ty == nullptr) &&
+                          (!tx || (tx->begin == ty->begin && tx->type == ty->type)) &&
+                          std::equal(cx.begin(), cx.end(), cy.begin(), cy.end());
+        if (!same) {
+            return fmt::format("node {} differs (type {} vs {}, {} vs {} children)",
+                               id, int(x.type), int(y.type), cx.size(), cy.size());
+        }
+    }
+    return {};
+}
+
+// 随机改坏一段源码：在 token 边界处删除、替换或插入 1~3 处
+std::string mutate(std::string_view text, std::mt19937& rng) {
+    static const char* pieces[] = {
+        "", "", "", ";", ",", "(", ")", "{", "}", "[", "]", "@", "$", ":", "&", "=", "|", ".",
+        "let", "del", "if", "else", "loop", "break", "return", "+", "!", "x", "1", "`l`", "\"s\"", "#",
+    };
+    const SourceBuffer source = SourceBuffer::from_string(std::string(text));
+    std::vector<Token> tokens;
+    lex_all(source, &tokens);
+
+    // 从后往前修改，前面 token 的偏移保持有效
+    std::vector<size_t> picks;
+    for (int i = 0, n = 1 + int(rng() % 3); i < n; ++i) picks.push_back(rng() % tokens.size());  // 可以是 END
+    std::sort(picks.begin(), picks.end());
+    picks.erase(std::unique(picks.begin(), picks.end()), picks.end());
+
+    std::string out(text);
+    for (auto it = picks.rbegin(); it != picks.rend(); ++it) {
+        const Token& tok = tokens[*it];
+        const char* piece = pieces[rng() % (sizeof(pieces) / sizeof(pieces[0]))];
+        const size_t erase = rng() % 3 == 0 ? 0 : tok.length;  // 0：插入在该 token 之前
+        out.replace(tok.begin, erase, std::string(piece) + (erase ? "" : " "));
+    }
+    return out;
+}
+
+// 运行差分检查，返回发现的差异数
+size_t run_diff(const std::vector<Corpus>& corpora, size_t programs) {
+    Parser bison;
+    Parser pratt;
+    pratt.set_backend(ParserBackend::Pratt);
+
+    size_t inputs = 0, valid = 0, mismatches = 0;
+    auto check = [&](const std::string& name, const SourceBuffer& source) {
+        ++inputs;
+        const std::string diff = compare_backends(source, bison, pratt);
+        if (diff.empty()) {
+            valid += bison.has_errors() ? 0 : 1;
+            return;
+        }
+        if (++mismatches <= 20) {
+            fmt::print(stderr, "mismatch in {}: {}\n", name, diff);
+            if (source.size() <= 400) fmt::print(stderr, "  source: {}\n", source.view());
+        }
+    };
+
+    // 完整程序及其变体：错误恢复经过真实程序中的各种结构
+    std::mt19937 corpus_rng(11);
+    for (const auto& c : corpora) {
+        check(c.name, c.source);
+        if (c.source.size() > kMutateCorpusLimit) continue;
+        for (int k = 0; k < kCorpusMutations; ++k) {
+            check(fmt::format("{}/mutation#{}", c.name, k), SourceBuffer::from_string(mutate(c.source.view(), corpus_rng)));
+        }
+    }
+
+    // 单条语句及其变体：出错位置分布在各种语法结构中
+    std::mt19937 rng(7);
+    std::string program;
+    for (size_t i = 0; i < programs; ++i) {
+        program.clear();
+        gen_grammar(program, rng);
+        check(fmt::format("grammar#{}", i), SourceBuffer::from_string(program));
+        for (int k = 0; k < 8; ++k) {
+            check(fmt::format("grammar#{}/mutation#{}", i, k), SourceBuffer::from_string(mutate(program, rng)));
+        }
+    }
+
+    fmt::print("{{\"diff\": {{\"inputs\": {}, \"valid\": {}, \"invalid\": {}, \"mismatches\": {}}}}}\n",
+               inputs, valid, inputs - valid, mismatches);
+    return mismatches;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t size_mb = 4;
+    double min_time = 0.5;
+    std::string filter;
+    std::string out_path;
+    bool diff = false;
+    size_t programs = 20000;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) {
+            size_mb = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            min_time = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--simd" && i + 1 < argc) {
+            const simd::Kernels* k = simd::find_kernels(argv[++i]);
+            if (!k) {
+                fmt::print(stderr, "Error: SIMD kernels '{}' not available\n", argv[i]);
+                return 1;
+            }
+            simd::use_kernels(*k);
+        } else if (arg == "--out" && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (arg == "--diff") {
+            diff = true;
+        } else if (arg == "--programs" && i + 1 < argc) {
+            programs = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--help" || arg == "-h") {
+            fmt::print("Usage: {} [--size MB] [--min-time SEC] [--filter NAME] [--simd NAME] [--out FILE] [--diff] [--programs N] [file.prim ...]\n", argv[0]);
+            return 0;
+        } else {
+            files.emplace_back(arg);
+        }
+    }
+
+    const size_t bytes = size_mb << 20;
+    const std::pair<const char*, Generator> generators[] = {
+        {"nesting",    gen_nesting},
+        {"strings",    gen_strings},
+        {"statements", gen_statements},
+        {"containers", gen_containers},
+        {"numbers",    gen_numbers},
+        {"grammar",    gen_grammar},
+    };
+
+    std::vector<Corpus> corpora;
+    for (const auto& [name, gen] : generators) {
+        if (bytes == 0) break;
+        if (!filter.empty() && std::string_view(name).find(filter) == std::string_view::npos) continue;
+        corpora.push_back({name, SourceBuffer::from_string(generate(gen, bytes))});
+    }
+    for (const auto& path : files) {
+        auto source = SourceBuffer::map_file(path);
+        if (!source) {
+            fmt::print(stderr, "Error: cannot open {}\n", path);
+            return 1;
+        }
+        corpora.push_back({path, std::move(*source)});
+    }
+
+    if (diff) {
+        return run_diff(corpora, programs) == 0 ? 0 : 1;
+    }
+
+    std::vector<std::string> results;
+    for (const auto& c : corpora) {
+        results.push_back(bench_lexer(c, min_time));
+        results.push_back(bench_lexer_parallel(c, min_time));
+        results.push_back(bench_lexer_intern(c, min_time));
+        for (ParserBackend backend : {ParserBackend::Bison, ParserBackend::Pratt}) {
+            results.push_back(bench_parser(c, min_time, backend));
+            results.push_back(bench_pipeline(c, min_time, backend));
+        }
+        results.push_back(bench_edit(c, min_time));
+        results.push_back(bench_ast_file(c, min_time));
+    }
+    if (filter.empty() || std::string_view("vm").find(filter) != std::string_view::npos) {
+        results.push_back(bench_vm("prime_loops", kPrimeProgram, 200000, min_time));
+        results.push_back(bench_vm("int_loop", kIntLoopProgram, 2000000, min_time));
+    }
+    if (filter.empty() || std::string_view("value_copy").find(filter) != std::string_view::npos) {
+        results.push_back(bench_value_copy("immediate", 1 << 16, 0, min_time));
+        results.push_back(bench_value_copy("mixed", 1 << 16, 4, min_time));
+    }
+
+    std::string json = fmt::format("{{\n  \"context\": {{\"simd\": \"{}\", \"size_mb\": {}, \"min_time\": {}}},\n",
+                                   simd::kernels().name, size_mb, min_time);
+    json += "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        json += results[i];
+        json += i + 1 < results.size() ? ",\n" : "\n";
+    }
+    json += "  ]\n}\n";
+
+    fmt::print("{}", json);
+    if (!out_path.empty()) {
+        std::ofstream(out_path, std::ios::binary) << json;
+    }
+    return 0;
+}
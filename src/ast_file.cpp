@@ -0,0 +1,163 @@
+#include "ast_file.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+
+namespace prim {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'R', 'I', 'M', 'A', 'S', 'T', '\0'};
+
+// 文件直接以内存中的节点记录为格式，布局变化必须同时提升 AstView::kVersion
+static_assert(offsetof(ASTNode, type) == 0 && offsetof(ASTNode, flags) == 1 &&
+              offsetof(ASTNode, token) == 4 && offsetof(ASTNode, first_child) == 8 &&
+              offsetof(ASTNode, child_count) == 12);
+static_assert(sizeof(ErrMsg) == sizeof(uint32_t));
+
+template <typename T>
+void append(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
+
+// ============================================================================
+// AstView 实现
+// ============================================================================
+
+std::optional<AstView> AstView::from_bytes(std::string_view bytes) {
+    if (bytes.size() < sizeof(AstFileHeader) ||
+        reinterpret_cast<uintptr_t>(bytes.data()) % alignof(ASTNode) != 0) {
+        return std::nullopt;
+    }
+    AstFileHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kVersion || header.byte_order != kAstFileByteOrder) {
+        return std::nullopt;
+    }
+    const uint64_t expected = sizeof(AstFileHeader) +
+                              uint64_t(header.node_count) * sizeof(ASTNode) +
+                              uint64_t(header.edge_count) * sizeof(NodeId) +
+                              uint64_t(header.token_count) * sizeof(AstFileToken) +
+                              header.string_bytes;
+    if (expected != bytes.size()) return std::nullopt;
+
+    AstView view;
+    const char* p = bytes.data() + sizeof(AstFileHeader);
+    view.nodes_  = reinterpret_cast<const ASTNode*>(p);
+    p += size_t(header.node_count) * sizeof(ASTNode);
+    view.edges_  = reinterpret_cast<const NodeId*>(p);
+    p += size_t(header.edge_count) * sizeof(NodeId);
+    view.tokens_ = reinterpret_cast<const AstFileToken*>(p);
+    p += size_t(header.token_count) * sizeof(AstFileToken);
+    view.strings_     = std::string_view(p, header.string_bytes);
+    view.node_count_  = header.node_count;
+    view.edge_count_  = header.edge_count;
+    view.token_count_ = header.token_count;
+    view.root_        = header.root;
+
+    // 校验一次，之后的访问无需检查
+    constexpr auto kLastType = static_cast<uint8_t>(ASTNode::NodeType::Program);
+    for (NodeId id = 0; id < view.node_count_; ++id) {
+        const ASTNode& node = view.nodes_[id];
+        if (static_cast<uint8_t>(node.type) > kLastType) return std::nullopt;
+        if (node.token != ASTNode::kNoToken && node.token >= view.token_count_) return std::nullopt;
+        if (node.first_child > view.edge_count_ ||
+            node.child_count > view.edge_count_ - node.first_child) {
+            return std::nullopt;
+        }
+        for (NodeId child : view.children(id)) {
+            if (child >= id) return std::nullopt;  // 子节点先于父节点创建，保证无环
+        }
+    }
+    for (uint32_t i = 0; i < view.token_count_; ++i) {
+        const AstFileToken& tok = view.tokens_[i];
+        if (tok.text > view.strings_.size() || tok.length > view.strings_.size() - tok.text) {
+            return std::nullopt;
+        }
+    }
+    if (view.root_ != kNoNode && view.root_ >= view.node_count_) return std::nullopt;
+    return view;
+}
+
+// ============================================================================
+// AstFile 实现
+// ============================================================================
+
+std::optional<AstFile> AstFile::open(const std::string& path) {
+    auto data = SourceBuffer::map_file(path);
+    if (!data) return std::nullopt;
+    auto view = AstView::from_bytes(data->view());
+    if (!view) return std::nullopt;
+
+    AstFile file;
+    file.data_ = std::move(*data);
+    file.view_ = *view;
+    return file;
+}
+
+// ============================================================================
+// 序列化
+// ============================================================================
+
+std::string serialize_ast(const Ast& ast) {
+    // token 按 token 下标（即节点顺序）收集，相同文本在字符串表中只存一份
+    std::vector<AstFileToken> tokens;
+    std::string strings;
+    std::unordered_map<std::string_view, uint32_t> interned;
+    for (NodeId id = 0; id < ast.size(); ++id) {
+        const Token* tok = ast.token(id);
+        if (!tok) continue;
+        const std::string_view text = tok->text();
+        auto [it, inserted] = interned.try_emplace(text, uint32_t(strings.size()));
+        if (inserted) strings += text;
+        // 符号编号只在本进程的 Interner 中有意义，不写入文件（载入后由调用方重新驻留）
+        const uint64_t value = tok->is_number() ? tok->value.u : 0;
+        tokens.push_back(AstFileToken{tok->begin, tok->length, tok->type, tok->err,
+                                      std::bit_cast<uint32_t>(tok->emsg), it->second,
+                                      uint32_t(value), uint32_t(value >> 32)});
+    }
+
+    AstFileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version      = AstView::kVersion;
+    header.byte_order   = kAstFileByteOrder;
+    header.node_count   = uint32_t(ast.size());
+    header.edge_count   = uint32_t(ast.edge_count());
+    header.token_count  = uint32_t(tokens.size());
+    header.string_bytes = uint32_t(strings.size());
+    header.root         = ast.root();
+
+    std::string out;
+    out.reserve(sizeof(header) + ast.size() * sizeof(ASTNode) + ast.edge_count() * sizeof(NodeId) +
+                tokens.size() * sizeof(AstFileToken) + strings.size());
+    append(out, header);
+    for (NodeId id = 0; id < ast.size(); ++id) {
+        // 逐字段复制，填充字节固定为 0
+        ASTNode node;
+        std::memset(static_cast<void*>(&node), 0, sizeof(node));
+        node.type        = ast[id].type;
+        node.flags       = ast[id].flags;
+        node.token       = ast[id].token;
+        node.first_child = ast[id].first_child;
+        node.child_count = ast[id].child_count;
+        append(out, node);
+    }
+    for (NodeId id = 0; id < ast.size(); ++id) {
+        for (NodeId child : ast.children(id)) append(out, child);
+    }
+    for (const AstFileToken& tok : tokens) {
+        append(out, tok);
+    }
+    out += strings;
+    return out;
+}
+
+bool write_ast_file(const std::string& path, const Ast& ast) {
+    return write_file_atomic(path, serialize_ast(ast));
+}
+
+} // namespace prim
@@ -0,0 +1,128 @@
+#include "batch.hpp"
+#include "cache.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "source.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <system_error>
+#include <thread>
+
+namespace prim {
+
+namespace {
+
+// ============================================================================
+// 工作队列：每个线程一段连续的文件下标
+// ============================================================================
+//
+// 所有者和窃取者都用 fetch_add 领取下一个下标，无锁；
+// 独占缓存行，避免各线程的游标互相伪共享
+
+struct alignas(64) WorkRange {
+    std::atomic<size_t> next{0};
+    size_t              end = 0;
+
+    // 领取一个下标，没有剩余时返回 false
+    bool take(size_t& index) {
+        if (next.load(std::memory_order_relaxed) >= end) return false;
+        index = next.fetch_add(1, std::memory_order_relaxed);
+        return index < end;
+    }
+};
+
+void check_one(Parser& parser, const ParseCache* cache, const std::string& path, FileReport& report) {
+    report.path = path;
+    auto source = SourceBuffer::map_file(path);
+    if (!source) return;
+    report.opened = true;
+    report.bytes = source->size();
+
+    if (cache) {
+        if (auto cached = cache->load(source->view(), parser.error_limit())) {
+            report.errors = std::move(cached->errors);
+            report.error_limit_reached = cached->error_limit_reached;
+            return;
+        }
+    }
+
+    Lexer lexer(*source);
+    parser.parse(lexer);
+    if (cache) cache->store(source->view(), parser.error_limit(), parser);
+    report.errors = parser.get_errors();
+    report.error_limit_reached = parser.error_limit_reached();
+}
+
+} // namespace
+
+// ============================================================================
+// 对外接口
+// ============================================================================
+
+std::vector<std::string> expand_inputs(const std::vector<std::string>& inputs) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> out;
+    for (const auto& input : inputs) {
+        std::error_code ec;
+        if (!fs::is_directory(input, ec)) {
+            out.push_back(input);
+            continue;
+        }
+
+        std::vector<std::string> found;
+        const auto options = fs::directory_options::skip_permission_denied;
+        for (fs::recursive_directory_iterator it(input, options, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_regular_file(ec) && it->path().extension() == ".prim") {
+                found.push_back(it->path().string());
+            }
+        }
+        std::sort(found.begin(), found.end());  // 目录遍历顺序与文件系统有关
+        out.insert(out.end(), found.begin(), found.end());
+    }
+    return out;
+}
+
+std::vector<FileReport> check_files(const std::vector<std::string>& paths,
+                                    size_t jobs, size_t max_errors, const ParseCache* cache) {
+    std::vector<FileReport> reports(paths.size());
+    if (paths.empty()) return reports;
+
+    if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::min(jobs, paths.size());
+
+    // 连续均分：同一目录下的文件大多落在同一个线程
+    auto ranges = std::make_unique<WorkRange[]>(jobs);
+    for (size_t w = 0; w < jobs; ++w) {
+        ranges[w].next.store(paths.size() * w / jobs, std::memory_order_relaxed);
+        ranges[w].end = paths.size() * (w + 1) / jobs;
+    }
+
+    auto worker = [&](size_t self) {
+        Parser parser;  // 每个线程一个，存储在文件之间复用
+        parser.set_error_limit(max_errors);
+        size_t index = 0;
+        for (size_t k = 0; k < jobs; ++k) {
+            // 先做自己的部分，之后依次从其他线程窃取
+            WorkRange& range = ranges[(self + k) % jobs];
+            while (range.take(index)) {
+                check_one(parser, cache, paths[index], reports[index]);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(jobs - 1);
+    for (size_t w = 1; w < jobs; ++w) {
+        threads.emplace_back(worker, w);
+    }
+    worker(0);  // 当前线程也参与
+    for (auto& t : threads) {
+        t.join();
+    }
+    return reports;
+}
+
+} // namespace prim
@@ -0,0 +1,164 @@
+#include "bytecode.hpp"
+
+#include <fmt/format.h>
+#include <iterator>
+
+namespace prim {
+
+const char* op_name(Op op) {
+    switch (op) {
+        case Op::Move:      return "Move";
+        case Op::LoadK:     return "LoadK";
+        case Op::LoadInt:   return "LoadInt";
+        case Op::LoadNull:  return "LoadNull";
+        case Op::LoadTrue:  return "LoadTrue";
+        case Op::LoadFalse: return "LoadFalse";
+        case Op::LoadUnit:  return "LoadUnit";
+        case Op::MakePrim:  return "MakePrim";
+        case Op::GetGlobal: return "GetGlobal";
+        case Op::SetGlobal: return "SetGlobal";
+        case Op::DelGlobal: return "DelGlobal";
+        case Op::Add:       return "Add";
+        case Op::Sub:       return "Sub";
+        case Op::Mul:       return "Mul";
+        case Op::Div:       return "Div";
+        case Op::Mod:       return "Mod";
+        case Op::Eq:        return "Eq";
+        case Op::Ne:        return "Ne";
+        case Op::Lt:        return "Lt";
+        case Op::Le:        return "Le";
+        case Op::Not:       return "Not";
+        case Op::Neg:       return "Neg";
+        case Op::Pos:       return "Pos";
+        case Op::Jump:      return "Jump";
+        case Op::JumpIf:    return "JumpIf";
+        case Op::JumpIfNot: return "JumpIfNot";
+        case Op::NewList:   return "NewList";
+        case Op::NewTuple:  return "NewTuple";
+        case Op::NewDict:   return "NewDict";
+        case Op::Index:     return "Index";
+        case Op::SetIndex:  return "SetIndex";
+        case Op::Slice:     return "Slice";
+        case Op::GetField:  return "GetField";
+        case Op::SetField:  return "SetField";
+        case Op::Call:      return "Call";
+        case Op::Invoke:    return "Invoke";
+        case Op::Return:    return "Return";
+    }
+    return "?";
+}
+
+// ============================================================================
+// 反汇编
+// ============================================================================
+
+namespace {
+
+std::string constant_text(const Constant& k) {
+    switch (k.kind) {
+        case Constant::Kind::Int:    return fmt::format("{}", k.i);
+        case Constant::Kind::Float:  return fmt::format("{}", k.f);
+        case Constant::Kind::String: return fmt::format("{:?}", k.s);
+    }
+    return {};
+}
+
+// 一条指令的操作数和注释（常量、全局变量名、跳转目标）
+void format_instr(std::string& out, const Module& module, const PrimCode& prim, size_t pc) {
+    const Instr& in = prim.code[pc];
+    const auto K = [&](uint16_t i) { return i < prim.constants.size() ? constant_text(prim.constants[i]) : "?"; };
+    const auto G = [&](uint16_t i) { return i < module.globals.size() ? module.globals[i] : std::string("?"); };
+    const auto target = [&] { return int64_t(pc) + 1 + in.sbc(); };
+
+    std::string operands;
+    std::string note;
+    switch (in.op) {
+        case Op::LoadNull: case Op::LoadTrue: case Op::LoadFalse: case Op::LoadUnit: case Op::Return:
+            operands = fmt::format("r{}", in.a);
+            break;
+        case Op::Move: case Op::Not: case Op::Neg: case Op::Pos:
+            operands = fmt::format("r{}, r{}", in.a, in.b);
+            break;
+        case Op::LoadK:
+            operands = fmt::format("r{}, K{}", in.a, in.b);
+            note = K(in.b);
+            break;
+        case Op::LoadInt:
+            operands = fmt::format("r{}, {}", in.a, in.sbc());
+            break;
+        case Op::MakePrim:
+            operands = fmt::format("r{}, P{}", in.a, in.b);
+            if (in.b < module.prims.size()) note = module.prims[in.b].name;
+            break;
+        case Op::GetGlobal: case Op::SetGlobal:
+            operands = fmt::format("r{}, G{}", in.a, in.b);
+            note = G(in.b);
+            break;
+        case Op::DelGlobal:
+            operands = fmt::format("G{}", in.b);
+            note = G(in.b);
+            break;
+        case Op::Add: case Op::Sub: case Op::Mul: case Op::Div: case Op::Mod:
+        case Op::Eq: case Op::Ne: case Op::Lt: case Op::Le:
+        case Op::Index: case Op::SetIndex: case Op::Slice:
+            operands = fmt::format("r{}, r{}, r{}", in.a, in.b, in.c);
+            break;
+        case Op::Jump:
+            operands = fmt::format("-> {:04}", target());
+            break;
+        case Op::JumpIf: case Op::JumpIfNot:
+            operands = fmt::format("r{}, -> {:04}", in.a, target());
+            break;
+        case Op::NewList: case Op::NewTuple: case Op::NewDict:
+            operands = fmt::format("r{}, r{}, {}", in.a, in.b, in.c);
+            break;
+        case Op::GetField:
+            operands = fmt::format("r{}, r{}, K{}", in.a, in.b, in.c);
+            note = K(in.c);
+            break;
+        case Op::SetField:
+            operands = fmt::format("r{}, K{}, r{}", in.a, in.b, in.c);
+            note = K(in.b);
+            break;
+        case Op::Call:
+            operands = fmt::format("r{}, {}", in.a, in.b);
+            break;
+        case Op::Invoke:
+            operands = fmt::format("r{}, {}, K{}", in.a, in.b, in.c);
+            note = K(in.c);
+            break;
+    }
+
+    fmt::format_to(std::back_inserter(out), "  {:04}  {:<10} {:<16}", pc, op_name(in.op), operands);
+    if (!note.empty()) fmt::format_to(std::back_inserter(out), " ; {}", note);
+}
+
+} // namespace
+
+std::string disassemble(const Module& module, const LineIndex* lines) {
+    std::string out;
+    for (size_t p = 0; p < module.prims.size(); ++p) {
+        const PrimCode& prim = module.prims[p];
+        if (p) out += '\n';
+        fmt::format_to(std::back_inserter(out), "prim P{} {} (params {}, registers {}{})\n",
+                       p, prim.name, prim.params, prim.registers,
+                       prim.closure_space ? ", closure space" : "");
+        for (size_t i = 0; i < prim.constants.size(); ++i) {
+            fmt::format_to(std::back_inserter(out), "  K{:<4} {}\n", i, constant_text(prim.constants[i]));
+        }
+        for (size_t pc = 0; pc < prim.code.size(); ++pc) {
+            const size_t line_start = out.size();
+            format_instr(out, module, prim, pc);
+            if (lines) {
+                const Location loc = lines->locate(prim.offsets[pc]);
+                const size_t width = out.size() - line_start;
+                if (width < 48) out.append(48 - width, ' ');
+                fmt::format_to(std::back_inserter(out), "  @{}:{}", loc.line, loc.col);
+            }
+            out += '\n';
+        }
+    }
+    return out;
+}
+
+} // namespace prim
@@ -0,0 +1,206 @@
+#include "cache.hpp"
+#include "ast_file.hpp"
+#include "hash.hpp"
+#include "parser.hpp"
+#include "source.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <system_error>
+
+#include <fmt/format.h>
+
+// 由 CMake 根据 parser.y 和 lexer.re 的内容生成，语法改动后缓存键随之改变
+#ifndef PRIM_GRAMMAR_FINGERPRINT
+#define PRIM_GRAMMAR_FINGERPRINT "dev"
+#endif
+
+namespace prim {
+
+namespace {
+
+// ============================================================================
+// 条目文件格式（本机字节序）
+// ============================================================================
+//
+//   Header                     校验和覆盖其后的所有字节
+//   AST 文件（ast_file.hpp）   ast_size 字节，紧跟 64 字节的头部，保持对齐
+//   错误 × error_count         ErrorRecord 后接 message 与 context 的字节
+
+constexpr char kMagic[8] = {'P', 'R', 'I', 'M', 'C', 'A', 'C', 'H'};
+
+struct Header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t flags;        // kFlagErrorLimitReached
+    uint64_t fingerprint;  // grammar_fingerprint()
+    uint64_t source_size;
+    uint64_t ast_size;
+    uint32_t error_count;
+    uint32_t reserved[3];
+    uint64_t checksum;     // Header 之后全部字节的 XXH64，发现截断或损坏的条目
+};
+
+struct ErrorRecord {
+    uint32_t type;
+    uint32_t offset;
+    uint32_t message_size;
+    uint32_t context_size;
+};
+
+constexpr uint32_t kFlagErrorLimitReached = 1u << 0;
+
+static_assert(sizeof(Header) == 64);
+static_assert(sizeof(ErrorRecord) == 16);
+
+// 语法、缓存格式和内存布局的指纹：任何一项变化都使旧条目失效
+uint64_t grammar_fingerprint() {
+    static const uint64_t fingerprint = [] {
+        const std::string id = fmt::format("{}/v{}/ast{}/node{}/token{}", PRIM_GRAMMAR_FINGERPRINT,
+                                           ParseCache::kFormatVersion, AstView::kVersion,
+                                           sizeof(ASTNode), sizeof(Token));
+        return xxh64(id);
+    }();
+    return fingerprint;
+}
+
+template <typename T>
+void append(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// 由序列化的 AST 重建 Ast：按原顺序重放 Ast::add，节点 id、边下标和 token 下标都与解析时相同；
+// token 词素指回 source，文本不一致（源码对不上）时返回 false
+bool rebuild_ast(const AstView& view, std::string_view source, ParseResult& result) {
+    result.tokens.resize(view.token_count());  // 之后不再扩容，AST 中的指针保持有效
+    for (NodeId id = 0; id < view.size(); ++id) {
+        const AstFileToken* tok = view.token(id);
+        if (!tok) continue;
+        if (tok->begin > source.size() || tok->length > source.size() - tok->begin ||
+            source.substr(tok->begin, tok->length) != view.text(*tok)) {
+            return false;
+        }
+        Token& out = result.tokens[view[id].token];
+        out.lexeme = source.data() + tok->begin;
+        out.begin  = tok->begin;
+        out.length = tok->length;
+        out.type   = tok->type;
+        out.err    = tok->err;
+        out.emsg   = tok->err_msg();
+        out.value  = tok->value();
+    }
+
+    result.ast.reserve(view.size());
+    for (NodeId id = 0; id < view.size(); ++id) {
+        const ASTNode& node = view[id];
+        const Token* tok = node.token == ASTNode::kNoToken ? nullptr : &result.tokens[node.token];
+        result.ast.add(node.type, tok, view.children(id), node.flags);
+    }
+    result.ast.set_root(view.root());
+    return true;
+}
+
+std::optional<ParseResult> decode(std::string_view data, std::string_view source) {
+    Header header;
+    if (data.size() < sizeof(Header)) return std::nullopt;
+    std::memcpy(&header, data.data(), sizeof(Header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != ParseCache::kFormatVersion ||
+        header.fingerprint != grammar_fingerprint() ||
+        header.source_size != source.size() ||
+        header.ast_size > data.size() - sizeof(Header) ||
+        header.checksum != xxh64(data.substr(sizeof(Header)))) {
+        return std::nullopt;
+    }
+
+    auto view = AstView::from_bytes(data.substr(sizeof(Header), header.ast_size));
+    if (!view) return std::nullopt;
+    ParseResult result;
+    result.error_limit_reached = (header.flags & kFlagErrorLimitReached) != 0;
+    if (!rebuild_ast(*view, source, result)) return std::nullopt;
+
+    // 错误
+    constexpr auto kLastError = static_cast<uint32_t>(ParseErrorType::InvalidDelTarget);
+    std::string_view rest = data.substr(sizeof(Header) + header.ast_size);
+    if (rest.size() / sizeof(ErrorRecord) < header.error_count) return std::nullopt;
+    result.errors.reserve(header.error_count);
+    for (uint32_t i = 0; i < header.error_count; ++i) {
+        ErrorRecord rec;
+        if (rest.size() < sizeof(rec)) return std::nullopt;
+        std::memcpy(&rec, rest.data(), sizeof(rec));
+        rest.remove_prefix(sizeof(rec));
+        if (rec.type > kLastError || rest.size() < uint64_t(rec.message_size) + rec.context_size) {
+            return std::nullopt;
+        }
+        result.errors.emplace_back(static_cast<ParseErrorType>(rec.type), rec.offset,
+                                   std::string(rest.substr(0, rec.message_size)),
+                                   std::string(rest.substr(rec.message_size, rec.context_size)));
+        rest.remove_prefix(rec.message_size + rec.context_size);
+    }
+    if (!rest.empty()) return std::nullopt;
+    return result;
+}
+
+std::string encode(std::string_view source, const Parser& parser) {
+    const auto& errors = parser.get_errors();
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version     = ParseCache::kFormatVersion;
+    header.flags       = parser.error_limit_reached() ? kFlagErrorLimitReached : 0;
+    header.fingerprint = grammar_fingerprint();
+    header.source_size = source.size();
+    header.error_count = static_cast<uint32_t>(errors.size());
+
+    std::string out(sizeof(Header), '\0');
+    out += serialize_ast(parser.ast());
+    header.ast_size = out.size() - sizeof(Header);
+    for (const auto& e : errors) {
+        const ErrorRecord rec{static_cast<uint32_t>(e.type), e.offset,
+                              static_cast<uint32_t>(e.message.size()),
+                              static_cast<uint32_t>(e.context.size())};
+        append(out, rec);
+        out += e.message;
+        out += e.context;
+    }
+    header.checksum = xxh64(std::string_view(out).substr(sizeof(Header)));
+    std::memcpy(out.data(), &header, sizeof(Header));
+    return out;
+}
+
+} // namespace
+
+// ============================================================================
+// ParseCache 实现
+// ============================================================================
+
+std::filesystem::path ParseCache::default_dir() {
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return std::filesystem::path(xdg) / "prim";
+    }
+    if (const char* home = std::getenv("HOME"); home && *home) {
+        return std::filesystem::path(home) / ".cache" / "prim";
+    }
+    return {};
+}
+
+std::filesystem::path ParseCache::entry_path(std::string_view source, size_t error_limit) const {
+    // 第二个哈希的种子混入指纹与错误数上限：相同源码在不同语法或上限下是不同的条目
+    const uint64_t seed = grammar_fingerprint() ^ (uint64_t(error_limit) * detail::kXxhPrime2);
+    return dir_ / fmt::format("{:016x}{:016x}.ast", xxh64(source, 0), xxh64(source, seed));
+}
+
+std::optional<ParseResult> ParseCache::load(std::string_view source, size_t error_limit) const {
+    auto entry = SourceBuffer::map_file(entry_path(source, error_limit).string());
+    if (!entry) return std::nullopt;
+    return decode(entry->view(), source);
+}
+
+bool ParseCache::store(std::string_view source, size_t error_limit, const Parser& parser) const {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) return false;
+    return write_file_atomic(entry_path(source, error_limit).string(), encode(source, parser));
+}
+
+} // namespace prim
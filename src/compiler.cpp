@@ -0,0 +1,1106 @@
+#include "compiler.hpp"
+#include "string_literal.hpp"
+
+#include <bit>
+#include <fmt/format.h>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace prim {
+
+namespace {
+
+using NodeType = ASTNode::NodeType;
+
+inline constexpr uint16_t kNoReg   = UINT16_MAX;      // 丢弃值（只求副作用）
+inline constexpr uint32_t kMaxSlot = UINT16_MAX - 1;  // 寄存器、常量、全局变量、prim 的下标上限
+
+// ============================================================================
+// 编译期状态
+// ============================================================================
+
+// 变量绑定：寄存器或全局变量
+struct Binding {
+    std::string_view name;    // del 之后置空，不再匹配
+    uint16_t         index;
+    bool             global;
+    bool             alias = false;  // let x = &y / let &x;：不拥有存储，del 只解除绑定
+};
+
+// 正在编译的 loop（break 的目标）
+struct LoopTarget {
+    std::string_view    label;   // 含反引号的原文，无标签为空
+    uint16_t            dest;    // 结果寄存器，kNoReg 表示值被丢弃
+    std::vector<size_t> breaks;  // 待回填的 Jump
+};
+
+// 正在编译的 prim
+struct PrimState {
+    PrimState*              enclosing = nullptr;
+    PrimCode                code;
+    std::vector<Binding>    bindings;
+    std::vector<LoopTarget> loops;
+    size_t                  loop_floor = 0;  // 下标小于它的 loop 在 prim / scope 之外，break 不能跨越
+    size_t                  scope_floor = 0; // 下标小于它的局部绑定在 scope 之外，需用 let x; / let &x; 导入
+    uint16_t                top   = 0;       // 第一个空闲寄存器
+    int                     depth = 0;       // 块嵌套深度，<main> 的第 0 层是全局作用域
+    bool                    is_main = false;
+    std::string_view        self;            // 局部命名 prim 的名字：函数体内指向它自身（prim 不捕获，MakePrim 即可）
+    uint16_t                self_index = 0;
+
+    std::unordered_map<int64_t, uint16_t>     int_constants;
+    std::unordered_map<uint64_t, uint16_t>    float_constants;  // 按位模式去重（区分 0.0 和 -0.0）
+    std::unordered_map<std::string, uint16_t> string_constants;
+};
+
+// 变量解析结果
+struct Resolved {
+    enum Kind : uint8_t {
+        Local,
+        Global,
+        Outer,   // 外层 prim 的局部变量（不支持捕获）
+        Hidden,  // 当前 prim 中 scope 之外的局部变量，未导入
+        Self,    // 局部命名 prim 自身，index 是 prims 下标
+    } kind;
+    uint16_t index;
+};
+
+// 作用域开始时的状态
+struct ScopeMark {
+    size_t   bindings;
+    uint16_t top;
+};
+
+// ============================================================================
+// Compiler
+// ============================================================================
+
+class Compiler {
+public:
+    Compiler(const Ast& ast, std::vector<CompileError>& errors) : ast_(ast), errors_(errors) {}
+
+    std::optional<Module> run();
+
+private:
+    // ===== 节点 =====
+    [[nodiscard]] NodeType type(NodeId id) const { return ast_[id].type; }
+    [[nodiscard]] std::span<const NodeId> children(NodeId id) const { return ast_.children(id); }
+    [[nodiscard]] std::string_view text(NodeId id) const {
+        const Token* tok = ast_.token(id);
+        return tok ? tok->text() : std::string_view{};
+    }
+    [[nodiscard]] uint32_t offset_of(NodeId id) const;
+
+    void error(NodeId id, std::string message) {
+        errors_.push_back({offset_of(id), std::move(message)});
+    }
+
+    // ===== 指令 =====
+    [[nodiscard]] size_t pc() const { return fs_->code.code.size(); }
+    size_t emit(Op op, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0);
+    size_t emit_jump(Op op, uint16_t a = 0) { return emit(op, a); }
+    void patch(size_t at) { fs_->code.code[at].set_sbc(int32_t(pc() - at - 1)); }
+    void jump_back(size_t target) { emit_jump(Op::Jump); patch_to(pc() - 1, target); }
+    void patch_to(size_t at, size_t target) {
+        fs_->code.code[at].set_sbc(int32_t(int64_t(target) - int64_t(at) - 1));
+    }
+
+    uint16_t add_constant(Constant k);
+    uint16_t int_constant(int64_t v);
+    uint16_t float_constant(double v);
+    uint16_t string_constant(std::string s);
+    void load_int(uint16_t dest, int64_t v);
+
+    // ===== 寄存器和作用域 =====
+    uint16_t alloc();
+    ScopeMark enter_scope() { ++fs_->depth; return {fs_->bindings.size(), fs_->top}; }
+    void leave_scope(ScopeMark mark) {
+        fs_->bindings.resize(mark.bindings);
+        fs_->top = mark.top;
+        --fs_->depth;
+    }
+    [[nodiscard]] bool global_level() const { return fs_->is_main && fs_->depth == 0; }
+
+    uint16_t global_index(std::string_view name);
+    Resolved resolve(std::string_view name, bool import = false);
+    bool check_visible(NodeId id, std::string_view name, Resolved r);
+    void bind(std::string_view name, uint16_t index, bool global, bool alias = false) {
+        fs_->bindings.push_back({name, index, global, alias});
+    }
+
+    // ===== 语句 =====
+    void stmt(NodeId id);
+    void stmts(NodeId block, uint16_t dest);
+    void let_stmt(NodeId id);
+    void let_import(NodeId target);
+    void let_single(NodeId target, NodeId rhs);
+    void del_stmt(NodeId id);
+    void break_stmt(NodeId id);
+    void return_stmt(NodeId id);
+
+    // ===== 表达式 =====
+    void expr(NodeId id, uint16_t dest);
+    uint16_t operand(NodeId id);
+    void effect(NodeId id);
+
+    void literal(NodeId id, uint16_t dest);
+    void identifier(NodeId id, uint16_t dest);
+    void binary(NodeId id, uint16_t dest);
+    void unary(NodeId id, uint16_t dest);
+    void assign(NodeId id, uint16_t dest);
+    void logical(NodeId id, uint16_t dest, bool is_and);
+    void call(NodeId id, uint16_t dest);
+    void container(NodeId id, uint16_t dest, Op op);
+    void dict(NodeId id, uint16_t dest);
+    void block(NodeId id, uint16_t dest);
+    void if_expr(NodeId id, uint16_t dest);
+    void loop_expr(NodeId id, uint16_t dest);
+    void unnamed_prim(NodeId id, uint16_t dest);
+    void named_prim(NodeId id, uint16_t dest, bool is_stmt);
+    uint16_t compile_prim(NodeId id, bool closure_space);
+    void closure_space(size_t first_binding, uint16_t dest);
+
+    const Ast&                 ast_;
+    std::vector<CompileError>& errors_;
+    Module                     module_;
+    PrimState*                 fs_ = nullptr;
+    uint32_t                   offset_ = 0;  // 当前节点的源码偏移（写入 PrimCode::offsets）
+    std::unordered_map<std::string_view, uint16_t> globals_;
+    bool                       overflow_ = false;  // 已报告过下标溢出
+};
+
+// 当前节点的源码偏移：没有 token 的节点（调用、下标、容器等）取最左侧后代的 token
+uint32_t Compiler::offset_of(NodeId id) const {
+    for (;;) {
+        if (const Token* tok = ast_.token(id)) return tok->begin;
+        const auto kids = ast_.children(id);
+        if (kids.empty()) return offset_;
+        id = kids.front();
+    }
+}
+
+size_t Compiler::emit(Op op, uint16_t a, uint16_t b, uint16_t c) {
+    fs_->code.code.push_back({op, 0, a, b, c});
+    fs_->code.offsets.push_back(offset_);
+    return fs_->code.code.size() - 1;
+}
+
+// ============================================================================
+// 常量池、寄存器、变量
+// ============================================================================
+
+uint16_t Compiler::add_constant(Constant k) {
+    auto& pool = fs_->code.constants;
+    if (pool.size() > kMaxSlot) {
+        if (!overflow_) errors_.push_back({offset_, fmt::format("too many constants in prim '{}'", fs_->code.name)});
+        overflow_ = true;
+        return 0;
+    }
+    pool.push_back(std::move(k));
+    return uint16_t(pool.size() - 1);
+}
+
+uint16_t Compiler::int_constant(int64_t v) {
+    auto [it, inserted] = fs_->int_constants.try_emplace(v, 0);
+    if (inserted) {
+        Constant k;
+        k.kind = Constant::Kind::Int;
+        k.i = v;
+        it->second = add_constant(std::move(k));
+    }
+    return it->second;
+}
+
+uint16_t Compiler::float_constant(double v) {
+    auto [it, inserted] = fs_->float_constants.try_emplace(std::bit_cast<uint64_t>(v), 0);
+    if (inserted) {
+        Constant k;
+        k.kind = Constant::Kind::Float;
+        k.f = v;
+        it->second = add_constant(std::move(k));
+    }
+    return it->second;
+}
+
+uint16_t Compiler::string_constant(std::string s) {
+    auto it = fs_->string_constants.find(s);
+    if (it != fs_->string_constants.end()) return it->second;
+    Constant k;
+    k.kind = Constant::Kind::String;
+    k.s = s;
+    const uint16_t index = add_constant(std::move(k));
+    fs_->string_constants.emplace(std::move(s), index);
+    return index;
+}
+
+void Compiler::load_int(uint16_t dest, int64_t v) {
+    if (v >= INT32_MIN && v <= INT32_MAX) {
+        const size_t at = emit(Op::LoadInt, dest);
+        fs_->code.code[at].set_sbc(int32_t(v));
+    } else {
+        emit(Op::LoadK, dest, int_constant(v));
+    }
+}
+
+uint16_t Compiler::alloc() {
+    if (fs_->top >= kMaxSlot) {
+        if (!overflow_) errors_.push_back({offset_, fmt::format("prim '{}' needs too many registers", fs_->code.name)});
+        overflow_ = true;
+        return fs_->top;
+    }
+    const uint16_t reg = fs_->top++;
+    if (fs_->top > fs_->code.registers) fs_->code.registers = fs_->top;
+    return reg;
+}
+
+uint16_t Compiler::global_index(std::string_view name) {
+    auto [it, inserted] = globals_.try_emplace(name, uint16_t(0));
+    if (inserted) {
+        if (module_.globals.size() > kMaxSlot) {
+            if (!overflow_) errors_.push_back({offset_, "too many global variables"});
+            overflow_ = true;
+        } else {
+            module_.globals.emplace_back(name);
+        }
+        it->second = uint16_t(module_.globals.size() - 1);
+    }
+    return it->second;
+}
+
+// 由内向外查找：当前 prim 的绑定、外层 prim 的绑定（只能是全局变量），最后是全局变量。
+// scope 之外的局部变量只有 let x; / let &x; 导入时（import）可见；局部命名 prim 的名字在它自身的函数体内可见
+Resolved Compiler::resolve(std::string_view name, bool import) {
+    const auto& bindings = fs_->bindings;
+    for (size_t i = bindings.size(); i-- > 0;) {
+        const Binding& b = bindings[i];
+        if (b.name != name) continue;
+        if (b.global) return {Resolved::Global, b.index};
+        if (i < fs_->scope_floor && !import) return {Resolved::Hidden, 0};
+        return {Resolved::Local, b.index};
+    }
+    if (fs_->self == name) return {Resolved::Self, fs_->self_index};
+    for (PrimState* outer = fs_->enclosing; outer; outer = outer->enclosing) {
+        for (auto it = outer->bindings.rbegin(); it != outer->bindings.rend(); ++it) {
+            if (it->name != name) continue;
+            if (it->global) return {Resolved::Global, it->index};
+            return {Resolved::Outer, 0};
+        }
+        if (outer->self == name) return {Resolved::Self, outer->self_index};
+    }
+    return {Resolved::Global, global_index(name)};
+}
+
+// 外层 prim 的局部变量和 scope 之外未导入的局部变量不可访问，报告错误
+bool Compiler::check_visible(NodeId id, std::string_view name, Resolved r) {
+    if (r.kind == Resolved::Outer) {
+        error(id, fmt::format("cannot capture '{}' from an enclosing prim", name));
+        return false;
+    }
+    if (r.kind == Resolved::Hidden) {
+        error(id, fmt::format("'{0}' is defined outside this scope; import it with 'let {0};' or 'let &{0};'", name));
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// 入口
+// ============================================================================
+
+std::optional<Module> Compiler::run() {
+    const size_t first_error = errors_.size();
+
+    PrimState main;
+    main.code.name = "<main>";
+    main.is_main = true;
+    fs_ = &main;
+    module_.prims.emplace_back();
+
+    // Program: [StmtList]，最后一条表达式语句的值是程序的值
+    const NodeId root = ast_.root();
+    const auto list = root != kNoNode ? children(root) : std::span<const NodeId>{};
+    const uint16_t result = alloc();
+    bool has_value = false;
+    if (!list.empty()) {
+        const auto items = children(list[0]);
+        for (size_t i = 0; i < items.size(); ++i) {
+            const NodeId s = items[i];
+            if (i + 1 == items.size() && type(s) == NodeType::ExprStmt) {
+                offset_ = offset_of(s);
+                expr(children(s)[0], result);
+                has_value = true;
+            } else {
+                stmt(s);
+            }
+        }
+    }
+    if (!has_value) emit(Op::LoadUnit, result);
+    emit(Op::Return, result);
+
+    module_.prims[0] = std::move(main.code);
+    fs_ = nullptr;
+    if (errors_.size() != first_error) return std::nullopt;
+    return std::move(module_);
+}
+
+// ============================================================================
+// 语句
+// ============================================================================
+
+void Compiler::stmt(NodeId id) {
+    offset_ = offset_of(id);
+    switch (type(id)) {
+        case NodeType::LetStmt:    let_stmt(id); break;
+        case NodeType::DelStmt:    del_stmt(id); break;
+        case NodeType::BreakStmt:  break_stmt(id); break;
+        case NodeType::ReturnStmt: return_stmt(id); break;
+        case NodeType::ExprStmt:   effect(children(id)[0]); break;
+        default:
+            error(id, "unexpected node in statement list");
+            break;
+    }
+}
+
+// 语句列表（不开新作用域），kUseTail 时最后一条表达式语句的值写入 dest
+void Compiler::stmts(NodeId block, uint16_t dest) {
+    const auto items = children(block);
+    const bool tail = ast_[block].use_tail() && !items.empty() && type(items.back()) == NodeType::ExprStmt;
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (tail && i + 1 == items.size()) {
+            offset_ = offset_of(items[i]);
+            if (dest == kNoReg) effect(children(items[i])[0]);
+            else                expr(children(items[i])[0], dest);
+        } else {
+            stmt(items[i]);
+        }
+    }
+    if (!tail && dest != kNoReg) emit(Op::LoadUnit, dest);
+}
+
+void Compiler::let_stmt(NodeId id) {
+    const auto kids = children(id);
+    const auto targets = children(kids[0]);
+
+    if (ast_[id].is_import()) {
+        for (NodeId target : targets) let_import(target);
+        return;
+    }
+
+    const NodeId rhs = kids[1];
+    if (targets.size() == 1) {
+        let_single(targets[0], rhs);
+        return;
+    }
+
+    // let a, b = expr：右侧的值留在一个临时寄存器中，按下标逐个取出
+    if (type(rhs) == NodeType::RefExpr) {
+        error(rhs, "cannot destructure a reference");
+        return;
+    }
+    const uint16_t mark = fs_->top;
+    const uint16_t value = alloc();
+    expr(rhs, value);
+    const uint16_t key = alloc();
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const NodeId target = targets[i];
+        if (ast_[target].is_ref()) {
+            error(target, "'&' targets are only supported in 'let &x;' imports");
+            continue;
+        }
+        load_int(key, int64_t(i));
+        if (global_level()) {
+            const uint16_t g = global_index(text(target));
+            const uint16_t tmp = alloc();
+            emit(Op::Index, tmp, value, key);
+            emit(Op::SetGlobal, tmp, g);
+            fs_->top = tmp;
+            bind(text(target), g, true);
+        } else {
+            const uint16_t reg = alloc();
+            emit(Op::Index, reg, value, key);
+            bind(text(target), reg, false);
+        }
+    }
+    // 全局变量已全部写入，value 与 key 不再使用（局部变量的寄存器位于其上，留到作用域结束）
+    if (global_level()) fs_->top = mark;
+}
+
+void Compiler::let_single(NodeId target, NodeId rhs) {
+    const std::string_view name = text(target);
+    if (ast_[target].is_ref()) {
+        error(target, "'&' targets are only supported in 'let &x;' imports");
+        return;
+    }
+
+    // let x = &y：x 直接绑定到 y 的存储
+    if (type(rhs) == NodeType::RefExpr) {
+        const NodeId inner = children(rhs)[0];
+        if (type(inner) != NodeType::Identifier) {
+            error(inner, "only variables can be referenced");
+            return;
+        }
+        const Resolved r = resolve(text(inner));
+        if (!check_visible(inner, text(inner), r)) return;
+        if (r.kind == Resolved::Self) {
+            // prim 值不可变，引用它等同于拷贝
+            const uint16_t reg = alloc();
+            emit(Op::MakePrim, reg, r.index);
+            bind(name, reg, false);
+            return;
+        }
+        bind(name, r.index, r.kind == Resolved::Global, true);
+        return;
+    }
+
+    if (global_level()) {
+        const uint16_t g = global_index(name);
+        const uint16_t mark = fs_->top;
+        emit(Op::SetGlobal, operand(rhs), g);
+        fs_->top = mark;
+        bind(name, g, true);
+    } else {
+        // 先求值再绑定：右侧的同名变量仍是外层的
+        const uint16_t reg = alloc();
+        expr(rhs, reg);
+        bind(name, reg, false);
+    }
+}
+
+// let x; / let &x;：从外层作用域导入（复制或引用）
+void Compiler::let_import(NodeId target) {
+    if (global_level()) return;  // 顶层的名字本来就是全局变量
+
+    const std::string_view name = text(target);
+    const Resolved r = resolve(name, true);
+    if (!check_visible(target, name, r)) return;
+    if (r.kind == Resolved::Self) {
+        const uint16_t reg = alloc();
+        emit(Op::MakePrim, reg, r.index);
+        bind(name, reg, false);
+        return;
+    }
+    if (ast_[target].is_ref()) {
+        bind(name, r.index, r.kind == Resolved::Global, true);
+        return;
+    }
+    const uint16_t reg = alloc();
+    if (r.kind == Resolved::Global) emit(Op::GetGlobal, reg, r.index);
+    else                            emit(Op::Move, reg, r.index);
+    bind(name, reg, false);
+}
+
+void Compiler::del_stmt(NodeId id) {
+    for (NodeId ident : children(children(id)[0])) {
+        const std::string_view name = text(ident);
+        auto it = fs_->bindings.rbegin();
+        while (it != fs_->bindings.rend() && it->name != name) ++it;
+
+        if (it == fs_->bindings.rend()) {
+            const Resolved r = resolve(name);
+            if (r.kind == Resolved::Outer)     error(ident, fmt::format("cannot delete '{}' of an enclosing prim", name));
+            else if (r.kind == Resolved::Self) error(ident, fmt::format("cannot delete prim '{}' inside its own body", name));
+            else                               emit(Op::DelGlobal, 0, r.index);
+            continue;
+        }
+        if (!it->global && size_t(fs_->bindings.rend() - it) <= fs_->scope_floor) {
+            check_visible(ident, name, {Resolved::Hidden, 0});
+            continue;
+        }
+        // 引用只解除绑定；局部变量立即释放值
+        if (!it->alias) {
+            if (it->global) emit(Op::DelGlobal, 0, it->index);
+            else            emit(Op::LoadUnit, it->index);
+        }
+        it->name = {};
+    }
+}
+
+void Compiler::break_stmt(NodeId id) {
+    const std::string_view label = text(id);
+    auto& loops = fs_->loops;
+
+    size_t target = loops.size();
+    if (label.empty()) {
+        if (loops.size() > fs_->loop_floor) target = loops.size() - 1;
+    } else {
+        for (size_t i = loops.size(); i-- > 0;) {
+            if (loops[i].label == label) { target = i; break; }
+        }
+    }
+    if (target == loops.size() || target < fs_->loop_floor) {
+        if (target != loops.size())  error(id, fmt::format("cannot break to {} across a prim or scope", label));
+        else if (!label.empty())     error(id, fmt::format("unknown loop label {}", label));
+        else                         error(id, "'break' outside of a loop");
+        return;
+    }
+
+    const auto kids = children(id);
+    const uint16_t dest = loops[target].dest;
+    if (!kids.empty()) {
+        if (dest == kNoReg) effect(kids[0]);
+        else                expr(kids[0], dest);
+    } else if (dest != kNoReg) {
+        emit(Op::LoadUnit, dest);
+    }
+    loops[target].breaks.push_back(emit_jump(Op::Jump));
+}
+
+void Compiler::return_stmt(NodeId id) {
+    const auto kids = children(id);
+    const uint16_t mark = fs_->top;
+    uint16_t value;
+    if (kids.empty()) {
+        value = alloc();
+        emit(Op::LoadUnit, value);
+    } else {
+        value = operand(kids[0]);
+    }
+    emit(Op::Return, value);
+    fs_->top = mark;
+}
+
+// ============================================================================
+// 表达式
+// ============================================================================
+
+// 值写入 dest（dest 不是活跃的变量寄存器，赋值的安全情形见 assign）
+void Compiler::expr(NodeId id, uint16_t dest) {
+    const uint32_t saved = offset_;
+    if (const Token* tok = ast_.token(id)) offset_ = tok->begin;
+
+    switch (type(id)) {
+        case NodeType::Literal:    literal(id, dest); break;
+        case NodeType::Identifier: identifier(id, dest); break;
+        case NodeType::BinaryExpr: binary(id, dest); break;
+        case NodeType::UnaryExpr:  unary(id, dest); break;
+        case NodeType::CallExpr:   call(id, dest); break;
+        case NodeType::IndexExpr: {
+            const auto kids = children(id);
+            const uint16_t mark = fs_->top;
+            const uint16_t target = operand(kids[0]);
+            const uint16_t index = operand(kids[1]);
+            emit(Op::Index, dest, target, index);
+            fs_->top = mark;
+            break;
+        }
+        case NodeType::SliceExpr: {
+            // 两个下标放在相邻的寄存器中，省略的下标为 null
+            const auto kids = children(id);
+            const ASTNode& node = ast_[id];
+            const uint16_t mark = fs_->top;
+            const uint16_t target = operand(kids[0]);
+            const uint16_t from = alloc();
+            const uint16_t to = alloc();
+            size_t next = 1;
+            if (node.slice_from()) expr(kids[next++], from);
+            else                   emit(Op::LoadNull, from);
+            if (node.slice_to()) expr(kids[next], to);
+            else                 emit(Op::LoadNull, to);
+            emit(Op::Slice, dest, target, from);
+            fs_->top = mark;
+            break;
+        }
+        case NodeType::FieldExpr: {
+            const uint16_t mark = fs_->top;
+            const uint16_t target = operand(children(id)[0]);
+            emit(Op::GetField, dest, target, string_constant(std::string(text(id))));
+            fs_->top = mark;
+            break;
+        }
+        case NodeType::TupleExpr:   container(id, dest, Op::NewTuple); break;
+        case NodeType::ListExpr:    container(id, dest, Op::NewList); break;
+        case NodeType::DictExpr:    dict(id, dest); break;
+        case NodeType::BlockExpr:
+        case NodeType::ScopeExpr:   block(id, dest); break;
+        case NodeType::IfExpr:      if_expr(id, dest); break;
+        case NodeType::LoopExpr:    loop_expr(id, dest); break;
+        case NodeType::UnnamedPrim: unnamed_prim(id, dest); break;
+        case NodeType::NamedPrim:   named_prim(id, dest, false); break;
+        case NodeType::RefExpr:
+            error(id, "references are only supported as 'let x = &y'");
+            break;
+        default:
+            error(id, "unexpected node in expression");
+            break;
+    }
+    offset_ = saved;
+}
+
+// 表达式的值所在的寄存器：局部变量直接用它的寄存器，其余分配临时寄存器
+uint16_t Compiler::operand(NodeId id) {
+    if (type(id) == NodeType::Identifier) {
+        const Resolved r = resolve(text(id));
+        if (r.kind == Resolved::Local) return r.index;
+    }
+    const uint16_t reg = alloc();
+    expr(id, reg);
+    return reg;
+}
+
+// 只求副作用：赋值、控制流和 prim 定义不需要结果寄存器
+void Compiler::effect(NodeId id) {
+    switch (type(id)) {
+        case NodeType::BinaryExpr:
+            if (ast_.token(id)->type == TokenType::EQ) { assign(id, kNoReg); return; }
+            break;
+        case NodeType::NamedPrim:
+            named_prim(id, kNoReg, true);
+            return;
+        case NodeType::IfExpr:
+            if_expr(id, kNoReg);
+            return;
+        case NodeType::LoopExpr:
+            loop_expr(id, kNoReg);
+            return;
+        case NodeType::BlockExpr:
+        case NodeType::ScopeExpr:
+            block(id, kNoReg);
+            return;
+        default:
+            break;
+    }
+    const uint16_t mark = fs_->top;
+    expr(id, alloc());
+    fs_->top = mark;
+}
+
+void Compiler::literal(NodeId id, uint16_t dest) {
+    const Token* tok = ast_.token(id);
+    if (!tok) {
+        emit(Op::LoadUnit, dest);  // ()
+        return;
+    }
+    switch (tok->type) {
+        case TokenType::KW_TRUE:  emit(Op::LoadTrue, dest); break;
+        case TokenType::KW_FALSE: emit(Op::LoadFalse, dest); break;
+        case TokenType::KW_NULL:  emit(Op::LoadNull, dest); break;
+        case TokenType::FLOAT_DEC:
+            emit(Op::LoadK, dest, float_constant(tok->value.f));
+            break;
+        case TokenType::STRING: {
+            std::string s;
+            decode_string_literal(tok->text(), s);
+            emit(Op::LoadK, dest, string_constant(std::move(s)));
+            break;
+        }
+        default:
+            if (!tok->fits_int64()) {
+                error(id, fmt::format("integer literal {} does not fit in 64 bits", tok->text()));
+                break;
+            }
+            load_int(dest, int64_t(tok->value.u));
+            break;
+    }
+}
+
+void Compiler::identifier(NodeId id, uint16_t dest) {
+    const Resolved r = resolve(text(id));
+    switch (r.kind) {
+        case Resolved::Local:
+            if (r.index != dest) emit(Op::Move, dest, r.index);
+            break;
+        case Resolved::Global:
+            emit(Op::GetGlobal, dest, r.index);
+            break;
+        case Resolved::Self:
+            emit(Op::MakePrim, dest, r.index);
+            break;
+        case Resolved::Outer:
+        case Resolved::Hidden:
+            check_visible(id, text(id), r);
+            break;
+    }
+}
+
+void Compiler::binary(NodeId id, uint16_t dest) {
+    const TokenType op = ast_.token(id)->type;
+    if (op == TokenType::EQ)     { assign(id, dest); return; }
+    if (op == TokenType::ANDAND) { logical(id, dest, true); return; }
+    if (op == TokenType::OROR)   { logical(id, dest, false); return; }
+
+    const auto kids = children(id);
+    const uint16_t mark = fs_->top;
+    const uint16_t lhs = operand(kids[0]);
+    const uint16_t rhs = operand(kids[1]);
+    switch (op) {
+        case TokenType::PLUS:    emit(Op::Add, dest, lhs, rhs); break;
+        case TokenType::MINUS:   emit(Op::Sub, dest, lhs, rhs); break;
+        case TokenType::STAR:    emit(Op::Mul, dest, lhs, rhs); break;
+        case TokenType::SLASH:   emit(Op::Div, dest, lhs, rhs); break;
+        case TokenType::PERCENT: emit(Op::Mod, dest, lhs, rhs); break;
+        case TokenType::EQEQ:    emit(Op::Eq, dest, lhs, rhs); break;
+        case TokenType::NEQ:     emit(Op::Ne, dest, lhs, rhs); break;
+        case TokenType::LT:      emit(Op::Lt, dest, lhs, rhs); break;
+        case TokenType::LE:      emit(Op::Le, dest, lhs, rhs); break;
+        case TokenType::GT:      emit(Op::Lt, dest, rhs, lhs); break;
+        case TokenType::GE:      emit(Op::Le, dest, rhs, lhs); break;
+        default:
+            error(id, fmt::format("unsupported operator '{}'", text(id)));
+            break;
+    }
+    fs_->top = mark;
+}
+
+void Compiler::unary(NodeId id, uint16_t dest) {
+    const TokenType op = ast_.token(id)->type;
+    const NodeId operand_id = children(id)[0];
+
+    // 负数字面量直接载入（包括 -9223372036854775808）
+    if (op == TokenType::MINUS && type(operand_id) == NodeType::Literal) {
+        const Token* tok = ast_.token(operand_id);
+        if (tok && tok->type == TokenType::FLOAT_DEC) {
+            emit(Op::LoadK, dest, float_constant(-tok->value.f));
+            return;
+        }
+        if (tok && tok->is_number() && tok->value.u <= uint64_t(INT64_MAX) + 1) {
+            load_int(dest, int64_t(0 - tok->value.u));
+            return;
+        }
+    }
+
+    const uint16_t mark = fs_->top;
+    const uint16_t value = operand(operand_id);
+    switch (op) {
+        case TokenType::BANG:  emit(Op::Not, dest, value); break;
+        case TokenType::MINUS: emit(Op::Neg, dest, value); break;
+        case TokenType::PLUS:  emit(Op::Pos, dest, value); break;
+        default:
+            error(id, fmt::format("unsupported operator '{}'", text(id)));
+            break;
+    }
+    fs_->top = mark;
+}
+
+// target = value，表达式的值是赋的值（dest 为 kNoReg 时丢弃）
+void Compiler::assign(NodeId id, uint16_t dest) {
+    const auto kids = children(id);
+    const NodeId target = kids[0];
+    const NodeId value = kids[1];
+    const uint16_t mark = fs_->top;
+
+    // 右侧的值：需要结果时直接算进 dest
+    auto compute = [&]() -> uint16_t {
+        if (dest == kNoReg) return operand(value);
+        expr(value, dest);
+        return dest;
+    };
+
+    switch (type(target)) {
+        case NodeType::Identifier: {
+            const Resolved r = resolve(text(target));
+            if (r.kind == Resolved::Outer) {
+                error(target, fmt::format("cannot assign to '{}' of an enclosing prim", text(target)));
+                break;
+            }
+            if (r.kind == Resolved::Self) {
+                error(target, fmt::format("cannot assign to prim '{}' inside its own body", text(target)));
+                break;
+            }
+            if (!check_visible(target, text(target), r)) break;
+            if (r.kind == Resolved::Global) {
+                emit(Op::SetGlobal, compute(), r.index);
+                break;
+            }
+            // 局部变量：字面量和算术表达式的操作数先于结果写入，可以直接算进变量的寄存器；
+            // 其余（调用、&&、if 等）可能在写入后再读旧值，经临时寄存器中转
+            const NodeType vt = type(value);
+            const bool direct =
+                vt == NodeType::Literal || vt == NodeType::UnaryExpr ||
+                (vt == NodeType::BinaryExpr && ast_.token(value)->type != TokenType::EQ &&
+                 ast_.token(value)->type != TokenType::ANDAND && ast_.token(value)->type != TokenType::OROR);
+            if (direct) {
+                expr(value, r.index);
+            } else {
+                const uint16_t v = operand(value);
+                if (v != r.index) emit(Op::Move, r.index, v);
+            }
+            if (dest != kNoReg) emit(Op::Move, dest, r.index);
+            break;
+        }
+        case NodeType::IndexExpr: {
+            const auto parts = children(target);
+            const uint16_t object = operand(parts[0]);
+            const uint16_t index = operand(parts[1]);
+            emit(Op::SetIndex, object, index, compute());
+            break;
+        }
+        case NodeType::FieldExpr: {
+            const uint16_t object = operand(children(target)[0]);
+            const uint16_t name = string_constant(std::string(text(target)));
+            emit(Op::SetField, object, name, compute());
+            break;
+        }
+        case NodeType::SliceExpr:
+            error(target, "cannot assign to a slice");
+            break;
+        default:
+            error(target, "invalid assignment target");
+            break;
+    }
+    fs_->top = mark;
+}
+
+// a && b / a || b：dest 先得到 a，决定了结果时跳过 b
+void Compiler::logical(NodeId id, uint16_t dest, bool is_and) {
+    const auto kids = children(id);
+    expr(kids[0], dest);
+    const size_t skip = emit_jump(is_and ? Op::JumpIfNot : Op::JumpIf, dest);
+    expr(kids[1], dest);
+    patch(skip);
+}
+
+// callee(args...)：被调用者和参数放在连续的寄存器中，新帧直接从参数开始（不拷贝）
+void Compiler::call(NodeId id, uint16_t dest) {
+    const auto kids = children(id);
+    const NodeId callee = kids[0];
+    const uint16_t mark = fs_->top;
+
+    // dest 恰好是最后分配的临时寄存器时直接作为调用基址
+    const uint16_t base = dest != kNoReg && dest + 1 == fs_->top ? dest : alloc();
+
+    // obj.method(args)：Invoke，接收者在 base
+    const bool is_method = type(callee) == NodeType::FieldExpr;
+    if (is_method) expr(children(callee)[0], base);
+    else           expr(callee, base);
+
+    for (size_t i = 1; i < kids.size(); ++i) {
+        const uint16_t arg = alloc();
+        const uint16_t arg_mark = fs_->top;
+        expr(kids[i], arg);
+        fs_->top = arg_mark;
+    }
+    const auto argc = uint16_t(kids.size() - 1);
+
+    offset_ = offset_of(callee);
+    if (is_method) emit(Op::Invoke, base, argc, string_constant(std::string(text(callee))));
+    else           emit(Op::Call, base, argc);
+
+    if (dest != kNoReg && dest != base) emit(Op::Move, dest, base);
+    fs_->top = mark;
+}
+
+// (a, b) / [a, b]：元素依次算进连续的寄存器
+void Compiler::container(NodeId id, uint16_t dest, Op op) {
+    const auto kids = children(id);
+    const uint16_t mark = fs_->top;
+    const uint16_t first = fs_->top;
+    for (NodeId item : kids) {
+        const uint16_t reg = alloc();
+        const uint16_t item_mark = fs_->top;
+        expr(item, reg);
+        fs_->top = item_mark;
+    }
+    emit(op, dest, kids.empty() ? 0 : first, uint16_t(kids.size()));
+    fs_->top = mark;
+}
+
+void Compiler::dict(NodeId id, uint16_t dest) {
+    const auto pairs = children(id);
+    const uint16_t mark = fs_->top;
+    const uint16_t first = fs_->top;
+    for (NodeId pair : pairs) {
+        for (NodeId part : children(pair)) {
+            const uint16_t reg = alloc();
+            const uint16_t part_mark = fs_->top;
+            expr(part, reg);
+            fs_->top = part_mark;
+        }
+    }
+    emit(Op::NewDict, dest, pairs.empty() ? 0 : first, uint16_t(pairs.size()));
+    fs_->top = mark;
+}
+
+// BlockExpr / ScopeExpr：新作用域；scope 是独立的 prim，break 不能穿过，外层的局部变量需要导入
+void Compiler::block(NodeId id, uint16_t dest) {
+    const bool is_scope = type(id) == NodeType::ScopeExpr;
+    const size_t floor = fs_->loop_floor;
+    const size_t scope_floor = fs_->scope_floor;
+    if (is_scope) {
+        fs_->loop_floor = fs_->loops.size();
+        fs_->scope_floor = fs_->bindings.size();
+    }
+
+    const ScopeMark mark = enter_scope();
+    stmts(id, dest);
+    leave_scope(mark);
+
+    fs_->loop_floor = floor;
+    fs_->scope_floor = scope_floor;
+}
+
+void Compiler::if_expr(NodeId id, uint16_t dest) {
+    const auto kids = children(id);
+
+    const uint16_t mark = fs_->top;
+    const uint16_t cond = operand(kids[0]);
+    fs_->top = mark;
+    offset_ = offset_of(kids[0]);
+    const size_t to_else = emit_jump(Op::JumpIfNot, cond);
+
+    block(kids[1], dest);
+
+    if (kids.size() == 3) {
+        const size_t to_end = emit_jump(Op::Jump);
+        patch(to_else);
+        if (type(kids[2]) == NodeType::IfExpr) if_expr(kids[2], dest);
+        else                                   block(kids[2], dest);
+        patch(to_end);
+    } else if (dest != kNoReg) {
+        const size_t to_end = emit_jump(Op::Jump);
+        patch(to_else);
+        emit(Op::LoadUnit, dest);
+        patch(to_end);
+    } else {
+        patch(to_else);
+    }
+}
+
+// loop：循环体的值丢弃，只有 break 能给出结果；break 的 Jump 在循环结束处回填
+void Compiler::loop_expr(NodeId id, uint16_t dest) {
+    fs_->loops.push_back({text(id), dest, {}});
+    const size_t start = pc();
+    block(children(id)[0], kNoReg);
+    jump_back(start);
+
+    for (size_t at : fs_->loops.back().breaks) patch(at);
+    fs_->loops.pop_back();
+}
+
+// @{...}：在当前 prim 中执行，值是 scope 的闭包空间
+void Compiler::unnamed_prim(NodeId id, uint16_t dest) {
+    const auto kids = children(id);
+    if (!children(kids[0]).empty()) {
+        error(children(kids[0])[0], "decorators on anonymous prims are not supported yet");
+        return;
+    }
+
+    const size_t floor = fs_->loop_floor;
+    const size_t scope_floor = fs_->scope_floor;
+    fs_->loop_floor = fs_->loops.size();
+    fs_->scope_floor = fs_->bindings.size();
+
+    const ScopeMark mark = enter_scope();
+    stmts(kids[1], kNoReg);
+    closure_space(mark.bindings, dest);
+    leave_scope(mark);
+
+    fs_->loop_floor = floor;
+    fs_->scope_floor = scope_floor;
+}
+
+// 把 first_binding 之后的绑定（同名取最后一个）构造成 {name: value} 写入 dest
+void Compiler::closure_space(size_t first_binding, uint16_t dest) {
+    const uint16_t mark = fs_->top;
+    const uint16_t first = fs_->top;
+    uint16_t count = 0;
+    const auto& bindings = fs_->bindings;
+    for (size_t i = first_binding; i < bindings.size(); ++i) {
+        const Binding& b = bindings[i];
+        if (b.name.empty()) continue;
+        bool shadowed = false;
+        for (size_t j = i + 1; j < bindings.size() && !shadowed; ++j) shadowed = bindings[j].name == b.name;
+        if (shadowed) continue;
+
+        const uint16_t key = alloc();
+        const uint16_t value = alloc();
+        emit(Op::LoadK, key, string_constant(std::string(b.name)));
+        if (b.global) emit(Op::GetGlobal, value, b.index);
+        else          emit(Op::Move, value, b.index);
+        ++count;
+    }
+    if (dest != kNoReg) emit(Op::NewDict, dest, count ? first : 0, count);
+    fs_->top = mark;
+}
+
+// $name(params) {...}：语句形式在当前作用域绑定名字（顶层为全局变量）
+void Compiler::named_prim(NodeId id, uint16_t dest, bool is_stmt) {
+    const auto kids = children(id);
+    bool space = false;
+    for (NodeId dec : children(kids[0])) {
+        if (text(dec) == "struct") space = true;
+        else error(dec, fmt::format("unknown decorator '@{}'", text(dec)));
+    }
+
+    const std::string_view name = text(id);
+    const uint16_t index = compile_prim(id, space);
+
+    if (global_level()) {
+        const uint16_t g = global_index(name);
+        const uint16_t mark = fs_->top;
+        const uint16_t reg = dest != kNoReg ? dest : alloc();
+        emit(Op::MakePrim, reg, index);
+        emit(Op::SetGlobal, reg, g);
+        fs_->top = mark;
+        bind(name, g, true);
+    } else if (is_stmt) {
+        const uint16_t reg = alloc();
+        emit(Op::MakePrim, reg, index);
+        bind(name, reg, false);
+    } else {
+        // 表达式中的命名 prim 只产生值，不在局部作用域中绑定名字（寄存器随表达式释放）
+        emit(Op::MakePrim, dest, index);
+    }
+}
+
+uint16_t Compiler::compile_prim(NodeId id, bool space) {
+    const auto kids = children(id);
+    const NodeId params = kids[1];
+    const NodeId body = kids.back();
+
+    if (module_.prims.size() > kMaxSlot) {
+        error(id, "too many prims");
+        return 0;
+    }
+    const auto index = uint16_t(module_.prims.size());
+    module_.prims.emplace_back();
+
+    const uint32_t saved = offset_;
+    PrimState state;
+    state.enclosing = fs_;
+    state.code.name = std::string(text(id));
+    if (!global_level()) {
+        // 顶层的命名 prim 经全局变量递归；局部的名字在函数体编译完之后才绑定
+        state.self = text(id);
+        state.self_index = index;
+    }
+    state.code.closure_space = space;
+    fs_ = &state;
+
+    // 参数依次位于 R[0] ~ R[n-1]
+    for (NodeId param : children(params)) {
+        if (ast_[param].is_ref()) error(param, "reference parameters are not supported yet");
+        bind(text(param), alloc(), false);
+    }
+    state.code.params = uint16_t(children(params).size());
+
+    if (space) {
+        // @struct：返回参数和顶层 let 组成的闭包空间
+        stmts(body, kNoReg);
+        const uint16_t result = alloc();
+        closure_space(0, result);
+        emit(Op::Return, result);
+    } else {
+        const uint16_t result = alloc();
+        stmts(body, result);
+        emit(Op::Return, result);
+    }
+
+    fs_ = state.enclosing;
+    offset_ = saved;
+    module_.prims[index] = std::move(state.code);
+    return index;
+}
+
+} // namespace
+
+// ============================================================================
+// compile
+// ============================================================================
+
+std::optional<Module> compile(const Ast& ast, std::vector<CompileError>& errors) {
+    return Compiler(ast, errors).run();
+}
+
+} // namespace prim
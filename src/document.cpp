@@ -0,0 +1,235 @@
+#include "document.hpp"
+#include "lexer.hpp"
+#include "source.hpp"
+
+#include <algorithm>
+#include <span>
+#include <utility>
+
+namespace prim {
+
+namespace {
+
+// ============================================================================
+// 区域扫描：词法分析一段源码并找出顶层段边界
+// ============================================================================
+
+struct RegionScan {
+    SourceBuffer        source;  // token 词素指向这里（原地构造，不移动）
+    std::vector<Token>  tokens;  // 不含 END
+    std::vector<size_t> cuts;    // 段边界：tokens[cut - 1] 是段末的 ";"
+};
+
+void scan_region(RegionScan& scan, const std::string& text, Interner& symbols) {
+    scan.source = SourceBuffer::from_string(text);
+    scan.tokens.clear();
+    scan.cuts.clear();
+
+    Lexer lexer(scan.source);
+    lexer.set_interner(&symbols);
+    for (Token tok = lexer.next(); tok.type != TokenType::END; tok = lexer.next()) {
+        scan.tokens.push_back(tok);
+    }
+
+    // 未匹配的右括号是 ERROR token，不出栈，因此这里的深度与 lexer 的括号栈一致
+    uint32_t depth = 0;
+    const size_t n = scan.tokens.size();
+    for (size_t i = 0; i < n; ++i) {
+        switch (scan.tokens[i].type) {
+            case TokenType::LPAREN:
+            case TokenType::LBRACK:
+            case TokenType::LBRACE:
+                ++depth;
+                break;
+            case TokenType::RPAREN:
+            case TokenType::RBRACK:
+            case TokenType::RBRACE:
+                if (depth > 0) --depth;
+                break;
+            case TokenType::SEMI:
+                // 连续的 ";" 归入同一段：单独的 ";" 不是合法的程序
+                if (depth == 0 && (i + 1 == n || scan.tokens[i + 1].type != TokenType::SEMI)) {
+                    scan.cuts.push_back(i + 1);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// Document 实现
+// ============================================================================
+
+Document::Document(std::string_view text) {
+    assign(text);
+}
+
+void Document::assign(std::string_view text) {
+    segments_.clear();
+    starts_.clear();
+    size_ = 0;
+    rebuild(0, 0, std::string(text));
+}
+
+std::optional<Document::EditStats> Document::edit(uint32_t offset, uint32_t removed,
+                                                  std::string_view inserted) {
+    if (offset > size_ || removed > size_ - offset) {
+        return std::nullopt;
+    }
+
+    // 编辑区间的结束位置落在段首时也要包含该段：删除的文本可能与它相连
+    const size_t first = find_segment(offset);
+    const size_t last  = find_segment(offset + removed) + 1;
+
+    std::string region;
+    const uint32_t base = starts_[first];
+    region.reserve(starts_[last - 1] + segments_[last - 1]->text.size() - base + inserted.size());
+    for (size_t i = first; i < last; ++i) {
+        region += segments_[i]->text;
+    }
+    region.replace(offset - base, removed, inserted);
+
+    return rebuild(first, last, std::move(region));
+}
+
+Document::EditStats Document::rebuild(size_t first, size_t last, std::string region) {
+    EditStats stats;
+    RegionScan scan;
+    size_t extend = 1;
+
+    for (;;) {
+        scan_region(scan, region, symbols_);
+        stats.relexed_bytes += region.size();
+        stats.relexed_tokens += scan.tokens.size();
+
+        // 以 ";" 开头时必须与前一段末尾的 ";" 合为一段
+        if (first > 0 && !scan.tokens.empty() && scan.tokens.front().type == TokenType::SEMI) {
+            --first;
+            region.insert(0, segments_[first]->text);
+            continue;
+        }
+
+        // 区域末尾恰好是段边界时，之后的旧段词法分析结果不变，可以原样保留
+        const bool synced =
+            last == segments_.size() || region.empty() ||
+            (!scan.cuts.empty() && scan.tokens[scan.cuts.back() - 1].end() == region.size());
+        if (synced) {
+            break;
+        }
+
+        // 否则（删掉了 ";"、打开了未闭合的注释或括号等）向后并入旧段，每次翻倍
+        const size_t stop = std::min(segments_.size(), last + extend);
+        extend *= 2;
+        for (; last < stop; ++last) {
+            region += segments_[last]->text;
+        }
+    }
+
+    const uint32_t base    = first < segments_.size() ? starts_[first] : uint32_t(size_);
+    const uint32_t old_end = last < segments_.size() ? starts_[last] : uint32_t(size_);
+
+    // 按切分点生成新段：源码、token 换成段内偏移，词素指向段自己的源码
+    std::vector<SegmentPtr> fresh;
+    std::vector<uint32_t>   fresh_starts;
+    uint32_t begin = 0;
+    size_t   tok   = 0;
+    auto emit = [&](uint32_t end, size_t tok_end) {
+        auto seg = std::make_unique<Segment>();
+        seg->text.assign(region, begin, end - begin);
+        seg->tokens.reserve(tok_end - tok);
+        const char* src = scan.source.data() + begin;
+        for (; tok < tok_end; ++tok) {
+            Token t = scan.tokens[tok];
+            t.begin -= begin;
+            if (t.lexeme) t.lexeme = seg->text.data() + (t.lexeme - src);
+            seg->tokens.push_back(t);
+        }
+        parse_segment(*seg);
+        fresh.push_back(std::move(seg));
+        fresh_starts.push_back(base + begin);
+        begin = end;
+    };
+    for (size_t cut : scan.cuts) {
+        emit(scan.tokens[cut - 1].end(), cut);
+    }
+    if (begin < region.size() || (first == 0 && last == segments_.size() && fresh.empty())) {
+        emit(uint32_t(region.size()), scan.tokens.size());  // 末尾没有 ";" 的部分（或空文档）
+    }
+
+    // 之后的段只平移起始偏移
+    const uint32_t new_end = base + uint32_t(region.size());
+    if (new_end != old_end) {
+        for (size_t i = last; i < starts_.size(); ++i) {
+            starts_[i] = starts_[i] - old_end + new_end;
+        }
+    }
+    size_ = size_ - old_end + new_end;
+
+    // 段数不变时原地替换；只有段数变化时才需要整体搬移后面的段
+    const size_t old_count = last - first;
+    const size_t common = std::min(old_count, fresh.size());
+    std::move(fresh.begin(), fresh.begin() + common, segments_.begin() + first);
+    std::copy(fresh_starts.begin(), fresh_starts.begin() + common, starts_.begin() + first);
+    if (fresh.size() > old_count) {
+        segments_.insert(segments_.begin() + last,
+                         std::make_move_iterator(fresh.begin() + common), std::make_move_iterator(fresh.end()));
+        starts_.insert(starts_.begin() + last, fresh_starts.begin() + common, fresh_starts.end());
+    } else if (fresh.size() < old_count) {
+        segments_.erase(segments_.begin() + first + common, segments_.begin() + last);
+        starts_.erase(starts_.begin() + first + common, starts_.begin() + last);
+    }
+
+    stats.reparsed_segments = fresh.size();
+    stats.reused_segments = segments_.size() - stats.reparsed_segments;
+    return stats;
+}
+
+void Document::parse_segment(Segment& seg) {
+    parser_.parse(std::span<const Token>(seg.tokens));
+    seg.ast = parser_.take_ast();
+    seg.errors = parser_.get_errors();
+}
+
+std::string Document::text() const {
+    std::string out;
+    out.reserve(size_);
+    for (const auto& seg : segments_) {
+        out += seg->text;
+    }
+    return out;
+}
+
+size_t Document::find_segment(uint32_t offset) const {
+    auto it = std::upper_bound(starts_.begin(), starts_.end(), offset);
+    return it == starts_.begin() ? 0 : size_t(it - starts_.begin()) - 1;
+}
+
+std::vector<ParseError> Document::diagnostics() const {
+    std::vector<ParseError> out;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        for (const ParseError& err : segments_[i]->errors) {
+            out.push_back(err);
+            out.back().offset += starts_[i];
+        }
+    }
+    return out;
+}
+
+bool Document::has_errors() const noexcept {
+    return std::any_of(segments_.begin(), segments_.end(),
+                       [](const SegmentPtr& seg) { return !seg->errors.empty(); });
+}
+
+size_t Document::statement_count() const {
+    size_t count = 0;
+    for (const auto& seg : segments_) {
+        count += seg->statements().child_count();
+    }
+    return count;
+}
+
+} // namespace prim
@@ -0,0 +1,319 @@
+// arena.hpp - Prim 解析期内存池
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "token.hpp"
+#include "macro.hpp"
+
+namespace prim {
+
+// ============================================================================
+// TokenArena - Token 分块存储
+// ============================================================================
+//
+// - 按块分配，已存入的 Token 地址在 clear() 之前始终稳定（AST 持有 const Token*）
+// - 追加为均摊 O(1)，块大小翻倍增长，不会像 std::vector 那样整体搬移
+// - clear() 一次性释放：只保留最大的一块供下一次解析复用
+
+class TokenArena {
+public:
+    static constexpr size_t kFirstChunk = 256;        // 第一块容量（个 Token）
+    static constexpr size_t kMaxChunk   = 64 * 1024;  // 单块容量上限
+
+    static_assert(std::is_trivially_destructible_v<Token>,
+                  "TokenArena 不调用析构函数，Token 必须可平凡析构");
+    static_assert(alignof(Token) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                  "new std::byte[] 需满足 Token 的对齐要求");
+
+    TokenArena() = default;
+
+    // 禁止拷贝，允许移动（移动不改变元素地址）
+    TokenArena(const TokenArena&) = delete;
+    TokenArena& operator=(const TokenArena&) = delete;
+    TokenArena(TokenArena&&) noexcept = default;
+    TokenArena& operator=(TokenArena&&) noexcept = default;
+
+    // 存入一个 Token，返回稳定地址
+    force_inline_ const Token* push(const Token& tok) {
+        if (unlikely_(chunks_.empty() || used_ == chunks_[cur_].capacity)) {
+            next_chunk(0);
+        }
+        Token* slot = chunks_[cur_].data() + used_++;
+        ::new (static_cast<void*>(slot)) Token(tok);
+        ++size_;
+        return slot;
+    }
+
+    // 由 make() 返回的 Token 直接在槽位中构造（纯右值初始化，C++17 起保证不产生临时对象）
+    template <typename Make>
+    force_inline_ const Token* emplace(Make&& make) {
+        if (unlikely_(chunks_.empty() || used_ == chunks_[cur_].capacity)) {
+            next_chunk(0);
+        }
+        Token* slot = chunks_[cur_].data() + used_;
+        ::new (static_cast<void*>(slot)) Token(make());
+        ++used_;
+        ++size_;
+        return slot;
+    }
+
+    // 预留：保证接下来至少 n 个 Token 不需要再分配
+    void reserve(size_t n) {
+        if (chunks_.empty() || chunks_[cur_].capacity - used_ < n) {
+            next_chunk(n);
+        }
+    }
+
+    // 一次性释放所有 Token，仅保留最大的一块
+    void clear() noexcept {
+        if (chunks_.size() > 1) {
+            auto largest = std::max_element(chunks_.begin(), chunks_.end(),
+                [](const Chunk& a, const Chunk& b) { return a.capacity < b.capacity; });
+            Chunk keep = std::move(*largest);
+            chunks_.clear();
+            chunks_.push_back(std::move(keep));
+        }
+        cur_  = 0;
+        used_ = 0;
+        size_ = 0;
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+    // 已分配的总容量（个 Token）
+    [[nodiscard]] size_t capacity() const noexcept {
+        size_t total = 0;
+        for (const auto& c : chunks_) total += c.capacity;
+        return total;
+    }
+
+private:
+    struct Chunk {
+        std::unique_ptr<std::byte[]> storage;
+        size_t capacity = 0;
+
+        Token* data() const noexcept { return reinterpret_cast<Token*>(storage.get()); }
+    };
+
+    // 追加新的一块，至少容纳 min_capacity 个 Token
+    no_inline_ void next_chunk(size_t min_capacity) {
+        if (!chunks_.empty() && used_ == 0 && chunks_[cur_].capacity >= min_capacity) {
+            return;  // 当前块（clear() 后保留的块）为空且足够大
+        }
+
+        size_t cap = chunks_.empty()
+            ? kFirstChunk
+            : std::min(chunks_.back().capacity * 2, kMaxChunk);
+        cap = std::max(cap, min_capacity);
+
+        Chunk chunk;
+        chunk.storage.reset(new std::byte[cap * sizeof(Token)]);
+        chunk.capacity = cap;
+        chunks_.push_back(std::move(chunk));
+        cur_  = chunks_.size() - 1;
+        used_ = 0;
+    }
+
+    std::vector<Chunk> chunks_;
+    size_t cur_  = 0;  // 当前写入块下标
+    size_t used_ = 0;  // 当前块已用数量
+    size_t size_ = 0;  // Token 总数
+};
+
+// ============================================================================
+// ParseArena - 解析期 bump 分配器
+// ============================================================================
+//
+// - 单调分配：只移动游标，deallocate 是空操作，整体随 reset() 一次性回收
+// - 继承 std::pmr::memory_resource，也可以直接交给 pmr 容器使用
+// - reset() 与 TokenArena::clear() 相同：只保留最大的一块供下一个文件复用
+
+class ParseArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kFirstChunk = 16 * 1024;    // 第一块大小（字节）
+    static constexpr size_t kMaxChunk   = 1024 * 1024;  // 单块大小上限（字节）
+
+    ParseArena() = default;
+
+    // 禁止拷贝，允许移动
+    ParseArena(const ParseArena&) = delete;
+    ParseArena& operator=(const ParseArena&) = delete;
+    ParseArena(ParseArena&&) noexcept = default;
+    ParseArena& operator=(ParseArena&&) noexcept = default;
+
+    // 分配 n 个 T 的未初始化空间
+    template <typename T>
+    T* alloc(size_t n) {
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // 把 [p, p + old_n) 扩展到 new_n 个元素：
+    // p 恰好是最近一次分配且当前块放得下时原地扩展，否则重新分配并拷贝
+    template <typename T>
+    T* grow(T* p, size_t old_n, size_t new_n) {
+        static_assert(std::is_trivially_copyable_v<T>, "grow 使用 memcpy，T 必须可平凡拷贝");
+        std::byte* tail = reinterpret_cast<std::byte*>(p + old_n);
+        size_t extra = (new_n - old_n) * sizeof(T);
+        if (p && tail == cursor_ && static_cast<size_t>(limit_ - cursor_) >= extra) {
+            cursor_ += extra;
+            return p;
+        }
+        T* fresh = alloc<T>(new_n);
+        if (old_n) std::memcpy(fresh, p, old_n * sizeof(T));
+        return fresh;
+    }
+
+    // 一次性回收所有分配，仅保留最大的一块
+    void reset() noexcept {
+        if (chunks_.size() > 1) {
+            auto largest = std::max_element(chunks_.begin(), chunks_.end(),
+                [](const Chunk& a, const Chunk& b) { return a.size < b.size; });
+            Chunk keep = std::move(*largest);
+            chunks_.clear();
+            chunks_.push_back(std::move(keep));
+        }
+        if (chunks_.empty()) {
+            cursor_ = limit_ = nullptr;
+        } else {
+            cursor_ = chunks_.back().storage.get();
+            limit_  = cursor_ + chunks_.back().size;
+        }
+        retired_ = 0;
+    }
+
+    // 已分配出去的字节数（含对齐填充）
+    [[nodiscard]] size_t bytes_used() const noexcept {
+        if (chunks_.empty()) return 0;
+        return retired_ + static_cast<size_t>(cursor_ - chunks_.back().storage.get());
+    }
+
+    // 已向系统申请的总字节数
+    [[nodiscard]] size_t capacity() const noexcept {
+        size_t total = 0;
+        for (const auto& c : chunks_) total += c.size;
+        return total;
+    }
+
+private:
+    struct Chunk {
+        std::unique_ptr<std::byte[]> storage;
+        size_t size = 0;
+    };
+
+    void* do_allocate(size_t bytes, size_t align) override {
+        std::byte* p = align_up(cursor_, align);
+        if (unlikely_(!p || p + bytes > limit_)) {
+            next_chunk(bytes + align);
+            p = align_up(cursor_, align);
+        }
+        cursor_ = p + bytes;
+        return p;
+    }
+
+    // 单调分配：逐个释放是空操作
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    static std::byte* align_up(std::byte* p, size_t align) noexcept {
+        auto addr = reinterpret_cast<std::uintptr_t>(p);
+        return reinterpret_cast<std::byte*>((addr + align - 1) & ~(std::uintptr_t(align) - 1));
+    }
+
+    // 追加新的一块，至少容纳 min_bytes 字节
+    no_inline_ void next_chunk(size_t min_bytes) {
+        if (!chunks_.empty()) {
+            retired_ += static_cast<size_t>(cursor_ - chunks_.back().storage.get());
+        }
+        size_t size = chunks_.empty()
+            ? kFirstChunk
+            : std::min(chunks_.back().size * 2, kMaxChunk);
+        size = std::max(size, min_bytes);
+
+        Chunk chunk;
+        chunk.storage.reset(new std::byte[size]);
+        chunk.size = size;
+        cursor_ = chunk.storage.get();
+        limit_  = cursor_ + size;
+        chunks_.push_back(std::move(chunk));
+    }
+
+    std::vector<Chunk> chunks_;
+    std::byte* cursor_  = nullptr;  // 当前块的分配游标
+    std::byte* limit_   = nullptr;  // 当前块末尾
+    size_t     retired_ = 0;        // 之前各块已用的字节数
+};
+
+// ============================================================================
+// ArenaVec - 在 ParseArena 中增长的小数组
+// ============================================================================
+//
+// 只有指针和两个计数，作为 Bison 语义值时移动的代价与 NodeId 相当；
+// 内存归 ParseArena 所有，随 reset() 一起回收，本身不需要析构。
+//
+// 只能移动、不能拷贝：两个副本共享同一块缓冲区，各自 push_back 会互相覆盖元素。
+// 语法动作中的列表必须用 std::move 传递，漏写时编译失败，而不是在运行时悄悄共享。
+
+template <typename T>
+class ArenaVec {
+    static_assert(std::is_trivially_copyable_v<T>, "ArenaVec 只存放可平凡拷贝的元素");
+
+public:
+    ArenaVec() = default;
+
+    ArenaVec(const ArenaVec&) = delete;
+    ArenaVec& operator=(const ArenaVec&) = delete;
+
+    // 移动后源对象为空
+    ArenaVec(ArenaVec&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+        , capacity_(std::exchange(other.capacity_, 0)) {}
+
+    ArenaVec& operator=(ArenaVec&& other) noexcept {
+        data_     = std::exchange(other.data_, nullptr);
+        size_     = std::exchange(other.size_, 0);
+        capacity_ = std::exchange(other.capacity_, 0);
+        return *this;
+    }
+
+    force_inline_ void push_back(ParseArena& arena, T value) {
+        if (unlikely_(size_ == capacity_)) grow(arena);
+        data_[size_++] = value;
+    }
+
+    [[nodiscard]] const T* data() const noexcept { return data_; }
+    [[nodiscard]] const T* begin() const noexcept { return data_; }
+    [[nodiscard]] const T* end() const noexcept { return data_ + size_; }
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+    operator std::span<const T>() const noexcept { return {data_, size_}; }
+
+private:
+    no_inline_ void grow(ParseArena& arena) {
+        uint32_t cap = capacity_ ? capacity_ * 2 : 4;
+        data_ = arena.grow(data_, capacity_, cap);
+        capacity_ = cap;
+    }
+
+    T*       data_     = nullptr;
+    uint32_t size_     = 0;
+    uint32_t capacity_ = 0;
+};
+
+} // namespace prim
@@ -1,48 +1,70 @@
 #pragma once
 
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <span>
 #include <vector>
 #include "token.hpp"
+#include "arena.hpp"
 
 namespace prim {
 
-// ===== 具体节点类型 =====
+// ============================================================================
+// 扁平 AST 存储
+// ============================================================================
+//
+// 所有节点连续存放在 Ast::nodes_ 中，用 32 位 NodeId 引用；
+// 每个节点的子节点是共享边数组 Ast::edges_ 中的一段连续区间。
+// 节点按后序创建（子节点先于父节点），遍历基本是线性访存。
+
+using NodeId = uint32_t;
+using NodeList = ArenaVec<NodeId>;  // 构建期的子节点列表（分配在 ParseArena 中，用于 Bison 语义值）
+
+inline constexpr NodeId kNoNode = std::numeric_limits<NodeId>::max();  // 空节点（可选子节点缺省）
+
+class Ast;
+class NodeRef;
+
+// ===== 节点记录（16 字节）=====
 struct ASTNode {
-    enum class NodeType {
+    enum class NodeType : uint8_t {
         // ===== 字面量和标识符 =====
         Literal,        // 42, "str", true, false, null, () - token 存储原始值
         Identifier,     // x, foo - token 存储标识符名
-        
+
         // ===== 运算符表达式 =====
         BinaryExpr,     // a + b, a && b, a == b, a = b - token 存储操作符
         UnaryExpr,      // !a, -a, +a - token 存储操作符
-        
+
         // ===== 后缀表达式 =====
         CallExpr,       // func(args) - children: [callee, arg1, arg2, ...]
         IndexExpr,      // arr[idx] - children: [target, index]
+        SliceExpr,      // arr[from:to] - children: [target, from(opt), to(opt)]，有哪个下标见标志位
         FieldExpr,      // obj.field - children: [target], token: field_name
-        
+
         // ===== 容器 =====
         TupleExpr,      // (a, b, c) - children: [elem1, elem2, ...], 注意 (expr) 会直接解包
         ListExpr,       // [a, b, c] - children: [elem1, elem2, ...]
         DictExpr,       // {k: v, ...} - children: [pair1, pair2, ...], 空 {} 是空字典
         DictPair,       // k: v - children: [key, value]
-        
+
         // ===== 块和控制流 =====
         // Block: 只用于 if 和 loop 的主体，语法强制要求
         // Scope: 普通作用域，用于函数体、匿名闭包等
         BlockExpr,      // if/loop 中的 {...} - children: [stmt1, stmt2, ...]
         ScopeExpr,      // 普通的 {...} 作用域 - children: [stmt1, stmt2, ...]
-        
+
         IfExpr,         // if cond {...} else {...} - children: [cond, then_block, else_expr(opt)]
         LoopExpr,       // loop {...} or loop `label` {...} - children: [body], token: label(opt)
-        
+
         // ===== 语句 =====
         LetStmt,        // let x = expr - children: [target_list, rhs(opt)]
         DelStmt,        // del x, y, z - children: [ident_list]
         BreakStmt,      // break or break `label` or break expr - children: [value(opt)], token: label(opt)
         ReturnStmt,     // return or return expr - children: [value(opt)]
         ExprStmt,       // expr; - children: [expr]
-        
+
         // ===== Prim（函数） =====
         // 匿名 Prim: @{...} 或 @dec1 @dec2 @{...}
         // 命名 Prim: $name(params) {...} 或 @dec $name(params) {...}
@@ -50,17 +72,17 @@ struct ASTNode {
         NamedPrim,      // $name(params) {...} - children: [decorator_list(opt), param_list, return_type(opt), impl]
                         // token: name, impl 是 scope
         Param,          // x 或 &x - children: [type_hint(opt)], token: name
-        
+
         // ===== 引用 =====
         RefExpr,        // &expr - children: [target]
                         // 注意：Ref 不能隐式转换为 Expr，是完全独立的类型
-        
+
         // ===== Let Target =====
         LetTarget,      // let 的目标：x 或 &x - children: [type_hint(opt)], token: name
-        
+
         // ===== 辅助节点 =====
         TypeHint,       // i32 | str | null - children: [ident1, ident2, ...] 变长数组
-        
+
         // ===== 列表节点 =====
         StmtList,       // 语句列表 - children: [stmt1, stmt2, ...]
         ExprList,       // 表达式/引用列表（用于tuple、list、call参数等）- children: [expr_or_ref1, ...]
@@ -68,26 +90,199 @@ struct ASTNode {
         IdentList,      // 标识符列表（用于del）- children: [ident1, ident2, ...]
         ParamList,      // 参数列表 - children: [param1, param2, ...]
         DecoratorList,  // 装饰器列表 - children: [ident1, ident2, ...] 存储装饰器名
-        
+
         // ===== 根节点 =====
         Program,        // 整个程序 - children: [stmt_list]
     };
-    
-    NodeType type;
-    std::vector<ASTNode> children;  // 使用 vector 而不是 list，更高效
-    const Token* token = nullptr;   // 存储关键 token（操作符、标识符、字面量等）
-    
-    // ===== 辅助字段 =====
-    // 注意：这些字段根据节点类型使用不同的含义
-    bool is_ref = false;            // 用于 Param 和 LetTarget，表示是否是引用(&)
-    bool use_tail = false;          // 用于 BlockExpr 和 ScopeExpr，表示是否使用最后的表达式作为返回值
-    bool trailing_comma = false;    // 用于 TupleExpr，单元素 tuple 必须有尾随逗号: (x,)
-    bool is_import = false;         // 用于 LetStmt，区分导入外部变量 (let x;) 和定义新变量 (let x = expr;)
-    
-    // 构造函数
-    ASTNode() : type(NodeType::Program) {}  // 默认构造函数
-    ASTNode(NodeType t) : type(t) {}
-    ASTNode(NodeType t, const Token* tok) : type(t), token(tok) {}
+
+    // ===== 辅助标志位 =====
+    // 注意：这些标志根据节点类型使用不同的含义
+    enum Flag : uint8_t {
+        kIsRef         = 1 << 0,  // 用于 Param 和 LetTarget，表示是否是引用(&)
+        kUseTail       = 1 << 1,  // 用于 BlockExpr 和 ScopeExpr，表示是否使用最后的表达式作为返回值
+        kTrailingComma = 1 << 2,  // 用于 TupleExpr，单元素 tuple 必须有尾随逗号: (x,)
+        kIsImport      = 1 << 3,  // 用于 LetStmt，区分导入外部变量 (let x;) 和定义新变量 (let x = expr;)
+        kSliceFrom     = 1 << 4,  // 用于 SliceExpr，有起始下标 (a[i:])
+        kSliceTo       = 1 << 5,  // 用于 SliceExpr，有结束下标 (a[:j])
+    };
+
+    static constexpr uint32_t kNoToken = std::numeric_limits<uint32_t>::max();
+
+    NodeType type        = NodeType::Program;
+    uint8_t  flags       = 0;
+    uint32_t token       = kNoToken;  // Ast::tokens_ 下标（操作符、标识符、字面量等）
+    uint32_t first_child = 0;         // 子节点在 Ast::edges_ 中的起始下标
+    uint32_t child_count = 0;         // 子节点数量
+
+    [[nodiscard]] bool is_ref() const noexcept         { return flags & kIsRef; }
+    [[nodiscard]] bool use_tail() const noexcept       { return flags & kUseTail; }
+    [[nodiscard]] bool trailing_comma() const noexcept { return flags & kTrailingComma; }
+    [[nodiscard]] bool is_import() const noexcept      { return flags & kIsImport; }
+    [[nodiscard]] bool slice_from() const noexcept     { return flags & kSliceFrom; }
+    [[nodiscard]] bool slice_to() const noexcept       { return flags & kSliceTo; }
+};
+
+static_assert(sizeof(ASTNode) == 16, "ASTNode 应保持 16 字节");
+
+// ============================================================================
+// NodeRef - 节点只读视图
+// ============================================================================
+
+class NodeRef {
+public:
+    class ChildRange;
+
+    NodeRef() = default;
+    NodeRef(const Ast* ast, NodeId id) : ast_(ast), id_(id) {}
+
+    [[nodiscard]] NodeId id() const noexcept { return id_; }
+    [[nodiscard]] const Ast& ast() const noexcept { return *ast_; }
+    [[nodiscard]] const ASTNode& node() const;
+
+    [[nodiscard]] ASTNode::NodeType type() const { return node().type; }
+    [[nodiscard]] const Token* token() const;
+
+    [[nodiscard]] bool is_ref() const         { return node().is_ref(); }
+    [[nodiscard]] bool use_tail() const       { return node().use_tail(); }
+    [[nodiscard]] bool trailing_comma() const { return node().trailing_comma(); }
+    [[nodiscard]] bool is_import() const      { return node().is_import(); }
+    [[nodiscard]] bool slice_from() const     { return node().slice_from(); }
+    [[nodiscard]] bool slice_to() const       { return node().slice_to(); }
+
+    [[nodiscard]] size_t child_count() const { return node().child_count; }
+    [[nodiscard]] NodeRef child(size_t i) const;
+    [[nodiscard]] ChildRange children() const;
+
+private:
+    const Ast* ast_ = nullptr;
+    NodeId     id_  = kNoNode;
+};
+
+// ============================================================================
+// Ast - 扁平 AST 存储
+// ============================================================================
+
+class Ast {
+public:
+    // 添加节点，children 按顺序写入共享边数组，返回新节点 id
+    NodeId add(ASTNode::NodeType type, const Token* tok = nullptr,
+               std::span<const NodeId> children = {}, uint8_t flags = 0) {
+        return add(type, tok, kNoNode, children, flags);
+    }
+
+    // 同上，但子节点为 head（为 kNoNode 时忽略）后接 rest
+    NodeId add(ASTNode::NodeType type, const Token* tok, NodeId head,
+               std::span<const NodeId> rest, uint8_t flags = 0) {
+        ASTNode node;
+        node.type  = type;
+        node.flags = flags;
+        if (tok) {
+            node.token = static_cast<uint32_t>(tokens_.size());
+            tokens_.push_back(tok);
+        }
+        node.first_child = static_cast<uint32_t>(edges_.size());
+        if (head != kNoNode) edges_.push_back(head);
+        edges_.insert(edges_.end(), rest.begin(), rest.end());
+        node.child_count = static_cast<uint32_t>(edges_.size()) - node.first_child;
+
+        nodes_.push_back(node);
+        return static_cast<NodeId>(nodes_.size() - 1);
+    }
+
+    // ===== 访问 =====
+
+    [[nodiscard]] const ASTNode& operator[](NodeId id) const { return nodes_[id]; }
+
+    [[nodiscard]] std::span<const NodeId> children(NodeId id) const {
+        const ASTNode& n = nodes_[id];
+        return {edges_.data() + n.first_child, n.child_count};
+    }
+
+    [[nodiscard]] const Token* token(NodeId id) const {
+        const ASTNode& n = nodes_[id];
+        return n.token == ASTNode::kNoToken ? nullptr : tokens_[n.token];
+    }
+
+    [[nodiscard]] NodeRef ref(NodeId id) const { return NodeRef(this, id); }
+
+    [[nodiscard]] NodeId root() const noexcept { return root_; }
+    void set_root(NodeId id) noexcept { root_ = id; }
+
+    // ===== 统计 =====
+
+    [[nodiscard]] size_t size() const noexcept { return nodes_.size(); }
+    [[nodiscard]] size_t edge_count() const noexcept { return edges_.size(); }
+
+    // 节点、边、token 表占用的字节数
+    [[nodiscard]] size_t memory_bytes() const noexcept {
+        return nodes_.size() * sizeof(ASTNode) +
+               edges_.size() * sizeof(NodeId) +
+               tokens_.size() * sizeof(const Token*);
+    }
+
+    // ===== 状态管理 =====
+
+    // 清空所有节点（保留已分配的容量）
+    void clear() noexcept {
+        nodes_.clear();
+        edges_.clear();
+        tokens_.clear();
+        root_ = kNoNode;
+    }
+
+    void reserve(size_t nodes) {
+        nodes_.reserve(nodes);
+        edges_.reserve(nodes);
+    }
+
+private:
+    std::vector<ASTNode>      nodes_;   // 节点数组
+    std::vector<NodeId>       edges_;   // 共享边数组
+    std::vector<const Token*> tokens_;  // 节点引用的 token
+    NodeId                    root_ = kNoNode;
+};
+
+// ============================================================================
+// NodeRef 实现
+// ============================================================================
+
+class NodeRef::ChildRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = NodeRef;
+        using difference_type   = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(const Ast* ast, const NodeId* p) : ast_(ast), p_(p) {}
+
+        NodeRef operator*() const { return NodeRef(ast_, *p_); }
+        iterator& operator++() { ++p_; return *this; }
+        iterator operator++(int) { iterator tmp = *this; ++p_; return tmp; }
+        bool operator==(const iterator& other) const { return p_ == other.p_; }
+
+    private:
+        const Ast*    ast_ = nullptr;
+        const NodeId* p_   = nullptr;
+    };
+
+    ChildRange(const Ast* ast, std::span<const NodeId> ids) : ast_(ast), ids_(ids) {}
+
+    [[nodiscard]] iterator begin() const { return iterator(ast_, ids_.data()); }
+    [[nodiscard]] iterator end() const { return iterator(ast_, ids_.data() + ids_.size()); }
+    [[nodiscard]] size_t size() const noexcept { return ids_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return ids_.empty(); }
+    [[nodiscard]] NodeRef operator[](size_t i) const { return NodeRef(ast_, ids_[i]); }
+
+private:
+    const Ast*              ast_;
+    std::span<const NodeId> ids_;
 };
 
+inline const ASTNode& NodeRef::node() const { return (*ast_)[id_]; }
+inline const Token* NodeRef::token() const { return ast_->token(id_); }
+inline NodeRef NodeRef::child(size_t i) const { return NodeRef(ast_, ast_->children(id_)[i]); }
+inline NodeRef::ChildRange NodeRef::children() const { return ChildRange(ast_, ast_->children(id_)); }
+
 } // namespace prim
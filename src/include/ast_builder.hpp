@@ -0,0 +1,209 @@
+// ast_builder.hpp - 语法分析的 AST 构建辅助函数（Bison 与 Pratt 两个后端共用）
+#pragma once
+
+#include "ast.hpp"
+#include "parser.hpp"
+#include "token.hpp"
+
+namespace prim::builder {
+
+// ============================================================================
+// AST 构建辅助函数
+// ============================================================================
+//
+// 节点直接写入 parser.ast() 的扁平存储，语义值只是 NodeId / NodeList。
+// 两个后端按相同的顺序调用同样的函数，节点 id、边和 token 下标因此完全一致。
+
+using NodeType = ASTNode::NodeType;
+
+// ===== 列表 =====
+// 构建期的列表只是 NodeList（分配在 parser.arena() 中），
+// 归约到父节点时一次性写入边数组，随 reset() 整体回收
+
+inline void list_add(Parser& parser, NodeList& list, NodeId node) {
+    list.push_back(parser.arena(), node);
+}
+
+// 语句列表：出错的语句（stmt: error）没有节点，直接跳过
+inline void stmt_list_add(Parser& parser, NodeList& list, NodeId stmt) {
+    if (stmt != kNoNode) list.push_back(parser.arena(), stmt);
+}
+
+inline void ident_list_add(Parser& parser, NodeList& list, const Token* ident) {
+    list.push_back(parser.arena(), parser.ast().add(NodeType::Identifier, ident));
+}
+
+// 把 NodeList 落成一个列表节点（StmtList、LetTargetList、IdentList 等）
+inline NodeId create_list_node(Parser& parser, NodeType type, const NodeList& items) {
+    return parser.ast().add(type, nullptr, items);
+}
+
+// ===== 基本节点 =====
+
+inline NodeId create_literal(Parser& parser, const Token* tok) {
+    return parser.ast().add(NodeType::Literal, tok);
+}
+
+inline NodeId create_identifier(Parser& parser, const Token* tok) {
+    return parser.ast().add(NodeType::Identifier, tok);
+}
+
+// ===== 表达式 =====
+
+inline NodeId create_binary_expr(Parser& parser, const Token* op, NodeId left, NodeId right) {
+    const NodeId children[] = {left, right};
+    return parser.ast().add(NodeType::BinaryExpr, op, children);
+}
+
+inline NodeId create_unary_expr(Parser& parser, const Token* op, NodeId operand) {
+    return parser.ast().add(NodeType::UnaryExpr, op, {&operand, 1});
+}
+
+inline NodeId create_call_expr(Parser& parser, NodeId callee, const NodeList& args) {
+    // children: [callee, arg1, arg2, ...]
+    return parser.ast().add(NodeType::CallExpr, nullptr, callee, args);
+}
+
+inline NodeId create_index_expr(Parser& parser, NodeId target, NodeId index) {
+    const NodeId children[] = {target, index};
+    return parser.ast().add(NodeType::IndexExpr, nullptr, children);
+}
+
+// from / to 为 kNoNode 时省略，由标志位区分 a[i:] 与 a[:j]
+inline NodeId create_slice_expr(Parser& parser, NodeId target, NodeId from, NodeId to) {
+    NodeId children[3];
+    size_t count = 0;
+    uint8_t flags = 0;
+    children[count++] = target;
+    if (from != kNoNode) {
+        children[count++] = from;
+        flags |= ASTNode::kSliceFrom;
+    }
+    if (to != kNoNode) {
+        children[count++] = to;
+        flags |= ASTNode::kSliceTo;
+    }
+    return parser.ast().add(NodeType::SliceExpr, nullptr, {children, count}, flags);
+}
+
+inline NodeId create_field_expr(Parser& parser, NodeId target, const Token* field) {
+    return parser.ast().add(NodeType::FieldExpr, field, {&target, 1});
+}
+
+inline NodeId create_ref_expr(Parser& parser, NodeId target) {
+    return parser.ast().add(NodeType::RefExpr, nullptr, {&target, 1});
+}
+
+// ===== 容器 =====
+
+inline NodeId create_tuple_expr(Parser& parser, NodeId first, const NodeList& rest, bool trailing_comma) {
+    return parser.ast().add(NodeType::TupleExpr, nullptr, first, rest,
+                            trailing_comma ? ASTNode::kTrailingComma : 0);
+}
+
+inline NodeId create_list_expr(Parser& parser, const NodeList& elements) {
+    return parser.ast().add(NodeType::ListExpr, nullptr, elements);
+}
+
+inline NodeId create_dict_expr(Parser& parser, const NodeList& pairs) {
+    return parser.ast().add(NodeType::DictExpr, nullptr, pairs);
+}
+
+inline NodeId create_dict_pair(Parser& parser, NodeId key, NodeId value) {
+    const NodeId children[] = {key, value};
+    return parser.ast().add(NodeType::DictPair, nullptr, children);
+}
+
+// ===== Block 和 Scope =====
+
+inline NodeId create_block_expr(Parser& parser, const NodeList& stmts, bool use_tail) {
+    return parser.ast().add(NodeType::BlockExpr, nullptr, stmts,
+                            use_tail ? ASTNode::kUseTail : 0);
+}
+
+inline NodeId create_scope_expr(Parser& parser, const NodeList& stmts, bool use_tail) {
+    return parser.ast().add(NodeType::ScopeExpr, nullptr, stmts,
+                            use_tail ? ASTNode::kUseTail : 0);
+}
+
+// ===== 控制流 =====
+
+inline NodeId create_if_expr(Parser& parser, NodeId cond, NodeId then_block, NodeId else_expr) {
+    const NodeId children[] = {cond, then_block, else_expr};
+    const size_t count = else_expr != kNoNode ? 3 : 2;
+    return parser.ast().add(NodeType::IfExpr, nullptr, {children, count});
+}
+
+inline NodeId create_loop_expr(Parser& parser, const Token* label, NodeId body) {
+    return parser.ast().add(NodeType::LoopExpr, label, {&body, 1});
+}
+
+// ===== 语句 =====
+
+inline NodeId create_let_stmt(Parser& parser, const NodeList& targets, NodeId rhs) {
+    const NodeId children[] = {
+        create_list_node(parser, NodeType::LetTargetList, targets),
+        rhs,
+    };
+    const bool is_import = rhs == kNoNode;
+    return parser.ast().add(NodeType::LetStmt, nullptr, {children, is_import ? 1u : 2u},
+                            is_import ? ASTNode::kIsImport : 0);
+}
+
+inline NodeId create_let_target(Parser& parser, const Token* name, NodeId type_hint, bool is_ref) {
+    return parser.ast().add(NodeType::LetTarget, name, type_hint, {},
+                            is_ref ? ASTNode::kIsRef : 0);
+}
+
+inline NodeId create_del_stmt(Parser& parser, const NodeList& idents) {
+    NodeId ident_list = create_list_node(parser, NodeType::IdentList, idents);
+    return parser.ast().add(NodeType::DelStmt, nullptr, {&ident_list, 1});
+}
+
+inline NodeId create_break_stmt(Parser& parser, const Token* label, NodeId value) {
+    return parser.ast().add(NodeType::BreakStmt, label, value, {});
+}
+
+inline NodeId create_return_stmt(Parser& parser, NodeId value) {
+    return parser.ast().add(NodeType::ReturnStmt, nullptr, value, {});
+}
+
+inline NodeId create_expr_stmt(Parser& parser, NodeId expr) {
+    return parser.ast().add(NodeType::ExprStmt, nullptr, {&expr, 1});
+}
+
+// ===== Prim =====
+
+inline NodeId create_unnamed_prim(Parser& parser, const NodeList& decorators, NodeId scope) {
+    const NodeId children[] = {
+        create_list_node(parser, NodeType::DecoratorList, decorators),
+        scope,
+    };
+    return parser.ast().add(NodeType::UnnamedPrim, nullptr, children);
+}
+
+inline NodeId create_named_prim(Parser& parser, const NodeList& decorators, const Token* name,
+                                const NodeList& params, NodeId return_type, NodeId impl) {
+    NodeId children[4];
+    size_t count = 0;
+    children[count++] = create_list_node(parser, NodeType::DecoratorList, decorators);
+    children[count++] = create_list_node(parser, NodeType::ParamList, params);
+    if (return_type != kNoNode) {
+        children[count++] = return_type;
+    }
+    children[count++] = impl;
+    return parser.ast().add(NodeType::NamedPrim, name, {children, count});
+}
+
+inline NodeId create_param(Parser& parser, const Token* name, NodeId type_hint, bool is_ref) {
+    return parser.ast().add(NodeType::Param, name, type_hint, {},
+                            is_ref ? ASTNode::kIsRef : 0);
+}
+
+// ===== 类型提示 =====
+
+inline NodeId create_type_hint(Parser& parser, const NodeList& idents) {
+    return create_list_node(parser, NodeType::TypeHint, idents);
+}
+
+} // namespace prim::builder
@@ -0,0 +1,145 @@
+// ast_file.hpp - AST 的二进制序列化格式（mmap 只读载入）
+#pragma once
+
+#include "ast.hpp"
+#include "source.hpp"
+#include "token.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace prim {
+
+// ============================================================================
+// 文件格式（版本 2，本机字节序，各段 4 字节对齐、紧密排列）
+// ============================================================================
+//
+//   AstFileHeader
+//   ASTNode[node_count]        与内存中的节点记录相同：类型、标志位、token 下标、子节点区间
+//   NodeId[edge_count]         共享边数组，子节点 id 总是小于父节点 id
+//   AstFileToken[token_count]  节点引用的 token，按 token 下标排列（数字字面量带解码后的值，不含符号编号）
+//   char[string_bytes]         字符串表：token 文本（相同文本只存一份）
+//
+// 文件不依赖源码：token 保留源码中的偏移（用于报错定位），文本从字符串表读取。
+
+struct AstFileHeader {
+    char     magic[8];      // "PRIMAST\0"
+    uint32_t version;       // AstView::kVersion
+    uint32_t byte_order;    // kAstFileByteOrder，字节序不同的机器上载入失败
+    uint32_t node_count;
+    uint32_t edge_count;
+    uint32_t token_count;
+    uint32_t string_bytes;
+    uint32_t root;          // 根节点，kNoNode 表示空树
+    uint32_t reserved;
+};
+
+struct AstFileToken {
+    uint32_t  begin;     // 源码中的起始偏移
+    uint32_t  length;    // 文本长度
+    TokenType type;
+    ErrType   err;
+    uint32_t  emsg;      // ErrMsg 的 4 个字节
+    uint32_t  text;      // 文本在字符串表中的偏移
+    uint32_t  value_lo;  // 数字字面量值的低 32 位（拆开存放，记录保持 4 字节对齐）
+    uint32_t  value_hi;  // 数字字面量值的高 32 位
+
+    [[nodiscard]] ErrMsg err_msg() const noexcept { return std::bit_cast<ErrMsg>(emsg); }
+    [[nodiscard]] TokenValue value() const noexcept {
+        return TokenValue(uint64_t(value_hi) << 32 | value_lo);
+    }
+};
+
+inline constexpr uint32_t kAstFileByteOrder = 0x01020304;
+
+static_assert(sizeof(AstFileHeader) == 40);
+static_assert(sizeof(AstFileToken) == 28);
+
+// ============================================================================
+// AstView - 序列化 AST 的只读视图
+// ============================================================================
+//
+// 直接引用字节区（通常是 mmap 的文件），不为节点分配内存；
+// from_bytes() 一次性校验所有下标与区间，之后的访问不再检查。
+
+class AstView {
+public:
+    static constexpr uint32_t kVersion = 3;
+
+    AstView() = default;
+
+    /**
+     * 校验并引用 bytes（须 4 字节对齐，生命周期长于视图）
+     * @return 魔数、版本、字节序、段长度或任一下标不合法时返回 nullopt
+     */
+    static std::optional<AstView> from_bytes(std::string_view bytes);
+
+    // ===== 访问（与 Ast 的同名接口一致）=====
+
+    [[nodiscard]] const ASTNode& operator[](NodeId id) const { return nodes_[id]; }
+
+    [[nodiscard]] std::span<const NodeId> children(NodeId id) const {
+        const ASTNode& n = nodes_[id];
+        return {edges_ + n.first_child, n.child_count};
+    }
+
+    [[nodiscard]] const AstFileToken* token(NodeId id) const {
+        const ASTNode& n = nodes_[id];
+        return n.token == ASTNode::kNoToken ? nullptr : tokens_ + n.token;
+    }
+
+    [[nodiscard]] std::string_view text(const AstFileToken& tok) const {
+        return strings_.substr(tok.text, tok.length);
+    }
+
+    [[nodiscard]] NodeId root() const noexcept { return root_; }
+    [[nodiscard]] size_t size() const noexcept { return node_count_; }
+    [[nodiscard]] size_t edge_count() const noexcept { return edge_count_; }
+    [[nodiscard]] size_t token_count() const noexcept { return token_count_; }
+
+private:
+    const ASTNode*      nodes_       = nullptr;
+    const NodeId*       edges_       = nullptr;
+    const AstFileToken* tokens_      = nullptr;
+    std::string_view    strings_;
+    uint32_t            node_count_  = 0;
+    uint32_t            edge_count_  = 0;
+    uint32_t            token_count_ = 0;
+    NodeId              root_        = kNoNode;
+};
+
+// ============================================================================
+// AstFile - mmap 载入的 AST 文件
+// ============================================================================
+
+class AstFile {
+public:
+    /**
+     * 只读映射并校验 path
+     * @return 无法打开或格式不合法时返回 nullopt
+     */
+    static std::optional<AstFile> open(const std::string& path);
+
+    [[nodiscard]] const AstView& view() const noexcept { return view_; }
+    [[nodiscard]] const AstView* operator->() const noexcept { return &view_; }
+
+private:
+    SourceBuffer data_;  // 移动时映射地址不变，view_ 保持有效
+    AstView      view_;
+};
+
+/**
+ * 把 ast 序列化为上述格式（token 文本取自解析时的源码，源码须仍然有效）
+ */
+std::string serialize_ast(const Ast& ast);
+
+/**
+ * 序列化并原子地写入 path（见 write_file_atomic）
+ */
+bool write_ast_file(const std::string& path, const Ast& ast);
+
+} // namespace prim
@@ -0,0 +1,48 @@
+// batch.hpp - 多文件批量检查（工作窃取线程池）
+#pragma once
+
+#include "parse_error.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace prim {
+
+class ParseCache;
+
+// ============================================================================
+// FileReport - 单个文件的检查结果
+// ============================================================================
+
+struct FileReport {
+    std::string             path;
+    bool                    opened = false;               // 无法打开 / 映射时为 false
+    size_t                  bytes  = 0;                   // 文件大小
+    std::vector<ParseError> errors;                       // 词法 + 语法错误（字节偏移）
+    bool                    error_limit_reached = false;  // 是否因错误数上限提前停止
+};
+
+/**
+ * 展开命令行输入：目录递归收集其中的 .prim 文件（按路径排序），其余参数原样保留
+ * - 不存在的路径同样原样保留，由 check_files() 报告无法打开
+ */
+std::vector<std::string> expand_inputs(const std::vector<std::string>& inputs);
+
+/**
+ * 并行检查（词法 + 语法分析）所有文件
+ * @param paths      待检查的文件
+ * @param jobs       线程数，0 表示 std::thread::hardware_concurrency()
+ * @param max_errors 每个文件最多记录的错误数（见 Parser::set_error_limit）
+ * @param cache      可选的解析缓存：命中的文件直接取缓存的错误，未命中的解析后写入
+ * @return 与 paths 一一对应、顺序相同的结果，输出顺序与调度无关
+ *
+ * 注意：
+ * - 每个线程持有一个 Parser（AST 存储、ParseArena、token 存储），在处理的各个文件之间复用
+ * - 文件按下标连续均分给各线程；线程处理完自己的部分后，从其他线程剩余的部分逐个窃取
+ * - 结果中只保留错误，AST 随下一个文件的解析回收
+ */
+std::vector<FileReport> check_files(const std::vector<std::string>& paths,
+                                    size_t jobs, size_t max_errors,
+                                    const ParseCache* cache = nullptr);
+
+} // namespace prim
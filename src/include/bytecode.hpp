@@ -0,0 +1,135 @@
+// bytecode.hpp - 寄存器式字节码（编译器的输出，虚拟机的输入）
+#pragma once
+
+#include "source.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace prim {
+
+// ============================================================================
+// Op - 操作码
+// ============================================================================
+//
+// R[x] 是当前帧的第 x 个寄存器，K[x] 是当前 prim 常量池的第 x 项，G[x] 是第 x 个全局变量，
+// sbc 是 b、c 拼成的有符号 32 位数（跳转偏移相对于下一条指令）。
+
+enum class Op : uint8_t {
+    // ===== 载入 =====
+    Move,       // R[a] = R[b]
+    LoadK,      // R[a] = K[b]
+    LoadInt,    // R[a] = sbc（32 位以内的整数不进常量池）
+    LoadNull,   // R[a] = null
+    LoadTrue,   // R[a] = true
+    LoadFalse,  // R[a] = false
+    LoadUnit,   // R[a] = ()
+    MakePrim,   // R[a] = Module::prims[b]
+
+    // ===== 全局变量 =====
+    GetGlobal,  // R[a] = G[b]，未定义时为运行时错误
+    SetGlobal,  // G[b] = R[a]
+    DelGlobal,  // 删除 G[b]
+
+    // ===== 运算 =====
+    Add,        // R[a] = R[b] + R[c]
+    Sub,        // R[a] = R[b] - R[c]
+    Mul,        // R[a] = R[b] * R[c]
+    Div,        // R[a] = R[b] / R[c]
+    Mod,        // R[a] = R[b] % R[c]
+    Eq,         // R[a] = R[b] == R[c]
+    Ne,         // R[a] = R[b] != R[c]
+    Lt,         // R[a] = R[b] < R[c]（> 交换操作数）
+    Le,         // R[a] = R[b] <= R[c]（>= 交换操作数）
+    Not,        // R[a] = !R[b]
+    Neg,        // R[a] = -R[b]
+    Pos,        // R[a] = +R[b]（检查是数字）
+
+    // ===== 跳转 =====
+    Jump,       // pc += sbc
+    JumpIf,     // R[a] 为真时 pc += sbc（false、null、() 为假）
+    JumpIfNot,  // R[a] 为假时 pc += sbc
+
+    // ===== 容器 =====
+    NewList,    // R[a] = [R[b], ..., R[b+c-1]]
+    NewTuple,   // R[a] = (R[b], ..., R[b+c-1])
+    NewDict,    // R[a] = {R[b]: R[b+1], ...}，共 c 对
+    Index,      // R[a] = R[b][R[c]]
+    SetIndex,   // R[a][R[b]] = R[c]
+    Slice,      // R[a] = R[b][R[c] : R[c+1]]，省略的下标为 null
+    GetField,   // R[a] = R[b].K[c]
+    SetField,   // R[a].K[b] = R[c]
+
+    // ===== 调用 =====
+    Call,       // R[a] = R[a](R[a+1], ..., R[a+b])，被调用者的帧从 R[a+1] 开始
+    Invoke,     // R[a] = R[a].K[c](R[a+1], ..., R[a+b])：字段中的 prim，否则为以 R[a] 为第一个参数的内置方法
+    Return,     // 返回 R[a]
+};
+
+inline constexpr size_t kOpCount = size_t(Op::Return) + 1;
+
+// 操作码名（反汇编用）
+const char* op_name(Op op);
+
+// ============================================================================
+// Instr - 指令（8 字节）
+// ============================================================================
+
+struct Instr {
+    Op       op = Op::Move;
+    uint8_t  reserved = 0;
+    uint16_t a = 0;
+    uint16_t b = 0;
+    uint16_t c = 0;
+
+    [[nodiscard]] int32_t sbc() const noexcept { return int32_t(uint32_t(b) | uint32_t(c) << 16); }
+    void set_sbc(int32_t v) noexcept {
+        b = uint16_t(uint32_t(v));
+        c = uint16_t(uint32_t(v) >> 16);
+    }
+};
+
+static_assert(sizeof(Instr) == 8, "Instr 应保持 8 字节");
+
+// ============================================================================
+// Constant - 常量池的一项
+// ============================================================================
+
+struct Constant {
+    enum class Kind : uint8_t { Int, Float, String };
+
+    Kind kind = Kind::Int;
+    union {
+        int64_t i = 0;
+        double  f;
+    };
+    std::string s;  // Kind::String：解码后的字节（字段名、方法名也在这里）
+};
+
+// ============================================================================
+// Prim / Module - 编译结果
+// ============================================================================
+
+// 一个可调用的 prim（命名 prim 或顶层程序）
+struct PrimCode {
+    std::string           name;           // 顶层程序为 "<main>"
+    uint16_t              params = 0;     // 参数个数，调用时位于 R[0] ~ R[params-1]
+    uint16_t              registers = 0;  // 帧大小
+    bool                  closure_space = false;  // @struct：返回参数和顶层 let 组成的闭包空间（dict）
+    std::vector<Instr>    code;
+    std::vector<uint32_t> offsets;        // 与 code 一一对应的源码偏移（运行时错误定位）
+    std::vector<Constant> constants;
+};
+
+struct Module {
+    std::vector<PrimCode>    prims;    // prims[0] 是顶层程序
+    std::vector<std::string> globals;  // 全局变量名，下标即 G[x]（内置函数由虚拟机按名字绑定）
+};
+
+/**
+ * 反汇编整个模块（--dump-bytecode）
+ * @param lines 源码行索引，给出时每条指令后附上行号:列号
+ */
+std::string disassemble(const Module& module, const LineIndex* lines = nullptr);
+
+} // namespace prim
@@ -0,0 +1,82 @@
+// cache.hpp - 以源码内容寻址的磁盘解析缓存
+#pragma once
+
+#include "ast.hpp"
+#include "token.hpp"
+#include "parse_error.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace prim {
+
+class Parser;
+
+// ============================================================================
+// ParseResult - 从缓存载入的一次解析结果
+// ============================================================================
+//
+// AST 中的 token 指针指向 tokens，token 词素指向载入时传入的源码：
+// 源码与 ParseResult 都须在使用 AST 期间保持有效。可移动，不可拷贝。
+// 符号编号不进入缓存：tokens 的 value.sym 为 kNoSymbol，需要时用 intern_tokens() 重新驻留。
+
+struct ParseResult {
+    std::vector<Token>      tokens;  // AST 引用的 token（按节点顺序）
+    Ast                     ast;
+    std::vector<ParseError> errors;
+    bool                    error_limit_reached = false;
+
+    ParseResult() = default;
+    ParseResult(const ParseResult&) = delete;
+    ParseResult& operator=(const ParseResult&) = delete;
+    ParseResult(ParseResult&&) noexcept = default;
+    ParseResult& operator=(ParseResult&&) noexcept = default;
+};
+
+// ============================================================================
+// ParseCache - 解析结果的磁盘缓存
+// ============================================================================
+//
+// - 键：源码内容的 XXH64（两个种子，共 128 位）+ 语法指纹（parser.y / lexer.re 的哈希、
+//   缓存格式版本、AST 布局）+ 错误数上限；语法或格式变化后旧条目自然失效
+// - 每个条目一个文件 <dir>/<键>.ast：先写入同目录的临时文件再 rename()，
+//   并发的多个进程看到的要么是旧文件，要么是完整的新文件
+// - 载入时校验魔数、版本、指纹与各段长度，任何不一致都按未命中处理
+// - 不做淘汰，需要时直接删除缓存目录
+// - 成员只读，多个线程可以共用同一个 ParseCache
+
+class ParseCache {
+public:
+    static constexpr uint32_t kFormatVersion = 2;
+
+    explicit ParseCache(std::filesystem::path dir) : dir_(std::move(dir)) {}
+
+    // 默认缓存目录：$XDG_CACHE_HOME/prim，其次 $HOME/.cache/prim；都没有时返回空路径
+    static std::filesystem::path default_dir();
+
+    const std::filesystem::path& dir() const { return dir_; }
+
+    /**
+     * 查找 source 的缓存条目
+     * @param error_limit 解析时使用的错误数上限（结果与它有关，参与键的计算）
+     * @return 命中时返回解析结果（token 词素指向 source），否则返回 nullopt
+     */
+    std::optional<ParseResult> load(std::string_view source, size_t error_limit) const;
+
+    /**
+     * 保存 parser 最近一次解析 source 的结果
+     * @return 写入成功返回 true；失败（目录不可写等）不影响调用方，只是下次不会命中
+     */
+    bool store(std::string_view source, size_t error_limit, const Parser& parser) const;
+
+private:
+    std::filesystem::path entry_path(std::string_view source, size_t error_limit) const;
+
+    std::filesystem::path dir_;
+};
+
+} // namespace prim
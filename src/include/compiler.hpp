@@ -0,0 +1,49 @@
+// compiler.hpp - AST 到寄存器式字节码的编译器
+#pragma once
+
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace prim {
+
+// ============================================================================
+// 编译错误
+// ============================================================================
+
+struct CompileError {
+    uint32_t    offset = 0;  // 源码偏移（出错节点的第一个 token）
+    std::string message;
+};
+
+// ============================================================================
+// compile - 把语法分析成功的 Program 编译为 Module
+// ============================================================================
+//
+// 作用域与存储：
+// - 顶层的 let 和命名 prim 是全局变量，运行时按下标（Module::globals）访问，
+//   因此 prim 可以引用之后才定义的全局变量，也可以递归
+// - 块、prim 内的变量分配在寄存器中（按作用域栈式分配，临时值位于变量之上），
+//   块结束后寄存器立即复用；读取外层 prim 的局部变量是编译错误（尚不支持捕获）
+// - let x = &y 在编译期把 x 绑定到 y 的存储（寄存器或全局变量），不产生指令
+//
+// 控制流：
+// - if / loop / 块的值直接写入目标寄存器
+// - break `label` value 把值写入对应 loop 的目标寄存器，再跳到该 loop 之后（编译期回填）；
+//   不能跨越 prim 或 scope 的边界，标签不存在是编译错误
+// - && / || 短路求值，结果是决定结果的那个操作数
+//
+// 常量池按 prim 去重；32 位以内的整数直接编码在 LoadInt 中。
+// 出错时继续编译其余语句，一次报告全部错误。
+
+/**
+ * @param ast    语法分析没有错误的 AST（根为 Program）
+ * @param errors 编译错误（追加）
+ * @return 没有错误时返回 Module，否则返回 nullopt
+ */
+std::optional<Module> compile(const Ast& ast, std::vector<CompileError>& errors);
+
+} // namespace prim
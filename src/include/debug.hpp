@@ -7,6 +7,7 @@
 #include <magic_enum.hpp>
 
 #include "token.hpp"
+#include "source.hpp"
 
 namespace prim {
 
@@ -16,18 +17,26 @@ using fmt::print, fmt::println;
 // Token 列表打印
 // ============================================================================
 
-inline void print_tokens(const std::vector<Token>& tokens) {
+// lines 用于把 token 的偏移换算成行列号
+inline void print_tokens(const std::vector<Token>& tokens, const LineIndex& lines) {
     for (size_t i = 0; i < tokens.size(); ++i) {
         const auto& token = tokens[i];
         
         print("[{:3}] ", i);
         print("{:<15} ", magic_enum::enum_name(token.type));
         
-        if (!token.text.empty()) {
-            print("'{}'", token.text);
+        if (token.length != 0) {
+            print("'{}'", token.text());
+        }
+        if (token.is_number()) {
+            // 解码后的值（与原文相同时省略，如普通十进制整数）
+            const std::string value = token.type == TokenType::FLOAT_DEC ? fmt::format("{}", token.value.f)
+                                                                         : fmt::format("{}", token.value.u);
+            if (value != token.text()) print(" = {}", value);
         }
         
-        print(" @ {}:{}", token.begin.line, token.begin.col);
+        const Location loc = lines.locate(token.begin);
+        print(" @ {}:{}", loc.line, loc.col);
         
         if (token.err != ErrType::None) {
             print(" [ERROR: {}]", magic_enum::enum_name(token.err));
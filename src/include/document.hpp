@@ -0,0 +1,123 @@
+// document.hpp - 支持增量重新分析的源码文档（编辑器 / LSP 集成）
+#pragma once
+
+#include "ast.hpp"
+#include "interner.hpp"
+#include "token.hpp"
+#include "parse_error.hpp"
+#include "parser.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace prim {
+
+// ============================================================================
+// Document - 可编辑的源码文档
+// ============================================================================
+//
+// 源码按顶层语句切成若干段（Segment），段边界取在括号深度为 0 的 ";" 之后
+// （连续的 ";" 归入同一段）。这里 lexer 处于 INITIAL 状态、括号栈为空，
+// 可以从段首重新开始词法分析，得到的 token 与从文件开头分析完全一致。
+//
+// - 每段持有自己的源码、token 和 AST，其中的偏移都相对于段首；
+//   编辑只改动覆盖到的段，其余段的 token 指针和 AST 节点保持不变
+// - edit() 从受影响的第一段开始重新分析，直到新的切分重新落在旧的段边界上
+//   （例如删掉 ";" 或打开未闭合的注释 / 括号时会继续向后扩展）
+// - 一次编辑的开销与重新分析的段大小成正比；此外只有段起始偏移的平移，
+//   起始偏移单独连续存放，平移是 O(段数) 的整数加法，不访问各段对象
+// - 所有段共用一个符号表：同一名字在各段、各次编辑之间的 SymbolId 不变
+
+class Document {
+public:
+    struct Segment {
+        std::string             text;    // 段的源码
+        std::vector<Token>      tokens;  // 段内 token（不含 END），偏移相对于段首
+        Ast                     ast;     // 根节点为 Program，children: [StmtList]
+        std::vector<ParseError> errors;  // 偏移相对于段首
+
+        // 段内的顶层语句（StmtList 节点）
+        [[nodiscard]] NodeRef statements() const { return ast.ref(ast.root()).child(0); }
+    };
+
+    // 一次 edit() 的工作量
+    struct EditStats {
+        size_t relexed_bytes     = 0;  // 重新词法分析的字节数
+        size_t relexed_tokens    = 0;  // 重新生成的 token 数
+        size_t reparsed_segments = 0;  // 重新解析的段数
+        size_t reused_segments   = 0;  // 原样保留的段数
+    };
+
+    explicit Document(std::string_view text = {});
+
+    // 禁止拷贝（AST 中的 token 指针指向各段自己的存储），允许移动
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+    Document(Document&&) noexcept = default;
+    Document& operator=(Document&&) noexcept = default;
+
+    /**
+     * 把 [offset, offset + removed) 替换为 inserted，并增量重新分析
+     * @return 本次编辑的工作量；区间超出文档范围时返回 nullopt，文档不变
+     *
+     * 注意：
+     * - 受影响段的 Segment 对象被替换，之前取得的 NodeRef / Token 指针失效；
+     *   其余段的对象及其 AST 保持不变
+     */
+    std::optional<EditStats> edit(uint32_t offset, uint32_t removed, std::string_view inserted);
+
+    // 替换全部内容（等价于对整个文档的一次编辑）
+    void assign(std::string_view text);
+
+    // ===== 查询 =====
+
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+
+    // 拼接各段得到完整源码（O(文档大小)，供需要整份文本的调用方使用）
+    [[nodiscard]] std::string text() const;
+
+    // 各段，按偏移排列；至少有一段（空文档为一个空段）
+    [[nodiscard]] const std::vector<std::unique_ptr<Segment>>& segments() const noexcept {
+        return segments_;
+    }
+
+    // 第 index 段段首在文档中的偏移
+    [[nodiscard]] uint32_t segment_start(size_t index) const { return starts_[index]; }
+
+    // 包含偏移 offset 的段下标（offset == size() 时为最后一段）
+    [[nodiscard]] size_t find_segment(uint32_t offset) const;
+
+    // 所有段的错误，偏移换算为文档偏移
+    [[nodiscard]] std::vector<ParseError> diagnostics() const;
+
+    [[nodiscard]] bool has_errors() const noexcept;
+
+    // 顶层语句总数
+    [[nodiscard]] size_t statement_count() const;
+
+    // 文档的符号表（IDENT / LABEL / STRING token 的 value.sym 在其中有效）
+    [[nodiscard]] const Interner& symbols() const noexcept { return symbols_; }
+
+    // 设置每段解析时最多记录的错误数（见 Parser::set_error_limit），对之后的编辑生效
+    void set_error_limit(size_t limit) { parser_.set_error_limit(limit); }
+
+private:
+    using SegmentPtr = std::unique_ptr<Segment>;
+
+    // 把旧段 [first, last) 替换为对 region 重新分析得到的段（region 从 segments_[first] 的段首开始）
+    EditStats rebuild(size_t first, size_t last, std::string region);
+
+    // 解析一段已经切好的 token，结果存入 seg
+    void parse_segment(Segment& seg);
+
+    std::vector<SegmentPtr> segments_;
+    std::vector<uint32_t>   starts_;   // 各段段首偏移，与 segments_ 一一对应
+    size_t size_ = 0;  // 文档总字节数
+    Parser parser_;    // 重新解析各段时复用（AST 解析完即移入段中）
+    Interner symbols_; // 只增不减：删除的名字仍占有编号，直到文档销毁
+};
+
+} // namespace prim
@@ -0,0 +1,109 @@
+// hash.hpp - 内容哈希（XXH64）
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace prim {
+
+// ============================================================================
+// xxh64 - XXH64 非加密哈希
+// ============================================================================
+//
+// 与 xxHash 官方实现的 XXH64 结果相同（小端机器），用于缓存键等内容寻址场景。
+// 每 32 字节做 4 路并行的乘-移位混合，吞吐量在 GB/s 量级，远快于词法分析本身。
+
+namespace detail {
+
+inline constexpr uint64_t kXxhPrime1 = 0x9E3779B185EBCA87ULL;
+inline constexpr uint64_t kXxhPrime2 = 0xC2B2AE3D27D4EB4FULL;
+inline constexpr uint64_t kXxhPrime3 = 0x165667B19E3779F9ULL;
+inline constexpr uint64_t kXxhPrime4 = 0x85EBCA77C2B2AE63ULL;
+inline constexpr uint64_t kXxhPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t xxh_read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t xxh_read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * kXxhPrime2;
+    acc = std::rotl(acc, 31);
+    return acc * kXxhPrime1;
+}
+
+inline uint64_t xxh_merge(uint64_t acc, uint64_t val) {
+    acc ^= xxh_round(0, val);
+    return acc * kXxhPrime1 + kXxhPrime4;
+}
+
+} // namespace detail
+
+inline uint64_t xxh64(const void* data, size_t size, uint64_t seed = 0) {
+    using namespace detail;
+    const auto* p   = static_cast<const unsigned char*>(data);
+    const auto* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + kXxhPrime1 + kXxhPrime2;
+        uint64_t v2 = seed + kXxhPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kXxhPrime1;
+        do {
+            v1 = xxh_round(v1, xxh_read64(p));
+            v2 = xxh_round(v2, xxh_read64(p + 8));
+            v3 = xxh_round(v3, xxh_read64(p + 16));
+            v4 = xxh_round(v4, xxh_read64(p + 24));
+            p += 32;
+        } while (end - p >= 32);
+
+        h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+        h = xxh_merge(h, v1);
+        h = xxh_merge(h, v2);
+        h = xxh_merge(h, v3);
+        h = xxh_merge(h, v4);
+    } else {
+        h = seed + kXxhPrime5;
+    }
+
+    h += uint64_t(size);
+
+    for (; end - p >= 8; p += 8) {
+        h ^= xxh_round(0, xxh_read64(p));
+        h = std::rotl(h, 27) * kXxhPrime1 + kXxhPrime4;
+    }
+    if (end - p >= 4) {
+        h ^= uint64_t(xxh_read32(p)) * kXxhPrime1;
+        h = std::rotl(h, 23) * kXxhPrime2 + kXxhPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= uint64_t(*p) * kXxhPrime5;
+        h = std::rotl(h, 11) * kXxhPrime1;
+    }
+
+    // 雪崩
+    h ^= h >> 33;
+    h *= kXxhPrime2;
+    h ^= h >> 29;
+    h *= kXxhPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+inline uint64_t xxh64(std::string_view text, uint64_t seed = 0) {
+    return xxh64(text.data(), text.size(), seed);
+}
+
+} // namespace prim
@@ -0,0 +1,134 @@
+// interner.hpp - 标识符与字符串驻留（符号表）
+#pragma once
+
+#include "hash.hpp"
+#include "string_literal.hpp"
+#include "token.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace prim {
+
+// ============================================================================
+// Interner - 符号表
+// ============================================================================
+//
+// 每个不同的字节串对应一个稠密的 SymbolId（从 1 开始按首次出现的顺序分配），
+// 之后的阶段（作用域解析、FieldExpr 字段查找）比较整数而不是字符串。
+// - 字节拷贝到分块存储中，view() 返回的 string_view 在 Interner 销毁前一直有效，
+//   与源码缓冲区的生命周期无关
+// - 开放寻址（线性探测）哈希表，槽位同时存哈希值，探测时不访问字节存储；
+//   负载因子不超过 1/2，容量翻倍时只搬移槽位，已分配的编号和字节不动
+// - 不是线程安全的：多线程词法分析时由调用方串行驻留（见 intern_tokens）
+
+class Interner {
+public:
+    Interner();
+
+    // 禁止拷贝，允许移动（移动不改变字节地址）
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+    Interner(Interner&&) noexcept = default;
+    Interner& operator=(Interner&&) noexcept = default;
+
+    // 返回 text 的符号，首次出现时分配新编号
+    SymbolId intern(std::string_view text) {
+        const uint32_t hash = hash_of(text);
+        for (uint32_t i = hash & mask_;; i = (i + 1) & mask_) {
+            const Slot& slot = slots_[i];
+            if (slot.id == kNoSymbol) return insert(text, hash, i);
+            if (slot.hash == hash && view(slot.id) == text) return slot.id;
+        }
+    }
+
+    // 查找 text 的符号，不存在时返回 kNoSymbol（不分配）
+    [[nodiscard]] SymbolId find(std::string_view text) const {
+        const uint32_t hash = hash_of(text);
+        for (uint32_t i = hash & mask_;; i = (i + 1) & mask_) {
+            const Slot& slot = slots_[i];
+            if (slot.id == kNoSymbol) return kNoSymbol;
+            if (slot.hash == hash && view(slot.id) == text) return slot.id;
+        }
+    }
+
+    // 符号对应的字节串（kNoSymbol 为空串）
+    [[nodiscard]] std::string_view view(SymbolId id) const {
+        const Entry& e = entries_[id];
+        return {e.data, e.length};
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return entries_.size() - 1; }  // 符号数（不含 kNoSymbol）
+    [[nodiscard]] size_t bytes() const noexcept { return bytes_; }              // 驻留的字节总数
+
+private:
+    struct Slot {
+        uint32_t hash = 0;
+        SymbolId id   = kNoSymbol;  // kNoSymbol 表示空槽
+    };
+
+    struct Entry {
+        const char* data   = nullptr;
+        uint32_t    length = 0;
+    };
+
+    static constexpr size_t kFirstSlots = 256;        // 初始槽位数（2 的幂）
+    static constexpr size_t kChunkSize  = 64 * 1024;  // 字节存储的块大小
+
+    static uint32_t hash_of(std::string_view text) {
+        return uint32_t(xxh64(text));
+    }
+
+    SymbolId insert(std::string_view text, uint32_t hash, uint32_t slot);  // 在空槽 slot 处新建符号
+    const char* store(std::string_view text);                              // 拷贝字节，返回稳定地址
+    void grow();                                                           // 槽位数翻倍并重新散列
+
+    std::vector<Slot>                    slots_;
+    uint32_t                             mask_ = 0;  // slots_.size() - 1
+    std::vector<Entry>                   entries_;   // 下标即 SymbolId，entries_[0] 对应 kNoSymbol
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    char*                                free_ = nullptr;  // 当前块的空闲起点
+    size_t                               left_ = 0;        // 当前块的剩余字节
+    size_t                               bytes_ = 0;
+};
+
+// ============================================================================
+// 按 token 驻留
+// ============================================================================
+
+/**
+ * 为 IDENT / LABEL / STRING token 分配符号（写入 tok.value.sym），其他 token 不变
+ * - 标签去掉两端反引号，`outer loop` 与标识符 outer loop 的文本相同
+ * - 字符串去掉引号并解码转义（见 decode_string_literal），"\x41" 与 "A" 是同一个符号
+ * @param scratch 解码字符串用的缓冲区，在多次调用间复用
+ */
+inline void intern_token(Token& tok, Interner& symbols, std::string& scratch) {
+    switch (tok.type) {
+        case TokenType::IDENT:
+            tok.value.sym = symbols.intern(tok.text());
+            break;
+        case TokenType::LABEL:
+            tok.value.sym = symbols.intern(tok.text().substr(1, tok.length - 2));
+            break;
+        case TokenType::STRING:
+            decode_string_literal(tok.text(), scratch);
+            tok.value.sym = symbols.intern(scratch);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * 顺序驻留一组 token（并行词法分析或缓存载入的结果）
+ */
+inline void intern_tokens(std::span<Token> tokens, Interner& symbols) {
+    std::string scratch;
+    for (Token& tok : tokens) intern_token(tok, symbols, scratch);
+}
+
+} // namespace prim
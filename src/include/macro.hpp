@@ -24,6 +24,15 @@
     #define PLATFORM_MACOS_ 1
 #endif
 
+// ============================================================================
+// 架构检测
+// ============================================================================
+#if defined(__x86_64__) || defined(_M_X64)
+    #define ARCH_X64_ 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define ARCH_ARM64_ 1
+#endif
+
 // ============================================================================
 // 分支预测优化
 // ============================================================================
@@ -191,3 +200,40 @@
         return pos;
     }
 #endif
+
+// ============================================================================
+// 位计数
+// ============================================================================
+// popcount_: 统计 32 位整数中 1 的个数
+// ctz_: 最低位 1 的位置（x 不能为 0）
+//
+// 用法示例:
+//   int n = popcount_(mask);   // 掩码中命中的字节数
+//   int i = ctz_(mask);        // 第一个命中的字节
+
+#if defined(COMPILER_GCC_) || defined(COMPILER_CLANG_)
+    #define popcount_(x) __builtin_popcount(x)
+    #define ctz_(x) __builtin_ctz(x)
+#elif defined(COMPILER_MSVC_)
+    #include <bit>
+    #include <intrin.h>
+    force_inline_ int popcount_(unsigned int x) {
+        return std::popcount(x);
+    }
+    force_inline_ int ctz_(unsigned int x) {
+        unsigned long index;
+        _BitScanForward(&index, x);
+        return (int)index;
+    }
+#else
+    force_inline_ int popcount_(unsigned int x) {
+        int n = 0;
+        for (; x; x &= x - 1) n++;
+        return n;
+    }
+    force_inline_ int ctz_(unsigned int x) {
+        int pos = 0;
+        while (!(x & 1)) { x >>= 1; pos++; }
+        return pos;
+    }
+#endif
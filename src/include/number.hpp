@@ -0,0 +1,85 @@
+// number.hpp - 数字字面量解码（词法分析时调用）
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace prim {
+
+// ============================================================================
+// 数字字面量解码
+// ============================================================================
+//
+// 输入是词法规则已经验证过的词素（INT_* / FLOAT_DEC），可能含 ' 分隔符：
+// - 整数按前缀确定基数，逐位累加并检查是否超出 uint64 范围
+// - 浮点数去掉分隔符后交给 std::from_chars（与语言环境无关，结果正确舍入）
+// 超出范围时返回 nullopt，由 lexer 报告 NumberOutOfRange。
+
+/**
+ * 解码整数字面量（0x / 0o / 0b 前缀或十进制）
+ * @return 超过 UINT64_MAX 时返回 nullopt
+ */
+inline std::optional<uint64_t> decode_int_literal(std::string_view text) {
+    unsigned base = 10;
+    if (text.size() > 2 && text[0] == '0') {
+        switch (text[1]) {
+            case 'x': case 'X': base = 16; text.remove_prefix(2); break;
+            case 'o': case 'O': base = 8;  text.remove_prefix(2); break;
+            case 'b': case 'B': base = 2;  text.remove_prefix(2); break;
+            default: break;
+        }
+    }
+
+    const uint64_t limit = UINT64_MAX / base;
+    uint64_t value = 0;
+    for (char c : text) {
+        unsigned digit;
+        if (c >= '0' && c <= '9')      digit = unsigned(c - '0');
+        else if (c >= 'a' && c <= 'f') digit = unsigned(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') digit = unsigned(c - 'A' + 10);
+        else continue;  // ' 分隔符
+
+        if (value > limit || value * base > UINT64_MAX - digit) return std::nullopt;
+        value = value * base + digit;
+    }
+    return value;
+}
+
+/**
+ * 解码浮点数字面量
+ * @return 超出 double 范围（上溢）时返回 nullopt；下溢按 IEEE 754 舍入为次正规数或 0
+ */
+inline std::optional<double> decode_float_literal(std::string_view text) {
+    // 去掉分隔符（末尾留一个字节给 strtod 的 '\0'）；绝大多数字面量放得进栈上的缓冲区
+    char small[64];
+    std::string large;
+    char* buf = small;
+    if (text.size() >= sizeof(small)) {
+        large.resize(text.size() + 1);
+        buf = large.data();
+    }
+    size_t n = 0;
+    for (char c : text) {
+        if (c != '\'') buf[n++] = c;
+    }
+
+    double value = 0;
+    const auto [end, ec] = std::from_chars(buf, buf + n, value);
+    if (ec == std::errc::result_out_of_range) {
+        // from_chars 不区分上溢与下溢：下溢时取 strtod 的舍入结果（C 语言环境下与 from_chars 的语法一致）
+        buf[n] = '\0';
+        const double approx = std::strtod(buf, nullptr);
+        if (std::isinf(approx)) return std::nullopt;
+        return approx;
+    }
+    if (ec != std::errc() || end != buf + n) return std::nullopt;
+    return value;
+}
+
+} // namespace prim
@@ -0,0 +1,78 @@
+// optimizer.hpp - 编译前的 AST 优化（常量折叠、死分支消除）
+#pragma once
+
+#include "ast.hpp"
+#include "token.hpp"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace prim {
+
+// ============================================================================
+// 改写记录（--show 列出）
+// ============================================================================
+
+struct Rewrite {
+    uint32_t    offset = 0;  // 源码偏移（被改写节点的第一个 token）
+    std::string message;     // 如 "`2 * 3 + 1` -> `7`"
+};
+
+// ============================================================================
+// Optimizer - 在 Parser::parse 与 compile 之间改写 AST
+// ============================================================================
+//
+// 改写（结果与不优化时执行的结果相同）：
+// - 常量折叠：操作数都是字面量的算术、比较、! / - / +；会在运行时报错的运算
+//   （整数溢出、除以零、类型不支持）保持原样，错误仍在运行时报告
+// - && / ||：左侧是字面量时直接取决定结果的那一侧
+// - if 的条件是字面量时只保留执行的分支，没有 else 且条件为假时值为 ()
+// - 没有副作用的表达式语句（字面量和由字面量组成的容器）删除；块的最后一条语句是块的值，保留
+// - 第一条语句是跳出自身的无条件 break 的 loop 替换为 break 的值
+//
+// 输入 AST 不变，结果是新的 AST。新 AST 引用输入 AST 的 token 和 Optimizer 为折叠结果新建的 token
+// （文本是折叠后的值，不是源码原文，begin 是原表达式的起始偏移），使用新 AST 期间两者都必须有效。
+// 被删除的分支不再编译，其中的编译错误（如未知的 loop 标签）在优化后不会报告。
+
+class Optimizer {
+public:
+    /**
+     * 优化 input（Program 为根）
+     * @return 优化后的 AST，在下一次 run() 之前有效
+     */
+    const Ast& run(const Ast& input);
+
+    [[nodiscard]] const std::vector<Rewrite>& rewrites() const noexcept { return rewrites_; }
+
+    struct Folded;  // 字面量的值（见 optimizer.cpp）
+
+private:
+    NodeId visit(NodeId id);
+    NodeId copy(NodeId id);
+    NodeId stmt_list(NodeId id, bool value_discarded);
+    NodeId unary(NodeId id);
+    NodeId binary(NodeId id);
+    NodeId if_expr(NodeId id);
+    NodeId loop_expr(NodeId id);
+
+    bool constant(NodeId out, Folded& value) const;
+    NodeId literal(const Folded& value, uint32_t offset);
+    Token* make_token(TokenType type, std::string text, uint32_t offset);
+    bool pure(NodeId out) const;
+    bool contains_break(NodeId out) const;
+
+    uint32_t offset_of(NodeId in) const;
+    void render(NodeId in, std::string& out) const;
+    std::string quoted(NodeId in) const;
+    void record(NodeId in, std::string message, size_t discard_from);
+
+    const Ast*              in_ = nullptr;
+    Ast                     out_;
+    std::deque<Token>       tokens_;  // 折叠结果的 token（地址稳定）
+    std::deque<std::string> texts_;   // 上述 token 的文本
+    std::vector<Rewrite>    rewrites_;
+    uint32_t                offset_ = 0;  // 最近访问的 token 偏移（没有 token 的节点用）
+};
+
+} // namespace prim
@@ -0,0 +1,45 @@
+// parallel_lexer.hpp - 单个大文件的分块并行词法分析
+#pragma once
+
+#include "source.hpp"
+#include "token.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace prim {
+
+// ============================================================================
+// lex_parallel - 推测式分块词法分析
+// ============================================================================
+//
+// 1. 把缓冲区切成若干块，切分点取在换行之后（字符串和标签不跨行，
+//    这里只可能落在块注释内部），各块假定从 INITIAL 状态开始并行扫描，
+//    扫到第一个起始偏移越过块尾的 token 为止
+// 2. 按顺序验证：前一块（已确认正确）越过块尾的第一个 token 起始于 p，
+//    若本块的推测结果中也有起始于 p 的 token，此后两者必然一致，从这里接上；
+//    否则（切分点落在注释内等）从 p 重新扫描本块
+// 3. 各块的括号栈彼此独立，最后顺序扫一遍 token，重新判定右括号是否匹配
+//
+// 结果与串行 Lexer::next() 逐个取到第一个 END（含）的 token 序列完全相同：
+// 类型、偏移、长度、错误信息一致，行列号由同一份偏移经 LineIndex 计算。
+
+struct ParallelLexStats {
+    size_t chunks  = 0;  // 分块数（1 表示直接串行扫描）
+    size_t relexed = 0;  // 推测失败、重新扫描的块数
+};
+
+inline constexpr size_t kParallelLexMinChunk = 1 << 20;  // 每块至少 1 MB，更小的文件不值得启动线程
+
+/**
+ * 并行词法分析整个缓冲区
+ * @param source    待分析的源码（token 词素指向其中，生命周期须长于返回的 token）
+ * @param jobs      线程数，0 表示 std::thread::hardware_concurrency()
+ * @param min_chunk 每块的最小字节数，块数不超过 source.size() / min_chunk
+ * @param stats     可选，返回分块与重新扫描的统计
+ * @return 以 END 结尾的 token 序列（含 ERROR token）
+ */
+std::vector<Token> lex_parallel(const SourceBuffer& source, size_t jobs = 0,
+                                size_t min_chunk = kParallelLexMinChunk,
+                                ParallelLexStats* stats = nullptr);
+
+} // namespace prim
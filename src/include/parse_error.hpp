@@ -1,6 +1,8 @@
 #pragma once
 
 #include "token.hpp"
+#include "source.hpp"
+#include <cstdint>
 #include <string>
 #include <fmt/format.h>
 
@@ -27,16 +29,17 @@ enum class ParseErrorType {
 
 struct ParseError {
     ParseErrorType type;
-    Location location;
+    uint32_t offset;      // 出错位置的字节偏移，行列号由 LineIndex 计算
     std::string message;
     std::string context;  // 错误上下文（如出错的那一行代码）
     
     // 构造函数
-    ParseError(ParseErrorType t, Location loc, std::string msg, std::string ctx = "")
-        : type(t), location(loc), message(std::move(msg)), context(std::move(ctx)) {}
+    ParseError(ParseErrorType t, uint32_t off, std::string msg, std::string ctx = "")
+        : type(t), offset(off), message(std::move(msg)), context(std::move(ctx)) {}
     
-    // 格式化为可读的错误信息
-    std::string format() const {
+    // 格式化为可读的错误信息（lines 为出错文件的行索引）
+    std::string format(const LineIndex& lines) const {
+        const Location location = lines.locate(offset);
         std::string type_str;
         switch (type) {
             case ParseErrorType::UnexpectedToken:
@@ -3,18 +3,48 @@
 #include "ast.hpp"
 #include "token.hpp"
 #include "parse_error.hpp"
+#include "arena.hpp"
+#include <concepts>
 #include <functional>
 #include <vector>
 #include <memory>
 #include <optional>
+#include <span>
 
 namespace prim {
 
-// 前向声明 Bison 生成的 parser 类
+class Lexer;
+
+// 前向声明 Bison 生成的 parser 类和手写的 Pratt 后端
 namespace detail {
     class BisonParser;
+    class PrattParser;
 }
 
+// ============================================================================
+// ParserBackend - 语法分析后端
+// ============================================================================
+//
+// 两个后端对合法输入产生完全相同的 AST（节点 id、边、token 下标逐一相同）；
+// 有错误时第一个错误的位置相同，之后的错误恢复与部分 AST 不保证一致。
+
+enum class ParserBackend : uint8_t {
+    Bison,  // Bison 生成的 LALR(1) 分析器（默认）
+    Pratt,  // 手写：表达式用 Pratt 分析，语句、if / loop、prim 和装饰器用递归下降
+};
+
+// ============================================================================
+// TokenSource - 逐个提供 Token 的来源
+// ============================================================================
+//
+// 提供 next()（如 Lexer）或本身可调用，每次返回一个 Token，以 END 结束。
+// parse() 按具体类型实例化，取 token 时不经过 std::function 的类型擦除。
+
+template <typename S>
+concept TokenSource =
+    requires(S& s) { { s.next() } -> std::convertible_to<Token>; } ||
+    requires(S& s) { { s() } -> std::convertible_to<Token>; };
+
 // ============================================================================
 // Parser - 语法分析器
 // ============================================================================
@@ -23,6 +53,8 @@ class Parser {
 public:
     using TokenProvider = std::function<Token()>;
     
+    static constexpr size_t kDefaultErrorLimit = 100;  // 默认最多记录的错误数
+    
     // 构造和析构
     Parser();
     ~Parser();
@@ -41,11 +73,70 @@ public:
      * @return 如果解析成功返回 AST 根节点，否则返回 nullopt
      * 
      * 注意：
+     * - 返回的根节点引用 parser 内部的 AST 存储，下一次 parse() / reset() 后失效
+     * - 有错误时返回 nullopt，已解析出的部分 AST 见 ast().root()
      * - parser 会一直调用 token_provider 直到遇到 END token
      * - 遇到 END 后会停止解析，后续的 token 将被忽略
      * - 解析完成后调用 get_errors() 获取错误列表
+     * - 每个 token 都经过一次 std::function 调用，适合测试中注入 token；
+     *   性能敏感的场景使用 parse(Lexer&) 或 parse(TokenSource&)
+     */
+    std::optional<NodeRef> parse(TokenProvider token_provider);
+    
+    /**
+     * 直接从词法分析器拉取 token 解析
+     * @param lexer 内存模式的 Lexer（流模式下 token 词素在下一次 next() 后失效，不能进入 AST）
+     * @return 如果解析成功返回 AST 根节点，否则返回 nullopt
+     * 
+     * 注意：
+     * - Lexer::next() 内联进 yylex，token 直接构造在 parser 的 token 存储中
+     * - 词法错误记入错误列表后继续分析，遇到 END 后停止读取
      */
-    std::optional<ASTNode> parse(TokenProvider token_provider);
+    std::optional<NodeRef> parse(Lexer& lexer);
+    
+    /**
+     * 从任意 TokenSource 拉取 token 解析
+     * @param source 调用方持有的 token 来源，生命周期须覆盖本次 parse()
+     * @return 如果解析成功返回 AST 根节点，否则返回 nullopt
+     * 
+     * 注意：
+     * - 按 S 实例化取 token 的函数，每个 token 只有一次普通的函数指针调用
+     * - 返回的 token 直接构造在 parser 的 token 存储中，不再额外拷贝
+     */
+    template <TokenSource S>
+    std::optional<NodeRef> parse(S& source) {
+        reset();
+        source_ = &source;
+        source_fetch_ = &fetch_from<S>;
+        return run();
+    }
+    
+    /**
+     * 解析已收集好的 token 缓冲区（token-buffer 模式）
+     * @param tokens 词法分析阶段收集到的 token 序列（含 ERROR token），应以 END 结尾
+     * @return 如果解析成功返回 AST 根节点，否则返回 nullopt
+     * 
+     * 注意：
+     * - parser 直接引用缓冲区中的 token，不会再拷贝一份
+     * - AST 中的 token 指针指向该缓冲区，调用方需保证其生命周期长于 AST
+     * - 缓冲区耗尽时视为遇到 END
+     */
+    std::optional<NodeRef> parse(std::span<const Token> tokens);
+    
+    /**
+     * 获取 AST 存储（最近一次解析构建的所有节点）
+     */
+    const Ast& ast() const { return ast_; }
+    
+    /**
+     * 取走最近一次解析构建的 AST，之后 parser 内部的 AST 为空
+     * - 节点中的 token 指针仍指向解析时的 token 来源（token-buffer 模式下即调用方的缓冲区）
+     */
+    Ast take_ast() {
+        Ast out = std::move(ast_);
+        ast_.clear();
+        return out;
+    }
     
     // ===== 错误相关 =====
     
@@ -64,51 +155,164 @@ public:
      */
     void clear_errors() { errors_.clear(); }
     
+    /**
+     * 设置一次解析最多记录的错误数（0 表示不限）
+     * - 语法错误在 ";"、"}" 和顶层语句边界处恢复，词法错误不会中止解析，
+     *   因此一次 parse() 可以报告整个文件中的错误
+     * - 达到上限后停止分析，已解析的顶层语句仍保留在部分 AST 中
+     */
+    void set_error_limit(size_t limit) { error_limit_ = limit; }
+    size_t error_limit() const { return error_limit_; }
+    
+    /**
+     * 最近一次解析是否因错误数达到上限而提前停止
+     */
+    bool error_limit_reached() const { return error_limit_reached_; }
+    
+    // ===== 后端 =====
+    
+    /**
+     * 选择语法分析后端（对之后的 parse() 生效）
+     */
+    void set_backend(ParserBackend backend) { backend_ = backend; }
+    ParserBackend backend() const { return backend_; }
+    
     // ===== 状态管理 =====
     
     /**
-     * 重置 parser 到初始状态
+     * 重置 parser 到初始状态（错误数上限保持不变）
      * - 清空错误列表
-     * - 清空 AST 结果
+     * - 清空 AST 存储（保留已分配的容量）
+     * - 回收 ParseArena（保留最大的一块，供下一个文件复用）
      * - 重新创建内部 parser 对象
      */
     void reset();
     
 private:
     std::unique_ptr<detail::BisonParser> bison_parser_;
+    ParserBackend backend_ = ParserBackend::Bison;
     std::vector<ParseError> errors_;
-    std::optional<ASTNode> result_;
-    TokenProvider token_provider_;  // 保存当前的 token provider
-    std::vector<Token> token_storage_;  // 存储 Token 对象以保持生命周期
+    size_t error_limit_ = kDefaultErrorLimit;
+    bool error_limit_reached_ = false;
+    NodeList top_level_;  // 已归约的顶层语句（分配在 arena_ 中）
+    
+    // 错误恢复：跳过 token 时保持 "{" "}" 配对，避免丢掉半个代码块后连锁报错
+    const Token* lookahead_ = nullptr;  // 最近一次交给 Bison 的 token
+    uint32_t brace_depth_ = 0;          // 已交给 Bison 的 token 中未闭合的 "{" 数
+    uint32_t sync_depth_ = 0;           // 同步点所在的括号深度
+    bool error_pending_ = false;        // 已报告错误，等待 stmt: error 归约
+    bool syncing_ = false;              // 正在跳过 token，直到同步点
+    Ast ast_;  // 扁平 AST 存储，根节点见 ast_.root()
+    ParseArena arena_;  // 解析期临时分配（构建中的子节点列表等），reset() 时整体回收
+    Lexer* lexer_ = nullptr;  // parse(Lexer&) 时的词法分析器
+    void* source_ = nullptr;  // parse(TokenSource&) 时的 token 来源
+    const Token* (*source_fetch_)(Parser&, void*) = nullptr;  // 按来源类型实例化的取 token 函数
+    TokenArena token_storage_;  // 存储 Token 对象以保持生命周期（分块，地址稳定）
+    std::span<const Token> token_buffer_;  // token-buffer 模式下的外部 token 序列
+    size_t token_pos_ = 0;                 // token_buffer_ 中下一个待读取的位置
+    
+    // 运行所选后端并收集结果
+    std::optional<NodeRef> run();
     
-    // Bison parser 需要访问私有成员
+    // 从 S 类型的来源取一个 token，直接构造在 token_storage_ 中
+    template <TokenSource S>
+    static const Token* fetch_from(Parser& parser, void* source) {
+        S& src = *static_cast<S*>(source);
+        return parser.token_storage_.emplace([&src]() -> Token {
+            if constexpr (requires { src.next(); }) {
+                return src.next();
+            } else {
+                return src();
+            }
+        });
+    }
+    
+    // 两个后端需要访问私有成员
     friend class detail::BisonParser;
+    friend class detail::PrattParser;
     
     // ===== 内部辅助方法（由 Bison/yylex 调用，不应被外部使用）=====
 public:  // 这些方法技术上是public的，但仅供内部使用
     /**
      * 添加解析错误（由 Bison parser 调用）
-     * @internal 仅供 Bison 内部使用
+     * @internal 仅供 Bison 内部使用；达到错误数上限后丢弃并标记 error_limit_reached()
      */
     void add_error(ParseError error);
     
     /**
-     * 设置解析结果（由 Bison parser 调用）
+     * 把词法错误 token 转换为 ParseError 并记录（由 yylex 和 Pratt 后端调用）
+     * @internal
+     */
+    void add_lex_error(const Token& tok);
+    
+    /**
+     * 标记刚发生语法 / 词法错误（由 BisonParser::error 和 yylex 调用）
+     * @internal 之后 stmt: error 归约时由 begin_sync() 决定如何同步
+     */
+    void note_syntax_error() { error_pending_ = true; }
+    
+    /**
+     * stmt: error 归约时调用，开始同步到下一个语句边界
+     * @internal 返回 true 表示出错的向前看 token 应丢弃（yyclearin），
+     *           之后 yylex 跳过 token 直到同深度的 ";"、闭合当前块的 "}" 或 END
+     */
+    bool begin_sync();
+    
+    /**
+     * 是否正在跳过 token（由 yylex 调用）
+     * @internal
+     */
+    bool syncing() const { return syncing_; }
+    
+    /**
+     * 从 tok 开始跳过 token 直到同步点，返回同步点的 token（由 yylex 调用）
+     * @internal 跳过的词法错误仍会记录
+     */
+    const Token* skip_to_sync(const Token* tok);
+    
+    /**
+     * 记录交给 Bison 的 token 并维护括号深度（由 yylex 调用）
+     * @internal
+     */
+    void set_lookahead(const Token* tok) { lookahead_ = tok; }
+    void open_brace() { ++brace_depth_; }
+    void close_brace() { if (brace_depth_ > 0) --brace_depth_; }
+    
+    /**
+     * 记录一条已归约的顶层语句（由 Bison parser 调用，kNoNode 表示出错的语句，忽略）
      * @internal 仅供 Bison 内部使用
      */
-    void set_result(ASTNode node);
+    void add_top_level(NodeId stmt);
     
     /**
-     * 获取下一个 token（由 yylex 调用）
-     * @internal 仅供 yylex 内部使用
+     * 用已记录的顶层语句构建 Program 节点并设为根节点（由 Bison parser 调用）
+     * @internal 仅供 Bison 内部使用；Bison 中止时由 run() 调用以保留部分 AST
      */
-    Token next_token();
+    NodeId finish_program();
+    
+    /**
+     * 获取可写的 AST 存储（由 Bison 语义动作调用以构建节点）
+     * @internal 仅供 Bison 内部使用
+     */
+    Ast& ast() { return ast_; }
+    
+    /**
+     * 获取解析期分配器（由 Bison 语义动作调用）
+     * @internal 仅供 Bison 内部使用
+     */
+    ParseArena& arena() { return arena_; }
     
     /**
      * 存储 token 并返回指针（由 yylex 调用）
      * @internal 仅供 yylex 内部使用，用于保持 token 生命周期
      */
     const Token* store_token(Token tok);
+    
+    /**
+     * 取出下一个 token 的稳定指针（由 yylex 调用）
+     * @internal token-buffer 模式下直接返回缓冲区中的地址，否则在 token 存储中就地构造
+     */
+    const Token* fetch_token();
 };
 
 } // namespace prim
@@ -0,0 +1,93 @@
+// pratt_parser.hpp - 手写的语法分析后端（Pratt 表达式 + 递归下降）
+#pragma once
+
+#include "ast.hpp"
+#include "parser.hpp"
+#include "token.hpp"
+#include <initializer_list>
+
+namespace prim::detail {
+
+// ============================================================================
+// PrattParser - ParserBackend::Pratt 的实现
+// ============================================================================
+//
+// 与 parser.y 接受相同的语言，通过 ast_builder.hpp 中同样的函数、按同样的（后序）顺序建树：
+// - 表达式用 Pratt 分析：一次调用处理整条优先级链，标识符不再经过十层单产生式归约
+// - 语句、if / loop、prim 和装饰器用递归下降；"{" 开头的 dict / scope 看第一个表达式后是否为 ":"
+// - 取 token、错误数上限、括号深度的维护与 yylex 相同（Parser::fetch_token 等）
+// - 错误恢复沿用 stmt: error 的同步方式：出错后回退到最近的语句列表，
+//   由 Parser::begin_sync() 跳到同层的 ";"、闭合当前块的 "}" 或文件结束；
+//   与 Bison 一样，恢复后移进 3 个 token 之前不报告新的语法错误
+//
+// 只由 Parser::run() 在栈上创建，一次 parse() 用一个对象。
+
+class PrattParser {
+public:
+    explicit PrattParser(Parser& parser) : parser_(parser) {}
+
+    /**
+     * 分析整个 token 流并设置根节点
+     * @return 0 表示接受输入（可能有已恢复的错误），1 表示中止，与 BisonParser::parse() 相同
+     */
+    int parse();
+
+    static constexpr int kMaxDepth = 2048;  // 表达式最大嵌套深度（递归下降使用调用栈）
+
+private:
+    // ===== token =====
+    void advance();
+    const Token* consume();
+    const Token* expect(TokenType type);
+
+    // ===== 错误 =====
+    void syntax_error(std::initializer_list<TokenType> expected = {});
+    void recover();
+    bool too_deep();
+
+    // 嵌套深度计数（表达式、else if 链）
+    struct DepthGuard {
+        int& depth;
+        explicit DepthGuard(int& d) : depth(++d) {}
+        ~DepthGuard() { --depth; }
+    };
+
+    // ===== 语句 =====
+    void parse_top_level();
+    void parse_stmt_list(NodeList& stmts, NodeId stmt);
+    NodeId parse_stmt();
+    NodeId parse_let();
+    NodeId parse_let_target();
+    NodeId parse_del();
+    NodeId parse_break();
+    NodeId parse_return();
+    NodeId parse_type_hint_opt();
+
+    // ===== 表达式 =====
+    NodeId parse_expr(int min_precedence = 1);
+    NodeId parse_expr_or_ref();
+    NodeId parse_unary();
+    NodeId parse_postfix();
+    NodeId parse_primary();
+    void parse_expr_list(NodeList& items);
+    NodeId parse_paren();
+    NodeId parse_list();
+    NodeId parse_brace();
+    NodeId parse_dict(NodeId first_key);
+    NodeId parse_scope(ASTNode::NodeType type);
+    NodeId parse_if();
+    NodeId parse_loop();
+    NodeId parse_at();
+    NodeId parse_named_prim(const NodeList& decorators);
+    NodeId parse_param();
+
+    Parser&      parser_;
+    const Token* tok_  = nullptr;          // 向前看 token
+    TokenType    type_ = TokenType::END;   // 向前看 token 的类型（错误数达到上限后视为 END）
+    int          err_status_ = 0;          // 同 Bison 的 yyerrstatus_：恢复后每移进一个 token 减一
+    int          depth_      = 0;          // 当前嵌套深度
+    bool         failed_  = false;         // 出错，正在回退到最近的语句列表
+    bool         aborted_ = false;         // 恢复后未移进任何 token 就在文件结束处再次出错，停止分析
+};
+
+} // namespace prim::detail
@@ -0,0 +1,37 @@
+// simd.hpp - 词法分析用的批量扫描内核
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace prim::simd {
+
+// ============================================================================
+// 扫描内核
+// ============================================================================
+//
+// 长段空白、注释和字符串内容不走 DFA 逐字节匹配，而是由这里的内核一次跳过一整段。
+// - 内核只读取 [p, end)，返回第一个停止字节的位置，找不到时返回 end
+// - 实现在运行时按 CPU 选择：AVX2 → SSE2 → 标量
+
+using Ptr = const unsigned char*;
+
+struct Kernels {
+    const char* name;
+
+    Ptr (*skip_whitespace)(Ptr p, Ptr end);  // 跳过 [ \t\r\n]
+    Ptr (*skip_line)(Ptr p, Ptr end);        // 停在 \n \r \0（单行注释内容）
+    Ptr (*skip_string)(Ptr p, Ptr end);      // 停在 " \ \n \r \0（字符串普通内容）
+    Ptr (*skip_comment)(Ptr p, Ptr end);     // 停在 * \0（多行注释内容，可跨行）
+};
+
+// 当前使用的内核（首次调用时按 CPU 选择最快的实现）
+const Kernels& kernels();
+
+// 按名称查找内核（"scalar" / "sse2" / "avx2"），当前平台或 CPU 不支持时返回 nullptr
+const Kernels* find_kernels(std::string_view name);
+
+// 切换当前内核（用于基准对比），只影响之后创建的 Lexer
+void use_kernels(const Kernels& k);
+
+} // namespace prim::simd
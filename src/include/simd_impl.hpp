@@ -0,0 +1,119 @@
+// simd_impl.hpp - 扫描内核的通用实现，仅供 simd.cpp / simd_avx2.cpp 包含
+#pragma once
+
+#include <cstdint>
+
+#include "simd.hpp"
+#include "macro.hpp"
+
+namespace prim::simd {
+
+// 由 simd_avx2.cpp 提供；编译器未开启 AVX2 时返回 nullptr
+const Kernels* avx2_kernels();
+
+// 匿名命名空间：每个编译单元按自己的指令集选项实例化，
+// 避免 -mavx2 编译出的同名实例在链接时替换掉基线版本
+namespace {
+
+// ============================================================================
+// 标量实现（同时用于向量内核的尾部）
+// ============================================================================
+
+force_inline_ bool is_space(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline Ptr skip_whitespace_scalar(Ptr p, Ptr end) {
+    while (p < end && is_space(*p)) ++p;
+    return p;
+}
+
+inline Ptr skip_line_scalar(Ptr p, Ptr end) {
+    while (p < end && *p != '\n' && *p != '\r' && *p != '\0') ++p;
+    return p;
+}
+
+inline Ptr skip_string_scalar(Ptr p, Ptr end) {
+    while (p < end && *p != '"' && *p != '\\' && *p != '\n' && *p != '\r' && *p != '\0') ++p;
+    return p;
+}
+
+inline Ptr skip_comment_scalar(Ptr p, Ptr end) {
+    while (p < end && *p != '*' && *p != '\0') ++p;
+    return p;
+}
+
+// ============================================================================
+// 向量实现
+// ============================================================================
+//
+// V 描述一种向量宽度：
+//   V::kWidth          每次处理的字节数（不超过 32）
+//   V::load(p)         非对齐加载
+//   V::eq(v, c)        逐字节比较，返回比较结果向量
+//   V::any(a, b)       按位或
+//   V::bits(v)         每字节取最高位，压成位掩码（第 i 位对应第 i 个字节）
+
+template <class V>
+Ptr skip_whitespace_vec(Ptr p, Ptr end) {
+    constexpr uint32_t kAll = V::kWidth == 32 ? 0xFFFFFFFFu : (1u << V::kWidth) - 1;
+    while (size_t(end - p) >= V::kWidth) {
+        auto v = V::load(p);
+        auto ws = V::any(V::any(V::eq(v, ' '), V::eq(v, '\t')),
+                         V::any(V::eq(v, '\r'), V::eq(v, '\n')));
+        uint32_t stop = ~V::bits(ws) & kAll;
+        if (stop) return p + ctz_(stop);
+        p += V::kWidth;
+    }
+    return skip_whitespace_scalar(p, end);
+}
+
+template <class V>
+Ptr skip_line_vec(Ptr p, Ptr end) {
+    while (size_t(end - p) >= V::kWidth) {
+        auto v = V::load(p);
+        uint32_t stop = V::bits(V::any(V::any(V::eq(v, '\n'), V::eq(v, '\r')), V::eq(v, '\0')));
+        if (stop) return p + ctz_(stop);
+        p += V::kWidth;
+    }
+    return skip_line_scalar(p, end);
+}
+
+template <class V>
+Ptr skip_string_vec(Ptr p, Ptr end) {
+    while (size_t(end - p) >= V::kWidth) {
+        auto v = V::load(p);
+        auto quote = V::any(V::eq(v, '"'), V::eq(v, '\\'));
+        auto eol   = V::any(V::any(V::eq(v, '\n'), V::eq(v, '\r')), V::eq(v, '\0'));
+        uint32_t stop = V::bits(V::any(quote, eol));
+        if (stop) return p + ctz_(stop);
+        p += V::kWidth;
+    }
+    return skip_string_scalar(p, end);
+}
+
+template <class V>
+Ptr skip_comment_vec(Ptr p, Ptr end) {
+    while (size_t(end - p) >= V::kWidth) {
+        auto v = V::load(p);
+        uint32_t stop = V::bits(V::any(V::eq(v, '*'), V::eq(v, '\0')));
+        if (stop) return p + ctz_(stop);
+        p += V::kWidth;
+    }
+    return skip_comment_scalar(p, end);
+}
+
+template <class V>
+constexpr Kernels make_kernels(const char* name) {
+    return Kernels{
+        name,
+        skip_whitespace_vec<V>,
+        skip_line_vec<V>,
+        skip_string_vec<V>,
+        skip_comment_vec<V>,
+    };
+}
+
+} // namespace
+
+} // namespace prim::simd
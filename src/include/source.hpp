@@ -0,0 +1,106 @@
+// source.hpp - Prim 源码缓冲区（支持只读 mmap，零拷贝）
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "token.hpp"
+
+namespace prim {
+
+// ============================================================================
+// SourceBuffer - 源码缓冲区
+// ============================================================================
+//
+// 保证 data()[size()] == '\0'，Lexer 可以直接把它当作带哨兵的输入，无需拷贝。
+//
+// - map_file:    以只读方式 mmap 文件。文件长度不是页大小整数倍时，
+//                最后一页的剩余部分由内核填零，天然提供哨兵；恰好整页时，
+//                在映射之后额外保留一页匿名零页作为哨兵（guard page）。
+// - from_string: 持有一份 std::string 并在末尾追加哨兵（用于测试或非文件输入）。
+
+class SourceBuffer {
+public:
+    SourceBuffer() = default;
+    ~SourceBuffer();
+
+    // 禁止拷贝，允许移动
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    SourceBuffer(SourceBuffer&& other) noexcept;
+    SourceBuffer& operator=(SourceBuffer&& other) noexcept;
+
+    /**
+     * 只读映射文件
+     * @return 打开或映射失败时返回 nullopt
+     */
+    static std::optional<SourceBuffer> map_file(const std::string& path);
+
+    /**
+     * 从字符串构造（持有数据）
+     */
+    static SourceBuffer from_string(std::string text);
+
+    // 源码内容（不含哨兵）
+    [[nodiscard]] const char* data() const noexcept { return data_; }
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] std::string_view view() const noexcept { return {data_, size_}; }
+
+    // 是否来自 mmap
+    [[nodiscard]] bool is_mapped() const noexcept { return map_base_ != nullptr; }
+
+private:
+    void release() noexcept;
+
+    const char* data_     = "";       // 内容起始（空缓冲区指向字面量 ""，同样以 '\0' 结尾）
+    size_t      size_     = 0;        // 内容长度（不含哨兵）
+    void*       map_base_ = nullptr;  // mmap 区域起始
+    size_t      map_size_ = 0;        // mmap 区域总长度（含 guard page）
+    std::string owned_;               // from_string 时持有的数据（含哨兵）
+};
+
+/**
+ * 原子地写入文件：先写入同目录下随机命名的临时文件，再 rename() 为 path
+ * - 并发的读者看到的要么是旧文件，要么是完整的新文件；多个写者互不干扰，最后一个生效
+ * - 不创建目录
+ * @return 写入或重命名失败时返回 false（临时文件已删除）
+ */
+bool write_file_atomic(const std::string& path, std::string_view data);
+
+// ============================================================================
+// LineIndex - 字节偏移到行列号的映射
+// ============================================================================
+//
+// Token 和 ParseError 只记录字节偏移，需要显示行列号（报错、--show）时再查这里：
+// - 首次查询时扫描一遍源码，记录每一行的起始偏移，之后二分查找
+// - 行以 '\n' 分隔；列号按字节计，'\r' 不占列（与词法分析器此前的逐字节统计一致）
+// - 只引用源码，不拷贝；源码的生命周期须长于 LineIndex
+// - 延迟构建不加锁，同一个 LineIndex 不要在多个线程中同时首次查询
+
+class LineIndex {
+public:
+    LineIndex() = default;
+    explicit LineIndex(std::string_view source) : source_(source) {}
+
+    // 偏移 -> 行列号（offset 可以等于源码长度，即 EOF 位置）
+    [[nodiscard]] Location locate(uint32_t offset) const;
+
+    // 行数（末尾换行之后的空行不计）
+    [[nodiscard]] int line_count() const;
+
+    // 第 line 行（1-based）的内容，不含行尾的 "\r\n" / "\n"
+    [[nodiscard]] std::string_view line_text(int line) const;
+
+private:
+    void build() const;
+
+    std::string_view              source_;
+    mutable std::vector<uint32_t> starts_;  // 每一行的起始偏移，首次查询时构建
+};
+
+} // namespace prim
@@ -0,0 +1,110 @@
+// string_literal.hpp - 字符串字面量解码（词法分析时调用）
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace prim {
+
+// ============================================================================
+// 字符串字面量解码
+// ============================================================================
+//
+// 输入是词法规则已经验证过的 STRING 词素（含两端引号），转义序列一定合法：
+// - \" \\ \' \n \r \t \0      对应的单个字节
+// - \x HEX+                    十六进制字节，多于两位时取低 8 位（与 C 相同）
+// - \ OCT{1,3}                 八进制字节，超过 0377 时取低 8 位
+// - \u HEX{4} / \U HEX{8}      码点编码为 UTF-8；代理项和超过 U+10FFFF 的值编码为 U+FFFD
+
+namespace detail {
+
+inline unsigned hex_digit(char c) {
+    if (c >= '0' && c <= '9') return unsigned(c - '0');
+    if (c >= 'a' && c <= 'f') return unsigned(c - 'a' + 10);
+    return unsigned(c - 'A' + 10);
+}
+
+inline bool is_hex_digit(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+inline void append_utf8(std::string& out, uint32_t cp) {
+    if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) cp = 0xFFFD;
+    if (cp < 0x80) {
+        out += char(cp);
+    } else if (cp < 0x800) {
+        out += char(0xC0 | (cp >> 6));
+        out += char(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += char(0xE0 | (cp >> 12));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    } else {
+        out += char(0xF0 | (cp >> 18));
+        out += char(0x80 | ((cp >> 12) & 0x3F));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    }
+}
+
+} // namespace detail
+
+/**
+ * 解码 STRING 词素（去掉引号、展开转义），结果写入 out（先清空）
+ */
+inline void decode_string_literal(std::string_view lexeme, std::string& out) {
+    out.clear();
+    if (lexeme.size() < 2) return;
+    const std::string_view body = lexeme.substr(1, lexeme.size() - 2);
+    out.reserve(body.size());
+
+    size_t i = 0;
+    while (i < body.size()) {
+        // 不含转义的一段整体拷贝
+        const size_t esc = body.find('\\', i);
+        if (esc == std::string_view::npos) {
+            out.append(body.substr(i));
+            break;
+        }
+        out.append(body.substr(i, esc - i));
+        i = esc + 1;
+
+        const char c = body[i++];
+        switch (c) {
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'x': {
+                unsigned value = 0;
+                while (i < body.size() && detail::is_hex_digit(body[i])) {
+                    value = ((value << 4) | detail::hex_digit(body[i++])) & 0xFF;
+                }
+                out += char(value);
+                break;
+            }
+            case 'u':
+            case 'U': {
+                const size_t digits = c == 'u' ? 4 : 8;
+                uint32_t cp = 0;
+                for (size_t k = 0; k < digits; ++k) cp = (cp << 4) | detail::hex_digit(body[i++]);
+                detail::append_utf8(out, cp);
+                break;
+            }
+            default:
+                if (c >= '0' && c <= '7') {
+                    // \0 也走这里：后面没有八进制数字时就是空字符
+                    unsigned value = unsigned(c - '0');
+                    for (int k = 0; k < 2 && i < body.size() && body[i] >= '0' && body[i] <= '7'; ++k) {
+                        value = value * 8 + unsigned(body[i++] - '0');
+                    }
+                    out += char(value & 0xFF);
+                } else {
+                    out += c;  // \" \\ \'
+                }
+                break;
+        }
+    }
+}
+
+} // namespace prim
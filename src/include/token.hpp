@@ -1,16 +1,23 @@
 // token.hpp - Prim 语言 Token 定义
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <cstring>
 #include <string_view>
 #include <array>
 #include <ostream>
+#include <utility>
 
 namespace prim {
 
 // ============================================================================
 // Location - 源码位置信息
 // ============================================================================
+//
+// 词法和语法分析阶段只记录字节偏移，行列号仅在报告错误时
+// 由 LineIndex（source.hpp）按需计算
 
 struct Location {
     int line   = 1;  // 行号 (1-based)
@@ -21,9 +28,21 @@ struct Location {
     constexpr Location(int l, int c, int o) : line(l), col(c), offset(o) {}
 };
 
+// ============================================================================
+// Span - 源码区间（字节偏移），同时用作 Bison 的 location 类型
+// ============================================================================
+
+struct Span {
+    uint32_t begin = 0;  // 起始偏移 (0-based)
+    uint32_t end   = 0;  // 结束偏移（不含）
+    
+    constexpr Span() = default;
+    constexpr Span(uint32_t b, uint32_t e) : begin(b), end(e) {}
+};
+
 // operator<< for Bison trace output
-inline std::ostream& operator<<(std::ostream& os, const Location& loc) {
-    return os << loc.line << ":" << loc.col;
+inline std::ostream& operator<<(std::ostream& os, const Span& span) {
+    return os << span.begin << "-" << span.end;
 }
 
 // ============================================================================
@@ -128,6 +147,7 @@ enum class ErrType : uint16_t {
     // 字面量相关错误
     IllegalNumber,          // 非法数字字面量 (emsg.pos: 错误位置)
     IllegalLabel,           // 非法标签 (emsg.pos: 错误位置)
+    NumberOutOfRange,       // 数字字面量超出范围（整数超过 uint64，浮点数超过 double）
 };
 
 // ============================================================================
@@ -143,27 +163,77 @@ union ErrMsg {
     constexpr explicit ErrMsg(char c) : ch(c) {}
 };
 
+// ============================================================================
+// SymbolId - 符号表中的符号编号（见 interner.hpp）
+// ============================================================================
+//
+// 编号从 1 开始连续分配，0 保留为 kNoSymbol（未驻留），与 Token 默认值一致。
+
+using SymbolId = uint32_t;
+
+inline constexpr SymbolId kNoSymbol = 0;
+
+// ============================================================================
+// TokenValue - 词法分析时确定的 token 值
+// ============================================================================
+//
+// 由词法分析器在产生 token 时填写，之后的阶段不再解析文本：
+// - 整数字面量（总是非负）存为 u；不超过 INT64_MAX 时可直接作为 int64 使用，
+//   更大的值只能作为 uint64（或取负后的 INT64_MIN）
+// - 浮点数字面量存为 f
+// - IDENT / LABEL / STRING 在 lexer 设置了 Interner 时存为 sym（标签去掉反引号，字符串去掉引号并解码转义），
+//   否则为 kNoSymbol
+// 其他 token 的 u 为 0。
+
+union TokenValue {
+    uint64_t u;
+    double   f;
+    SymbolId sym;
+
+    constexpr TokenValue() : u(0) {}
+    constexpr explicit TokenValue(uint64_t v) : u(v) {}
+    constexpr explicit TokenValue(double v) : f(v) {}
+};
+
 // ============================================================================
 // Token - 词法单元
 // ============================================================================
 
+//
+// 只记录起始偏移和词素长度（结束偏移 = begin + length），行列号由 LineIndex 按需计算。
+// 词素总是源码中 [begin, begin + length) 的原样文本。
+
 struct Token {
+    const char*      lexeme = nullptr;            // 词素起始（源码中的原始文本）
+    uint32_t         begin  = 0;                  // 起始偏移 (0-based)
+    uint32_t         length = 0;                  // 词素长度
     TokenType        type   = TokenType::START;  // Token类型
-    std::string_view text;                      // 词素（源码中的原始文本）
-    Location         begin;                      // 起始位置
-    Location         end;                        // 结束位置
-    ErrType          err;                        // 错误类型
-    ErrMsg           emsg;                       // 错误附加信息
+    ErrType          err    = ErrType::None;      // 错误类型
+    ErrMsg           emsg;                        // 错误附加信息
+    TokenValue       value;                       // 数字字面量的值或符号（见 TokenValue）
     
     // 构造函数
     constexpr Token() = default;
     
-    constexpr Token(TokenType k, std::string_view lex, Location b, Location e)
-        : type(k), text(lex), begin(b), end(e), err(ErrType::None), emsg() {}
+    constexpr Token(TokenType k, std::string_view lex, uint32_t b)
+        : lexeme(lex.data()), begin(b), length(uint32_t(lex.size())), type(k) {}
+    
+    constexpr Token(TokenType k, std::string_view lex, uint32_t b, ErrType et, ErrMsg em)
+        : lexeme(lex.data()), begin(b), length(uint32_t(lex.size())), type(k), err(et), emsg(em) {}
     
-    constexpr Token(TokenType k, std::string_view lex, Location b, Location e, 
-                    ErrType et, ErrMsg em)
-        : type(k), text(lex), begin(b), end(e), err(et), emsg(em) {}
+    // 词素文本
+    [[nodiscard]] constexpr std::string_view text() const noexcept {
+        return {lexeme, length};
+    }
+    
+    // 结束偏移（不含）
+    [[nodiscard]] constexpr uint32_t end() const noexcept {
+        return begin + length;
+    }
+    
+    [[nodiscard]] constexpr Span span() const noexcept {
+        return {begin, end()};
+    }
     
     // 判断是否为错误 token
     [[nodiscard]] constexpr bool is_error() const noexcept {
@@ -188,12 +258,29 @@ struct Token {
                type == TokenType::KW_NULL;
     }
     
+    // 判断是否为数字字面量（value 有效）
+    [[nodiscard]] constexpr bool is_number() const noexcept {
+        return type >= TokenType::INT_DEC && type <= TokenType::FLOAT_DEC;
+    }
+    
+    // 判断是否携带符号（IDENT / LABEL / STRING，驻留后 value.sym 有效）
+    [[nodiscard]] constexpr bool is_symbol() const noexcept {
+        return type == TokenType::IDENT || type == TokenType::LABEL || type == TokenType::STRING;
+    }
+    
+    // 整数字面量的值能否表示为 int64
+    [[nodiscard]] constexpr bool fits_int64() const noexcept {
+        return value.u <= uint64_t(INT64_MAX);
+    }
+    
     // 判断是否为运算符
     [[nodiscard]] constexpr bool is_operator() const noexcept {
         return type >= TokenType::AMP && type <= TokenType::OROR;
     }
 };
 
+static_assert(sizeof(Token) == 32, "Token 应保持 32 字节（半条缓存行，不跨行）");
+
 // ============================================================================
 // Token 辅助函数
 // ============================================================================
@@ -260,6 +347,124 @@ constexpr const char* token_type_name(TokenType kind) {
     }
 }
 
+// ============================================================================
+// 关键字查找 - 编译期生成的完美哈希表
+// ============================================================================
+//
+// 关键字集合直接取自 token_type_name(KW_LET..KW_NULL)。
+// 标识符用三次重叠的 2 字节读取（首、中、尾）压成一个 48 位 key，长度 2..6 时覆盖全部字节；
+// 哈希为 key 的乘法哈希，种子在编译期搜索，保证关键字之间无冲突。
+// 查找 = 长度范围检查 + 三次读取 + 一次取表 + 一次整数比较，没有 memcmp，也不按长度分支。
+
+namespace detail {
+
+inline constexpr size_t kKeywordCount =
+    static_cast<size_t>(TokenType::KW_NULL) - static_cast<size_t>(TokenType::KW_LET) + 1;
+inline constexpr size_t kKeywordSlotBits = 4;
+inline constexpr size_t kKeywordSlots = size_t{1} << kKeywordSlotBits;
+static_assert(kKeywordSlots >= kKeywordCount);
+
+constexpr TokenType keyword_at(size_t i) {
+    return static_cast<TokenType>(static_cast<size_t>(TokenType::KW_LET) + i);
+}
+
+constexpr std::string_view keyword_text(size_t i) {
+    return token_type_name(keyword_at(i));
+}
+
+constexpr std::pair<size_t, size_t> keyword_length_range() {
+    size_t lo = SIZE_MAX, hi = 0;
+    for (size_t i = 0; i < kKeywordCount; ++i) {
+        lo = std::min(lo, keyword_text(i).size());
+        hi = std::max(hi, keyword_text(i).size());
+    }
+    return {lo, hi};
+}
+
+inline constexpr size_t kKeywordMinLen = keyword_length_range().first;
+inline constexpr size_t kKeywordMaxLen = keyword_length_range().second;
+static_assert(kKeywordMinLen >= 2 && kKeywordMaxLen <= 6, "keyword_key 只支持长度 2..6 的关键字");
+
+// 按本机字节序读取 2 字节（常量求值时逐字节拼装）
+constexpr uint64_t load_u16(const char* p) {
+    if (std::is_constant_evaluated()) {
+        uint64_t lo = uint8_t(p[0]), hi = uint8_t(p[1]);
+        return (std::endian::native == std::endian::little) ? (lo | hi << 8) : (hi | lo << 8);
+    }
+    uint16_t v;
+    std::memcpy(&v, p, 2);
+    return v;
+}
+
+// 长度 2..6 的字符串 -> key：首、中、尾三段 2 字节读取覆盖全部字节，配合长度即可唯一确定
+constexpr uint64_t keyword_key(std::string_view s) {
+    const char* p = s.data();
+    size_t n = s.size();
+    return load_u16(p) | (load_u16(p + (n >> 1) - 1) << 16) | (load_u16(p + n - 2) << 32);
+}
+
+constexpr size_t keyword_hash(uint64_t key, size_t len, uint64_t seed) {
+    return static_cast<size_t>(((key ^ len) * seed) >> (64 - kKeywordSlotBits));
+}
+
+// 搜索使所有关键字落在不同槽位的乘法种子，找不到返回 0
+constexpr uint64_t find_keyword_seed() {
+    for (uint64_t i = 1; i < (1u << 16); ++i) {
+        uint64_t seed = 0x9E3779B97F4A7C15ull * i;
+        bool used[kKeywordSlots] = {};
+        bool ok = true;
+        for (size_t k = 0; k < kKeywordCount && ok; ++k) {
+            std::string_view text = keyword_text(k);
+            size_t h = keyword_hash(keyword_key(text), text.size(), seed);
+            ok = !used[h];
+            used[h] = true;
+        }
+        if (ok) return seed;
+    }
+    return 0;
+}
+
+inline constexpr uint64_t kKeywordSeed = find_keyword_seed();
+static_assert(kKeywordSeed != 0, "找不到无冲突的关键字哈希种子，请调整 kKeywordSlotBits");
+
+struct KeywordSlot {
+    uint64_t  key  = 0;
+    uint8_t   len  = 0;  // 0 表示空槽
+    TokenType type = TokenType::IDENT;
+};
+
+constexpr std::array<KeywordSlot, kKeywordSlots> make_keyword_table() {
+    std::array<KeywordSlot, kKeywordSlots> table{};
+    for (size_t i = 0; i < kKeywordCount; ++i) {
+        std::string_view text = keyword_text(i);
+        uint64_t key = keyword_key(text);
+        table[keyword_hash(key, text.size(), kKeywordSeed)] =
+            KeywordSlot{key, static_cast<uint8_t>(text.size()), keyword_at(i)};
+    }
+    return table;
+}
+
+inline constexpr auto kKeywordTable = make_keyword_table();
+
+} // namespace detail
+
+// 查找关键字：是关键字返回对应的 KW_*，否则返回 IDENT
+constexpr TokenType keyword_type(std::string_view text) {
+    size_t len = text.size();
+    if (len - detail::kKeywordMinLen > detail::kKeywordMaxLen - detail::kKeywordMinLen) {
+        return TokenType::IDENT;
+    }
+    uint64_t key = detail::keyword_key(text);
+    const detail::KeywordSlot& slot = detail::kKeywordTable[detail::keyword_hash(key, len, detail::kKeywordSeed)];
+    return (slot.key == key && slot.len == len) ? slot.type : TokenType::IDENT;
+}
+
+static_assert(keyword_type("let") == TokenType::KW_LET);
+static_assert(keyword_type("return") == TokenType::KW_RETURN);
+static_assert(keyword_type("null") == TokenType::KW_NULL);
+static_assert(keyword_type("lets") == TokenType::IDENT);
+static_assert(keyword_type("x") == TokenType::IDENT);
+
 // 错误类型名称
 constexpr const char* err_type_name(ErrType kind) {
     switch (kind) {
@@ -273,6 +478,7 @@ constexpr const char* err_type_name(ErrType kind) {
         case ErrType::UnmatchedRightBracket:   return "UnmatchedRightBracket";
         case ErrType::IllegalNumber:           return "IllegalNumber";
         case ErrType::IllegalLabel:            return "IllegalLabel";
+        case ErrType::NumberOutOfRange:        return "NumberOutOfRange";
         default:                               return "<UNKNOWN>";
     }
 }
@@ -0,0 +1,323 @@
+// value.hpp - Prim 运行时的值
+#pragma once
+
+#include "macro.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace prim {
+
+// ============================================================================
+// 带溢出检查的整数运算
+// ============================================================================
+
+inline bool add_overflow(int64_t a, int64_t b, int64_t& out) {
+#if defined(COMPILER_GCC_) || defined(COMPILER_CLANG_)
+    return __builtin_add_overflow(a, b, &out);
+#else
+    out = int64_t(uint64_t(a) + uint64_t(b));
+    return (a >= 0) == (b >= 0) && (out >= 0) != (a >= 0);
+#endif
+}
+
+inline bool sub_overflow(int64_t a, int64_t b, int64_t& out) {
+#if defined(COMPILER_GCC_) || defined(COMPILER_CLANG_)
+    return __builtin_sub_overflow(a, b, &out);
+#else
+    out = int64_t(uint64_t(a) - uint64_t(b));
+    return (a >= 0) != (b >= 0) && (out >= 0) != (a >= 0);
+#endif
+}
+
+inline bool mul_overflow(int64_t a, int64_t b, int64_t& out) {
+#if defined(COMPILER_GCC_) || defined(COMPILER_CLANG_)
+    return __builtin_mul_overflow(a, b, &out);
+#else
+    if (a == 0 || b == 0) { out = 0; return false; }
+    out = int64_t(uint64_t(a) * uint64_t(b));
+    if ((a == -1 && b == INT64_MIN) || (b == -1 && a == INT64_MIN)) return true;
+    return out / b != a;
+#endif
+}
+
+// ============================================================================
+// ValueType - 值的类型
+// ============================================================================
+
+enum class ValueType : uint8_t {
+    Undefined,  // 内部：未定义的全局变量，程序中不可见
+    Unit,       // ()
+    Null,
+    Bool,
+    Int,        // int64；48 位以内直接存放，超出时装箱为 IntObject
+    Float,      // double
+    Prim,       // Module::prims 的下标（prim 不捕获变量，不需要堆对象）
+    Builtin,    // 内置函数编号
+
+    // ===== 只以堆对象存在（引用计数）=====
+    Str,
+    List,
+    Tuple,
+    Dict,
+};
+
+// 类型名（错误信息用）
+const char* value_type_name(ValueType type);
+
+// ============================================================================
+// Object - 堆对象头
+// ============================================================================
+//
+// 引用计数归零时由 destroy() 按类型释放。容器之间的环不会被回收。
+
+struct Object {
+    uint32_t  refs = 1;
+    ValueType type;
+
+    explicit Object(ValueType t) : type(t) {}
+};
+
+void destroy(Object* obj);
+
+// 超出 48 位的整数
+struct IntObject : Object {
+    int64_t value;
+
+    explicit IntObject(int64_t v) : Object(ValueType::Int), value(v) {}
+};
+
+// ============================================================================
+// Value - 8 字节的 NaN-boxing 值
+// ============================================================================
+//
+// 高 16 位小于 0xFFF9 的位模式就是 double 本身（NaN 统一为 0x7FF8...，不会落入标签区）；
+// 其余按高 16 位区分：
+//
+//   0xFFF9  int     低 48 位是有符号整数
+//   0xFFFA  object  低 48 位是 Object*（用户态地址不超过 48 位）
+//   0xFFFB  其他    [47:32] 是 ValueType，[31:0] 是载荷（bool、prim 下标、内置函数编号）
+//
+// 数字、布尔、()、null、prim 拷贝时不分配也不访问内存；字符串、容器和超出 48 位的整数是引用计数的堆对象，
+// 拷贝只增加计数（容器在拷贝之间共享，修改对所有拷贝可见）。
+
+class Value {
+public:
+    Value() noexcept = default;
+    ~Value() { if (is_object()) release(); }
+
+    Value(const Value& other) noexcept : bits_(other.bits_) {
+        if (is_object()) ++object()->refs;
+    }
+    Value(Value&& other) noexcept : bits_(other.bits_) {
+        other.bits_ = kUnitBits;
+    }
+    Value& operator=(const Value& other) noexcept {
+        if (other.is_object()) ++other.object()->refs;
+        if (is_object()) release();
+        bits_ = other.bits_;
+        return *this;
+    }
+    Value& operator=(Value&& other) noexcept {
+        if (this != &other) {
+            if (is_object()) release();
+            bits_ = other.bits_;
+            other.bits_ = kUnitBits;
+        }
+        return *this;
+    }
+
+    // ===== 构造 =====
+    static Value undefined() noexcept          { return Value(other_bits(ValueType::Undefined, 0)); }
+    static Value null() noexcept               { return Value(kNullBits); }
+    static Value boolean(bool b) noexcept      { return Value(b ? kTrueBits : kFalseBits); }
+    static Value integer(int64_t i) {
+        if (likely_(fits_small_int(i))) return small_int(i);
+        return Value(box_int(i));
+    }
+    // 调用者保证 fits_small_int(i)
+    static Value small_int(int64_t i) noexcept { return Value(kIntTag | (uint64_t(i) & kPayloadMask)); }
+    static Value real(double f) noexcept {
+        return Value(f == f ? std::bit_cast<uint64_t>(f) : kCanonicalNaN);
+    }
+    static Value prim(uint32_t index) noexcept { return Value(other_bits(ValueType::Prim, index)); }
+    static Value builtin(uint32_t id) noexcept { return Value(other_bits(ValueType::Builtin, id)); }
+    // 接管新建对象的引用（refs 为 1）
+    static Value adopt(Object* obj) noexcept   { return Value(kObjectTag | std::bit_cast<uint64_t>(obj)); }
+
+    static constexpr bool fits_small_int(int64_t i) noexcept {
+        return i >= -(int64_t(1) << 47) && i < (int64_t(1) << 47);
+    }
+
+    // ===== 访问 =====
+    [[nodiscard]] ValueType type() const noexcept {
+        if (bits_ < kIntTag) return ValueType::Float;
+        switch (bits_ >> 48) {
+            case kIntTag >> 48:    return ValueType::Int;
+            case kObjectTag >> 48: return object()->type;
+            default:               return ValueType((bits_ >> 32) & 0xFFFF);
+        }
+    }
+    [[nodiscard]] bool is_object() const noexcept    { return (bits_ >> 48) == (kObjectTag >> 48); }
+    [[nodiscard]] bool is_small_int() const noexcept { return (bits_ >> 48) == (kIntTag >> 48); }
+    [[nodiscard]] bool is_int() const noexcept {
+        return is_small_int() || (is_object() && object()->type == ValueType::Int);
+    }
+    [[nodiscard]] bool is_float() const noexcept     { return bits_ < kIntTag; }
+    [[nodiscard]] bool is_number() const noexcept    { return is_float() || is_int(); }
+    [[nodiscard]] bool is_undefined() const noexcept { return bits_ == other_bits(ValueType::Undefined, 0); }
+
+    [[nodiscard]] bool     as_bool() const noexcept  { return bits_ == kTrueBits; }
+    [[nodiscard]] int64_t  as_small_int() const noexcept { return int64_t(bits_ << 16) >> 16; }
+    [[nodiscard]] int64_t  as_int() const noexcept {
+        return is_small_int() ? as_small_int() : static_cast<const IntObject*>(object())->value;
+    }
+    [[nodiscard]] double   as_float() const noexcept { return std::bit_cast<double>(bits_); }
+    [[nodiscard]] uint32_t index() const noexcept    { return uint32_t(bits_); }
+    [[nodiscard]] Object*  object() const noexcept   { return std::bit_cast<Object*>(bits_ & kPayloadMask); }
+
+    // 整数或浮点数转为 double
+    [[nodiscard]] double number() const noexcept { return is_float() ? as_float() : double(as_int()); }
+
+    // 条件判断：false、null、() 为假，其余为真（三者的位模式相邻：() < null < false，中间没有其他值）
+    [[nodiscard]] bool truthy() const noexcept {
+        return bits_ - kUnitBits > kFalseBits - kUnitBits;
+    }
+
+    // 两个值都是直接存放的整数（算术和比较的快速路径，一次比较完成两个标签检查）
+    [[nodiscard]] static bool both_small_ints(const Value& a, const Value& b) noexcept {
+        return ((a.bits_ ^ kIntTag) | (b.bits_ ^ kIntTag)) >> 48 == 0;
+    }
+
+    // 直接存放的整数的 + - *：载荷左移 16 位后运算，64 位溢出即 48 位溢出。
+    // 溢出时返回 false 且不修改 out（由慢速路径按 int64 计算并装箱）。调用者保证 both_small_ints(a, b)
+    [[nodiscard]] static bool small_add(const Value& a, const Value& b, Value& out) noexcept {
+        int64_t r;
+        if (add_overflow(int64_t(a.bits_ << 16), int64_t(b.bits_ << 16), r)) return false;
+        out = Value(kIntTag | uint64_t(r) >> 16);
+        return true;
+    }
+    [[nodiscard]] static bool small_sub(const Value& a, const Value& b, Value& out) noexcept {
+        int64_t r;
+        if (sub_overflow(int64_t(a.bits_ << 16), int64_t(b.bits_ << 16), r)) return false;
+        out = Value(kIntTag | uint64_t(r) >> 16);
+        return true;
+    }
+    [[nodiscard]] static bool small_mul(const Value& a, const Value& b, Value& out) noexcept {
+        int64_t r;
+        if (mul_overflow(int64_t(a.bits_ << 16), b.as_small_int(), r)) return false;
+        out = Value(kIntTag | uint64_t(r) >> 16);
+        return true;
+    }
+
+    // 释放持有的对象并置为 ()
+    void clear() noexcept {
+        if (is_object()) release();
+        bits_ = kUnitBits;
+    }
+
+private:
+    static constexpr uint64_t kPayloadMask  = (uint64_t(1) << 48) - 1;
+    static constexpr uint64_t kIntTag       = uint64_t(0xFFF9) << 48;
+    static constexpr uint64_t kObjectTag    = uint64_t(0xFFFA) << 48;
+    static constexpr uint64_t kOtherTag     = uint64_t(0xFFFB) << 48;
+    static constexpr uint64_t kCanonicalNaN = uint64_t(0x7FF8) << 48;
+
+    static constexpr uint64_t other_bits(ValueType type, uint32_t payload) noexcept {
+        return kOtherTag | uint64_t(type) << 32 | payload;
+    }
+    static constexpr uint64_t kUnitBits  = kOtherTag | uint64_t(ValueType::Unit) << 32;
+    static constexpr uint64_t kNullBits  = kOtherTag | uint64_t(ValueType::Null) << 32;
+    static constexpr uint64_t kFalseBits = kOtherTag | uint64_t(ValueType::Bool) << 32;
+    static constexpr uint64_t kTrueBits  = kOtherTag | uint64_t(ValueType::Bool) << 32 | 1;
+
+    explicit Value(uint64_t bits) noexcept : bits_(bits) {}
+
+    // 装箱不常见，放在分派循环之外；返回位模式而不是 Value，内联后结果留在寄存器中
+    static uint64_t box_int(int64_t i);
+
+    void release() noexcept {
+        Object* obj = object();
+        if (--obj->refs == 0) destroy(obj);
+    }
+
+    uint64_t bits_ = kUnitBits;
+};
+
+static_assert(sizeof(Value) == 8, "Value 应保持 8 字节");
+static_assert(sizeof(void*) == 8, "NaN-boxing 假定 64 位指针");
+
+// ============================================================================
+// 值的比较、哈希和显示
+// ============================================================================
+
+// ==：数字按数值比较（1 == 1.0），字符串和容器按内容，其余按类型和身份
+bool values_equal(const Value& a, const Value& b);
+
+// 与 values_equal 一致的哈希（整数值的浮点数与对应整数哈希相同）
+uint64_t value_hash(const Value& v);
+
+struct ValueHash {
+    size_t operator()(const Value& v) const { return size_t(value_hash(v)); }
+};
+
+struct ValueEqual {
+    bool operator()(const Value& a, const Value& b) const { return values_equal(a, b); }
+};
+
+/**
+ * 追加值的文本形式
+ * @param quote 字符串是否加引号并转义（容器内的元素加引号，print 的参数不加）
+ */
+void append_display(std::string& out, const Value& v, bool quote = false);
+
+std::string display(const Value& v, bool quote = false);
+
+// ============================================================================
+// 堆对象
+// ============================================================================
+
+struct StrObject : Object {
+    std::string text;
+
+    explicit StrObject(std::string s) : Object(ValueType::Str), text(std::move(s)) {}
+};
+
+// List 和 Tuple 共用（Tuple 不可修改）
+struct ListObject : Object {
+    std::vector<Value> items;
+
+    explicit ListObject(ValueType t) : Object(t) {}
+};
+
+// 保持插入顺序的 dict；也是 @{} / @struct 闭包空间的表示
+struct DictObject : Object {
+    std::vector<std::pair<Value, Value>>                 entries;
+    std::unordered_map<Value, uint32_t, ValueHash, ValueEqual> index;  // 键 -> entries 下标
+
+    DictObject() : Object(ValueType::Dict) {}
+
+    [[nodiscard]] Value* find(const Value& key) {
+        auto it = index.find(key);
+        return it == index.end() ? nullptr : &entries[it->second].second;
+    }
+
+    void set(const Value& key, Value value) {
+        auto [it, inserted] = index.try_emplace(key, uint32_t(entries.size()));
+        if (inserted) entries.emplace_back(key, std::move(value));
+        else          entries[it->second].second = std::move(value);
+    }
+};
+
+inline Value make_str(std::string text) { return Value::adopt(new StrObject(std::move(text))); }
+
+inline StrObject&  as_str(const Value& v)  { return *static_cast<StrObject*>(v.object()); }
+inline ListObject& as_list(const Value& v) { return *static_cast<ListObject*>(v.object()); }
+inline DictObject& as_dict(const Value& v) { return *static_cast<DictObject*>(v.object()); }
+
+} // namespace prim
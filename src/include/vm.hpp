@@ -0,0 +1,99 @@
+// vm.hpp - 字节码虚拟机
+#pragma once
+
+#include "bytecode.hpp"
+#include "value.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace prim {
+
+// ============================================================================
+// 运行时错误
+// ============================================================================
+
+struct RuntimeError {
+    uint32_t              offset = 0;  // 出错指令的源码偏移
+    std::string           message;
+    std::vector<uint32_t> trace;       // 调用链上各调用点的源码偏移（由内向外）
+};
+
+// ============================================================================
+// VM - 执行 compile() 产生的 Module
+// ============================================================================
+//
+// - 分派：GCC / Clang 下用 computed goto（每条指令末尾直接跳到下一条指令的处理代码），
+//   其他编译器或定义了 PRIM_VM_SWITCH 时退回 switch
+// - 所有帧共用一个连续的寄存器文件：Call rA, n 的新帧从 rA+1 开始，参数已经就位；
+//   帧记录保存在预先 reserve 的数组中，调用命名 prim 不分配内存
+// - 返回时清空被调用者的寄存器，及时释放其中的对象
+// - 内置函数按名字绑定到同名全局变量（程序可以覆盖）；obj.name(...) 在 obj 不是带该字段的 dict 时
+//   调用同名内置函数，obj 为第一个参数
+//
+// 同一个 VM 可以依次执行多个 Module，寄存器文件和帧数组在多次执行之间复用。不是线程安全的。
+
+class VM {
+public:
+    VM();
+    ~VM();
+
+    VM(const VM&) = delete;
+    VM& operator=(const VM&) = delete;
+
+    /**
+     * 执行顶层程序
+     * @return 程序的值（最后一条表达式语句的值）；运行时错误时返回 nullopt，见 error()
+     */
+    std::optional<Value> run(const Module& module);
+
+    // 同 run()，同时统计执行的指令数（基准测试用，单独实例化，不影响 run() 的分派循环）
+    std::optional<Value> run_counted(const Module& module, uint64_t& executed);
+
+    [[nodiscard]] const RuntimeError& error() const noexcept { return error_; }
+
+    // print 的输出目标（默认 stdout）
+    void set_output(std::FILE* out) noexcept { out_ = out; }
+
+    // 分派方式："threaded" 或 "switch"
+    static const char* dispatch_mode() noexcept;
+
+    static constexpr size_t kMaxRegisters = size_t(1) << 18;  // 寄存器文件大小（所有帧共用）
+    static constexpr size_t kMaxFrames    = 16384;            // 最大调用深度
+
+private:
+    // 载入后的 prim：常量转换为 Value，Invoke 的方法名预先解析为内置函数编号
+    struct PrimInfo {
+        const PrimCode*      code = nullptr;
+        std::vector<Value>   constants;
+        std::vector<int16_t> methods;  // 常量下标 -> 内置函数编号，-1 表示不是内置方法名
+    };
+
+    // 调用者的状态
+    struct Frame {
+        const PrimInfo* prim;
+        const Instr*    ip;    // 返回地址
+        Value*          base;  // 调用者的 R[0]
+        uint16_t        dest;  // 结果写入调用者的 R[dest]
+    };
+
+    void load(const Module& module);
+    void unload();
+    template <bool kCount>
+    bool execute(Value& result, uint64_t& executed);
+    void fail(const PrimInfo* prim, const Instr* ip, const Value* R, std::string message);
+
+    std::unique_ptr<Value[]> registers_;
+    std::vector<Frame>       frames_;
+    std::vector<PrimInfo>    prims_;
+    std::vector<Value>       globals_;
+    const Module*            module_ = nullptr;
+    size_t                   live_ = 0;  // 出错时仍可能持有值的寄存器数
+    std::FILE*               out_ = stdout;
+    RuntimeError             error_;
+};
+
+} // namespace prim
@@ -0,0 +1,61 @@
+#include "interner.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace prim {
+
+// ============================================================================
+// Interner 实现
+// ============================================================================
+
+Interner::Interner()
+    : slots_(kFirstSlots)
+    , mask_(uint32_t(kFirstSlots - 1))
+    , entries_(1)  // kNoSymbol
+{}
+
+SymbolId Interner::insert(std::string_view text, uint32_t hash, uint32_t slot) {
+    const auto id = SymbolId(entries_.size());
+    entries_.push_back({store(text), uint32_t(text.size())});
+    slots_[slot] = {hash, id};
+
+    // 负载因子超过 1/2 时扩容（新槽位不影响已返回的编号）
+    if (entries_.size() * 2 > slots_.size()) grow();
+    return id;
+}
+
+const char* Interner::store(std::string_view text) {
+    bytes_ += text.size();
+    if (text.size() > left_) {
+        // 超过块大小 1/4 的长串单独分配，不浪费当前块的剩余空间
+        if (text.size() > kChunkSize / 4) {
+            chunks_.push_back(std::make_unique_for_overwrite<char[]>(text.size()));
+            char* data = chunks_.back().get();
+            std::memcpy(data, text.data(), text.size());
+            return data;
+        }
+        chunks_.push_back(std::make_unique_for_overwrite<char[]>(kChunkSize));
+        free_ = chunks_.back().get();
+        left_ = kChunkSize;
+    }
+    char* data = free_;
+    if (!text.empty()) std::memcpy(data, text.data(), text.size());
+    free_ += text.size();
+    left_ -= text.size();
+    return data;
+}
+
+void Interner::grow() {
+    std::vector<Slot> old(slots_.size() * 2);
+    old.swap(slots_);
+    mask_ = uint32_t(slots_.size() - 1);
+    for (const Slot& slot : old) {
+        if (slot.id == kNoSymbol) continue;
+        uint32_t i = slot.hash & mask_;
+        while (slots_[i].id != kNoSymbol) i = (i + 1) & mask_;
+        slots_[i] = slot;
+    }
+}
+
+} // namespace prim
@@ -1,20 +1,15 @@
 // main.cpp —— Only modify the "display layer", not parsing/semantic logic (modern compiler style, English)
 #include <functional>
+#include <iterator>
 #include <string>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 #include <cstring>
 #include <cstdlib>
 #include <cctype>
 #include <filesystem>
-#if !defined(_WIN32)
-  #include <sys/stat.h>
-  #include <sys/types.h>
-  #include <unistd.h>
-  #include <sys/wait.h>
-#endif
+#include <chrono>
+#include <thread>
 
 #include <fmt/format.h>
 #include <fmt/color.h>
@@ -23,6 +18,15 @@
 #include "lexer.hpp"
 #include "debug.hpp"
 #include "parser.hpp"
+#include "source.hpp"
+#include "batch.hpp"
+#include "parallel_lexer.hpp"
+#include "cache.hpp"
+#include "ast_file.hpp"
+#include "interner.hpp"
+#include "compiler.hpp"
+#include "optimizer.hpp"
+#include "vm.hpp"
 
 using fmt::println;
 using namespace prim;
@@ -87,90 +91,15 @@ static void section(std::string_view title) {
         println("\n== {} ==\n", title);
 }
 
-// ============ Fake execution display (silently skip if not found) ============
-static std::filesystem::path build_fake_path(const std::string& src_filename) {
-    namespace fs = std::filesystem;
-    fs::path src(src_filename);
-    fs::path dir = src.parent_path();
-    fs::path stem = src.stem();          // remove .prim
-    fs::path fake_dir = dir / ".fake";
-#if defined(_WIN32)
-    fs::path fake = fake_dir / (stem.string() + ".exe");
-#else
-    fs::path fake = fake_dir / stem;     // Unix: no extension
-#endif
-    return fake;
-}
-
-static bool is_executable(const std::filesystem::path& p) {
-    if (!std::filesystem::exists(p) || !std::filesystem::is_regular_file(p)) return false;
-#if defined(_WIN32)
-    auto ext = p.extension().string();
-    for (auto& c : ext) c = (char)std::tolower((unsigned char)c);
-    return (ext == ".exe");
-#else
-    return ::access(p.c_str(), X_OK) == 0;
-#endif
-}
-
-static int run_fake(const std::filesystem::path& exe_path) {
-    std::string cmd = "\"" + exe_path.string() + "\"";
-    if (g_use_color)
-        fmt::print(fg(fmt::color::cyan) | fmt::emphasis::bold, "Running: ");
-    else
-        fmt::print("Running: ");
-    fmt::print("{}\n", exe_path.string());
-
-    int rc = std::system(cmd.c_str());
-    if (rc == -1) {
-        err("Failed to exec (system() returned -1)");
-        return rc;
-    }
-#if !defined(_WIN32)
-    if (WIFEXITED(rc)) {
-        int code = WEXITSTATUS(rc);
-        if (code == 0) ok("Process exited normally (0)");
-        else           warn("Process exited with nonzero code ({})", code);
-        return code;
-    } else if (WIFSIGNALED(rc)) {
-        int sig = WTERMSIG(rc);
-        err("Process was terminated by signal (signal={})", sig);
-        return 128 + sig;
-    }
-#endif
-    if (rc == 0) ok("Process exited normally (0)");
-    else         warn("Process exited with nonzero code ({})", rc);
-    return rc;
-}
-
-static void maybe_run_fake_quiet(const std::string& src_filename) {
-    namespace fs = std::filesystem;
-    fs::path fake = build_fake_path(src_filename);
-    // Requirement: do not say "could not find fake"; skip silently if not found or not executable
-    if (!fs::exists(fake)) return;
-    if (!is_executable(fake)) return;
-    (void)run_fake(fake);
-}
-
 // ============ Code frame display (used on error) ============
-struct SourceView { std::vector<std::string> lines; };
-
-static SourceView build_source_view(const std::string& source) {
-    SourceView sv;
-    std::istringstream ss(source);
-    std::string line;
-    while (std::getline(ss, line)) {
-        if (!line.empty() && line.back() == '\r') line.pop_back();
-        sv.lines.emplace_back(std::move(line));
-    }
-    return sv;
-}
-
-static void print_code_frame(const SourceView& sv,
+// Line/column are resolved from the byte offset through the lazily built line index
+static void print_code_frame(const LineIndex& lines,
                              const std::string& filename,
-                             int err_line, int err_col,
+                             uint32_t err_offset,
                              std::string_view msg) {
-    const int total = (int)sv.lines.size();
+    const Location loc = lines.locate(err_offset);
+    const int err_line = loc.line, err_col = loc.col;
+    const int total = lines.line_count();
     if (err_line <= 0 || err_line > total) {
         if (g_use_color)
             fmt::print(fg(fmt::color::red) | fmt::emphasis::bold, "error: ");
@@ -186,7 +115,7 @@ static void print_code_frame(const SourceView& sv,
 
     auto print_one = [&](int ln, bool highlight) {
         if (ln <= 0 || ln > total) return;
-        const std::string& text = sv.lines[ln - 1];
+        std::string_view text = lines.line_text(ln);
         std::string gutter = fmt::format("{:>{}} | ", ln, width);
 
         if (highlight && g_use_color) {
@@ -236,13 +165,75 @@ static void print_code_frame(const SourceView& sv,
     hr();
 }
 
+// ============ Batch check (--check): every input parsed in one process ============
+// Files are checked on a worker pool; diagnostics are printed afterwards in input order,
+// grouped per file, so the output does not depend on scheduling
+static int run_check(const std::vector<std::string>& inputs, size_t jobs, size_t max_errors,
+                     const ParseCache* cache) {
+    const std::vector<std::string> paths = expand_inputs(inputs);
+    if (paths.empty()) {
+        err("No .prim files found");
+        return 1;
+    }
+    if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::min(jobs, paths.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<FileReport> reports = check_files(paths, jobs, max_errors, cache);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    size_t failed = 0, unreadable = 0, total_errors = 0, total_bytes = 0;
+    for (const auto& report : reports) {
+        if (!report.opened) {
+            err("Unable to open file '{}'", report.path);
+            ++unreadable;
+            continue;
+        }
+        total_bytes += report.bytes;
+        if (report.errors.empty()) continue;
+
+        ++failed;
+        total_errors += report.errors.size();
+        // Only files with errors are mapped again, for the code frames
+        auto source = SourceBuffer::map_file(report.path);
+        LineIndex lines(source ? source->view() : std::string_view{});
+        for (const auto& e : report.errors) {
+            print_code_frame(lines, report.path, e.offset, e.message);
+        }
+        if (report.error_limit_reached) {
+            warn("{}: too many errors, stopped after {} (use --max-errors to change the limit)",
+                 report.path, report.errors.size());
+        }
+    }
+
+    println("");
+    if (failed == 0 && unreadable == 0) {
+        ok("Checked {} files ({} bytes) in {:.1f} ms on {} threads, no errors",
+           paths.size(), total_bytes, ms, jobs);
+        return 0;
+    }
+    err("Checked {} files ({} bytes) in {:.1f} ms on {} threads: {} errors in {} files, {} unreadable",
+        paths.size(), total_bytes, ms, jobs, total_errors, failed, unreadable);
+    return 1;
+}
+
 // ============ Main workflow (quiet by default; only error prompts; --show for details) ============
 int main(int argc, char* argv[]) {
     g_use_color = tty_supports_color();
 
     bool lexer_only = false;
     bool show_detail = false;   // New: --show controls detailed output
+    bool check_mode = false;    // --check: batch mode over files / directories
+    size_t jobs = 0;            // --jobs: worker threads for --check and parallel lexing (0 = hardware threads)
+    size_t max_errors = Parser::kDefaultErrorLimit;
+    bool use_cache = true;      // --no-cache: always lex and parse
+    std::string cache_dir;      // --cache-dir: overrides ParseCache::default_dir()
+    std::string emit_ast;       // --emit-ast: write the AST in the binary format (ast_file.hpp)
+    bool dump_bytecode = false; // --dump-bytecode: compile and print the register bytecode
+    bool optimize = true;       // -O0 / -O1: constant folding and dead-branch elimination before compiling
+    ParserBackend backend = ParserBackend::Bison;  // --parser: syntax analysis backend
     const char* filename = nullptr;
+    std::vector<std::string> inputs;
 
     // Argument parsing
     for (int i = 1; i < argc; i++) {
@@ -250,71 +241,235 @@ int main(int argc, char* argv[]) {
             lexer_only = true;
         } else if (strcmp(argv[i], "--show") == 0) {
             show_detail = true;
+        } else if (strcmp(argv[i], "--max-errors") == 0 && i + 1 < argc) {
+            max_errors = std::strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check_mode = true;
+        } else if ((strcmp(argv[i], "--jobs") == 0 || strcmp(argv[i], "-j") == 0) && i + 1 < argc) {
+            jobs = std::strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--no-cache") == 0) {
+            use_cache = false;
+        } else if (strcmp(argv[i], "--emit-ast") == 0 && i + 1 < argc) {
+            emit_ast = argv[++i];
+        } else if (strcmp(argv[i], "--dump-bytecode") == 0) {
+            dump_bytecode = true;
+        } else if (strcmp(argv[i], "-O0") == 0) {
+            optimize = false;
+        } else if (strcmp(argv[i], "-O1") == 0) {
+            optimize = true;
+        } else if (strcmp(argv[i], "--parser") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strcmp(name, "bison") == 0) {
+                backend = ParserBackend::Bison;
+            } else if (strcmp(name, "pratt") == 0) {
+                backend = ParserBackend::Pratt;
+            } else {
+                err("Unknown parser backend '{}' (expected bison or pratt)", name);
+                return 1;
+            }
         } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
-            println("Usage: {} [--lexer-only] [--show] <source file>", argv[0]);
-            println("  --lexer-only  Perform only lexical analysis");
-            println("  --show        Show debugging info on lexical and syntax phases");
-            println("  --help, -h    Show help");
+            println("Usage: {} [--lexer-only] [--show] [--max-errors N] [--parser bison|pratt] [--cache-dir DIR | --no-cache] [--emit-ast FILE] [--dump-bytecode] [-O0|-O1] <source file>", argv[0]);
+            println("       {} --check [--jobs N] [--max-errors N] [--cache-dir DIR | --no-cache] <file or directory>...", argv[0]);
+            println("  --lexer-only    Perform only lexical analysis");
+            println("  --show          Show debugging info on lexical and syntax phases");
+            println("  --max-errors N  Stop after N errors (default {}, 0 = no limit)", Parser::kDefaultErrorLimit);
+            println("  --parser NAME   Syntax backend for a single file: bison (default) or pratt (never cached)");
+            println("  --check         Check all files (directories: every .prim file inside) in one process");
+            println("  --jobs, -j N    Worker threads for --check, or for lexing one large file (default: hardware threads)");
+            println("  --cache-dir DIR Parse cache directory (default: $XDG_CACHE_HOME/prim or ~/.cache/prim)");
+            println("  --no-cache      Do not read or write the parse cache");
+            println("  --emit-ast FILE Write the AST of a successful parse in the binary AST format");
+            println("  --dump-bytecode Compile a successful parse and print the bytecode");
+            println("  -O0, -O1        Compile the AST as written, or fold constants and drop dead branches first (default -O1)");
+            println("  --help, -h      Show help");
             return 0;
-        } else if (filename == nullptr) {
-            filename = argv[i];
+        } else {
+            if (filename == nullptr) filename = argv[i];
+            inputs.emplace_back(argv[i]);
         }
     }
 
+    // Parse cache: unchanged sources are loaded instead of parsed (keyed by content and grammar)
+    // Cached entries (errors included) come from the Bison backend, so the Pratt backend always parses
+    std::optional<ParseCache> cache;
+    if (use_cache && backend == ParserBackend::Bison) {
+        std::filesystem::path dir = cache_dir.empty() ? ParseCache::default_dir() : std::filesystem::path(cache_dir);
+        if (!dir.empty()) cache.emplace(std::move(dir));
+    }
+
+    if (check_mode) {
+        if (inputs.empty()) {
+            err("--check needs at least one file or directory");
+            return 1;
+        }
+        return run_check(inputs, jobs, max_errors, cache ? &*cache : nullptr);
+    }
+
     if (!filename) {
-        println("Usage: {} [--lexer-only] [--show] <source file>", argv[0]);
-        println("  --lexer-only  Perform only lexical analysis");
-        println("  --show        Show debugging info on lexical and syntax phases");
-        println("  --help, -h    Show help");
+        println("Usage: {} [--lexer-only] [--show] [--max-errors N] [--parser bison|pratt] [--cache-dir DIR | --no-cache] [--emit-ast FILE] [--dump-bytecode] [-O0|-O1] <source file>", argv[0]);
+        println("       {} --check [--jobs N] [--max-errors N] [--cache-dir DIR | --no-cache] <file or directory>...", argv[0]);
+        println("  --lexer-only    Perform only lexical analysis");
+        println("  --show          Show debugging info on lexical and syntax phases");
+        println("  --max-errors N  Stop after N errors (default {}, 0 = no limit)", Parser::kDefaultErrorLimit);
+        println("  --parser NAME   Syntax backend for a single file: bison (default) or pratt (never cached)");
+        println("  --check         Check all files (directories: every .prim file inside) in one process");
+        println("  --jobs, -j N    Worker threads for --check, or for lexing one large file (default: hardware threads)");
+        println("  --cache-dir DIR Parse cache directory (default: $XDG_CACHE_HOME/prim or ~/.cache/prim)");
+        println("  --no-cache      Do not read or write the parse cache");
+        println("  --emit-ast FILE Write the AST of a successful parse in the binary AST format");
+        println("  --dump-bytecode Compile a successful parse and print the bytecode");
+        println("  -O0, -O1        Compile the AST as written, or fold constants and drop dead branches first (default -O1)");
+        println("  --help, -h      Show help");
         filename = "/Users/wzq/Documents/Code/Project/jlu-cs/test.prim";
     }
 
-    // Read source code
-    std::ifstream file(filename);
-    if (!file) {
+    // Read source code (mapped read-only, never copied)
+    auto mapped = SourceBuffer::map_file(filename);
+    if (!mapped) {
         err("Unable to open file '{}'", filename);
         return 1;
     }
-    std::stringstream buffer; buffer << file.rdbuf();
-    std::string source = buffer.str();
+    const SourceBuffer& source = *mapped;
     if (source.empty()) {
         warn("The file is empty");
         return 0;
     }
 
-    // Phase 1: Lexical Analysis
+    // Phase 1: Lexical Analysis (the source is scanned exactly once)
+    // Identifiers, labels and strings are interned as they are lexed (tokens carry a SymbolId)
+    Interner symbols;
     Lexer lexer(source);
-    std::vector<Token> tokens;
-    while (true) {
-        Token tok = lexer.next();
-        if (tok.type == TokenType::END || tok.type == TokenType::ERROR) {
-            if (tok.type == TokenType::ERROR) tokens.push_back(tok);
-            break;
+    lexer.set_interner(&symbols);
+    LineIndex lines(source.view());  // built on first lookup (errors / --show only)
+    std::vector<Token> tokens;  // only collected when the tokens are printed or lexed in parallel
+    Parser parser;
+    parser.set_error_limit(max_errors);
+    parser.set_backend(backend);
+    std::optional<NodeRef> ast;
+    std::optional<ParseResult> cached;
+
+    // Large files on several threads are lexed in chunks (same tokens as a serial scan); --jobs 1 forces the serial Lexer
+    const size_t lex_jobs = jobs != 0 ? jobs : std::max(1u, std::thread::hardware_concurrency());
+    const bool lex_in_parallel = lex_jobs > 1 && source.size() >= 2 * kParallelLexMinChunk;
+    ParallelLexStats lex_stats;
+
+    if (show_detail || lexer_only) {
+        // Lexical errors do not stop the scan; the parser reports them together with syntax errors
+        if (lex_in_parallel) {
+            tokens = lex_parallel(source, lex_jobs, kParallelLexMinChunk, &lex_stats);
+            intern_tokens(tokens, symbols);  // the chunk lexers run without a symbol table
+        } else {
+            do {
+                tokens.push_back(lexer.next());
+            } while (tokens.back().type != TokenType::END);
+        }
+        const Token last_tok = tokens.back();  // END
+        tokens.pop_back();
+        if (show_detail) {
+            section("Lexical Analysis");
+            ok("Collected {} tokens, {} distinct symbols ({} bytes)", tokens.size(), symbols.size(), symbols.bytes());
+            if (lex_in_parallel) {
+                ok("Lexed in {} chunks on {} threads ({} re-lexed)", lex_stats.chunks, lex_jobs, lex_stats.relexed);
+            }
+            print_tokens(tokens, lines);  // Your debug output; add color in debug.hpp if needed
+            ok("Lexical analysis done");
+        }
+        if (lexer_only) {
+            ok("Lexical analysis phase done");
+            return 0;
+        }
+
+        // Phase 2: Syntax Analysis (the parser reads the collected token buffer)
+        tokens.push_back(last_tok);
+        ast = parser.parse(tokens);
+    } else {
+        // Cache lookup (--show / --lexer-only above always lex, since they print the token stream)
+        if (cache) cached = cache->load(source.view(), max_errors);
+
+        if (cached) {
+            intern_tokens(cached->tokens, symbols);  // symbol ids are process-local and not cached
+            if (cached->errors.empty() && cached->ast.root() != kNoNode) {
+                ast = cached->ast.ref(cached->ast.root());
+            }
+        } else {
+            if (lex_in_parallel) {
+                // Large file on a multi-core machine: lex the chunks in parallel, then parse the token buffer
+                tokens = lex_parallel(source, lex_jobs);
+                intern_tokens(tokens, symbols);
+                ast = parser.parse(tokens);
+            } else {
+                // Phase 1 + 2: the parser pulls tokens straight from the lexer (no token buffer)
+                ast = parser.parse(lexer);
+            }
+            if (cache) cache->store(source.view(), max_errors, parser);  // a failed write only costs the next hit
         }
-        tokens.push_back(tok);
-    }
-    if (show_detail) {
-        section("Lexical Analysis");
-        ok("Collected {} tokens", tokens.size());
-        print_tokens(tokens);  // Your debug output; add color in debug.hpp if needed
-        ok("Lexical analysis done");
-    }
-    if (lexer_only) {
-        ok("Lexical analysis phase done");
-        return 0;
     }
+    const Ast& tree = cached ? cached->ast : parser.ast();
+    const std::vector<ParseError>& errors = cached ? cached->errors : parser.get_errors();
+    const bool error_limit_reached = cached ? cached->error_limit_reached : parser.error_limit_reached();
+
+    // AST dump for --show (also used for the partial AST when there are errors)
+    std::function<void(NodeRef, int)> print_ast;
+    print_ast = [&print_ast](NodeRef node, int depth) {
+        std::string indent(depth * 2, ' ');
+        static constexpr const char* type_names[] = {
+            "Literal", "Identifier", "BinaryExpr", "UnaryExpr",
+            "CallExpr", "IndexExpr", "SliceExpr", "FieldExpr",
+            "TupleExpr", "ListExpr", "DictExpr", "DictPair",
+            "BlockExpr", "ScopeExpr", "IfExpr", "LoopExpr",
+            "LetStmt", "DelStmt", "BreakStmt", "ReturnStmt", "ExprStmt",
+            "UnnamedPrim", "NamedPrim", "Param",
+            "RefExpr", "LetTarget", "TypeHint",
+            "StmtList", "ExprList", "LetTargetList", "IdentList",
+            "ParamList", "DecoratorList", "Program"
+        };
+        static_assert(std::size(type_names) == size_t(ASTNode::NodeType::Program) + 1,
+                      "type_names must list every ASTNode::NodeType");
+        const auto type_idx = static_cast<std::ptrdiff_t>(node.type());
+        const char* type_name = (type_idx >= 0 && type_idx < std::ssize(type_names)) ? type_names[type_idx] : "Unknown";
 
-    // Phase 2: Syntax Analysis
-    Lexer lexer2(source);
-    Parser parser;
-    auto ast = parser.parse([&lexer2]() -> Token { return lexer2.next(); });
-    SourceView sv = build_source_view(source);
-
-    // Error reporting (only error output)
-    if (parser.has_errors()) {
-        const auto& errs = parser.get_errors();
-        for (const auto& e : errs) {
-            print_code_frame(sv, filename, e.location.line, e.location.col, e.message);
+        if (g_use_color) {
+            fmt::print("{}[", indent);
+            fmt::print(fg(fmt::color::light_green) | fmt::emphasis::bold, "{}", type_name);
+            fmt::print("]\n");
+        } else {
+            println("{}[{}]", indent, type_name);
+        }
+
+        if (const Token* tok = node.token()) {
+            if (g_use_color) {
+                fmt::print("{}  token: \"", indent);
+                fmt::print(fg(fmt::color::light_coral) | fmt::emphasis::bold, "{}", tok->text());
+                fmt::print("\"\n");
+            } else {
+                println("{}  token: \"{}\"", indent, tok->text());
+            }
+        }
+
+        auto children = node.children();
+        if (depth < 5 && !children.empty()) {
+            println("{}  children: {}", indent, children.size());
+            for (NodeRef child : children) {
+                print_ast(child, depth + 2);
+            }
+        } else if (!children.empty()) {
+            println("{}  children: {} (depth limit reached)", indent, children.size());
+        }
+    };
+
+    // Error reporting (only error output; every error of the file is collected in one run)
+    if (!errors.empty()) {
+        for (const auto& e : errors) {
+            print_code_frame(lines, filename, e.offset, e.message);
+        }
+        if (error_limit_reached) {
+            warn("Too many errors, stopped after {} (use --max-errors to change the limit)", errors.size());
+        }
+        if (show_detail && tree.root() != kNoNode) {
+            section("Syntax Analysis / Partial AST");
+            print_ast(tree.ref(tree.root()), 0);
         }
         if (g_use_color) {
             fmt::print(fg(fmt::color::yellow) | fmt::emphasis::bold, "\nHint: ");
@@ -331,64 +486,76 @@ int main(int argc, char* argv[]) {
             section("Syntax Analysis / AST");
             ok("Parsing succeeded");
             println("  Root type: Program");
-            println("  Number of children: {}", ast->children.size());
-
-            std::function<void(const ASTNode&, int)> print_ast;
-            print_ast = [&print_ast](const ASTNode& node, int depth) {
-                std::string indent(depth * 2, ' ');
-                const char* type_names[] = {
-                    "Literal", "Identifier", "BinaryExpr", "UnaryExpr",
-                    "CallExpr", "IndexExpr", "FieldExpr",
-                    "TupleExpr", "ListExpr", "DictExpr", "DictPair",
-                    "BlockExpr", "ScopeExpr", "IfExpr", "LoopExpr",
-                    "LetStmt", "DelStmt", "BreakStmt", "ReturnStmt", "ExprStmt",
-                    "UnnamedPrim", "NamedPrim", "Param",
-                    "RefExpr", "LetTarget", "TypeHint",
-                    "StmtList", "ExprList", "LetTargetList", "IdentList",
-                    "ParamList", "DecoratorList", "Program"
-                };
-                int type_idx = static_cast<int>(node.type);
-                const char* type_name = (type_idx >= 0 && type_idx < 33) ? type_names[type_idx] : "Unknown";
-
-                if (g_use_color) {
-                    fmt::print("{}[", indent);
-                    fmt::print(fg(fmt::color::light_green) | fmt::emphasis::bold, "{}", type_name);
-                    fmt::print("]\n");
-                } else {
-                    println("{}[{}]", indent, type_name);
-                }
-
-                if (node.token) {
-                    if (g_use_color) {
-                        fmt::print("{}  token: \"", indent);
-                        fmt::print(fg(fmt::color::light_coral) | fmt::emphasis::bold, "{}", node.token->text);
-                        fmt::print("\"\n");
-                    } else {
-                        println("{}  token: \"{}\"", indent, node.token->text);
-                    }
-                }
-
-                if (depth < 5 && !node.children.empty()) {
-                    println("{}  children: {}", indent, node.children.size());
-                    for (const auto& child : node.children) {
-                        print_ast(child, depth + 2);
-                    }
-                } else if (!node.children.empty()) {
-                    println("{}  children: {} (depth limit reached)", indent, node.children.size());
-                }
-            };
+            println("  Number of children: {}", ast->child_count());
 
             print_ast(*ast, 0);
         }
 
-        // After parsing success, attempt to execute ./.fake/<same_name>; skip silently if not found/not executable
-        maybe_run_fake_quiet(filename);
+        if (!emit_ast.empty()) {
+            if (!write_ast_file(emit_ast, tree)) {
+                err("Unable to write AST file '{}'", emit_ast);
+                return 1;
+            }
+            if (show_detail) ok("AST written to '{}' ({} nodes)", emit_ast, tree.size());
+        }
 
-        // Simple success line (modern compiler style)
+        // Phase 3: AST optimization (-O1), then compile to register bytecode
+        Optimizer optimizer;
+        const Ast& program = optimize ? optimizer.run(tree) : tree;
+        if (show_detail && optimize) {
+            section("Optimizations");
+            if (optimizer.rewrites().empty()) println("  (none)");
+            for (const Rewrite& r : optimizer.rewrites()) {
+                const Location loc = lines.locate(r.offset);
+                println("  {}:{}: {}", loc.line, loc.col, r.message);
+            }
+        }
+
+        std::vector<CompileError> compile_errors;
+        const std::optional<Module> module = compile(program, compile_errors);
+        if (!module && dump_bytecode) {
+            // The bytecode was asked for explicitly, so not producing it is a failure
+            for (const auto& e : compile_errors) {
+                print_code_frame(lines, filename, e.offset, e.message);
+            }
+            return 1;
+        }
+        if (dump_bytecode) {
+            if (show_detail) section("Bytecode");
+            fmt::print("{}", disassemble(*module, &lines));
+        }
+
+        // Simple success line (modern compiler style); the build status is the parse status
         if (g_use_color)
             fmt::print(fg(fmt::color::green) | fmt::emphasis::bold, "Build succeeded\n");
         else
             println("Build succeeded");
+
+        // The program parsed, but the compiler cannot translate it (captures, decorators, unknown labels, ...):
+        // list why and skip execution without failing the build
+        if (!module) {
+            warn("Cannot execute {}: {} compile error(s)", filename, compile_errors.size());
+            for (const auto& e : compile_errors) {
+                print_code_frame(lines, filename, e.offset, e.message);
+            }
+            return 0;
+        }
+        std::fflush(stdout);
+
+        // Phase 4: run the program (print() writes to stdout)
+        if (show_detail) section("Execution");
+        VM vm;
+        const std::optional<Value> value = vm.run(*module);
+        if (!value) {
+            const RuntimeError& e = vm.error();
+            print_code_frame(lines, filename, e.offset, e.message);
+            for (uint32_t offset : e.trace) {
+                const Location loc = lines.locate(offset);
+                println("  called from {}:{}:{}", filename, loc.line, loc.col);
+            }
+            return 1;
+        }
+        if (show_detail) ok("Program finished with value {} ({} dispatch)", display(*value, true), VM::dispatch_mode());
         return 0;
     } else {
         err("Parse failed: No AST generated");
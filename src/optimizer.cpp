@@ -0,0 +1,597 @@
+#include "optimizer.hpp"
+#include "string_literal.hpp"
+#include "value.hpp"
+
+#include <cmath>
+#include <fmt/format.h>
+#include <utility>
+
+namespace prim {
+
+namespace {
+
+using NodeType = ASTNode::NodeType;
+using Folded   = Optimizer::Folded;
+
+constexpr size_t kMaxRendered = 48;  // --show 中表达式原文的最大长度
+
+bool is_binary(const Ast& ast, NodeId id) {
+    return ast[id].type == NodeType::BinaryExpr;
+}
+
+} // namespace
+
+// ============================================================================
+// 编译期常量
+// ============================================================================
+
+// 字面量的值（只有标量；字符串只用于比较，折叠结果不会是字符串）
+struct Optimizer::Folded {
+    enum class Kind : uint8_t { Unit, Null, Bool, Int, Float, Str };
+
+    Kind        kind = Kind::Unit;
+    bool        b = false;
+    int64_t     i = 0;
+    double      f = 0;
+    std::string s;
+
+    [[nodiscard]] bool is_number() const noexcept { return kind == Kind::Int || kind == Kind::Float; }
+    [[nodiscard]] double number() const noexcept { return kind == Kind::Int ? double(i) : f; }
+
+    // 与 Value::truthy 相同：false、null、() 为假
+    [[nodiscard]] bool truthy() const noexcept {
+        return !(kind == Kind::Unit || kind == Kind::Null || (kind == Kind::Bool && !b));
+    }
+
+    static Folded boolean(bool v) { Folded r; r.kind = Kind::Bool; r.b = v; return r; }
+    static Folded integer(int64_t v) { Folded r; r.kind = Kind::Int; r.i = v; return r; }
+    static Folded real(double v) { Folded r; r.kind = Kind::Float; r.f = v; return r; }
+};
+
+// out_ 中的节点是否为常量：字面量，或负数字面量 -N（编译器直接载入的形式）
+bool Optimizer::constant(NodeId out, Folded& value) const {
+    const ASTNode& node = out_[out];
+    bool negate = false;
+    if (node.type == NodeType::UnaryExpr) {
+        const NodeId operand = out_.children(out)[0];
+        if (out_.token(out)->type != TokenType::MINUS || out_[operand].type != NodeType::Literal) return false;
+        const Token* tok = out_.token(operand);
+        if (!tok || !tok->is_number()) return false;
+        negate = true;
+        out = operand;
+    } else if (node.type != NodeType::Literal) {
+        return false;
+    }
+
+    const Token* tok = out_.token(out);
+    if (!tok) {
+        value = Folded{};
+        return true;
+    }
+    switch (tok->type) {
+        case TokenType::KW_TRUE:  value = Folded::boolean(true); return true;
+        case TokenType::KW_FALSE: value = Folded::boolean(false); return true;
+        case TokenType::KW_NULL:  value = Folded{}; value.kind = Folded::Kind::Null; return true;
+        case TokenType::FLOAT_DEC:
+            value = Folded::real(negate ? -tok->value.f : tok->value.f);
+            return true;
+        case TokenType::STRING:
+            value = Folded{};
+            value.kind = Folded::Kind::Str;
+            decode_string_literal(tok->text(), value.s);
+            return true;
+        default:
+            if (!tok->is_number()) return false;
+            // 超出 int64 的字面量是编译错误，保持原样由编译器报告
+            if (negate ? tok->value.u > uint64_t(INT64_MAX) + 1 : !tok->fits_int64()) return false;
+            value = Folded::integer(negate ? int64_t(0 - tok->value.u) : int64_t(tok->value.u));
+            return true;
+    }
+}
+
+namespace {
+
+// a op b（op 是算术或比较运算符）；运行时会报错的情形返回 false，保持原样
+bool fold_binary(TokenType op, const Folded& a, const Folded& b, Folded& out) {
+    using Kind = Folded::Kind;
+
+    switch (op) {
+        case TokenType::EQEQ:
+        case TokenType::NEQ: {
+            bool eq;
+            if (a.is_number() && b.is_number()) {
+                eq = a.kind == Kind::Int && b.kind == Kind::Int ? a.i == b.i : a.number() == b.number();
+            } else if (a.kind != b.kind) {
+                eq = false;
+            } else {
+                eq = a.kind == Kind::Str ? a.s == b.s : a.kind != Kind::Bool || a.b == b.b;
+            }
+            out = Folded::boolean(op == TokenType::EQEQ ? eq : !eq);
+            return true;
+        }
+        case TokenType::LT:
+        case TokenType::LE:
+        case TokenType::GT:
+        case TokenType::GE: {
+            // a > b 即 b < a，与编译器相同
+            const bool swap = op == TokenType::GT || op == TokenType::GE;
+            const bool strict = op == TokenType::LT || op == TokenType::GT;
+            const Folded& x = swap ? b : a;
+            const Folded& y = swap ? a : b;
+            if (x.is_number() && y.is_number()) {
+                if (x.kind == Kind::Int && y.kind == Kind::Int) out = Folded::boolean(strict ? x.i < y.i : x.i <= y.i);
+                else out = Folded::boolean(strict ? x.number() < y.number() : x.number() <= y.number());
+                return true;
+            }
+            if (x.kind == Kind::Str && y.kind == Kind::Str) {
+                const int c = x.s.compare(y.s);
+                out = Folded::boolean(strict ? c < 0 : c <= 0);
+                return true;
+            }
+            return false;
+        }
+        default:
+            break;
+    }
+
+    // 算术：只折叠数字（str + x 的结果是字符串，不折叠）
+    if (!a.is_number() || !b.is_number()) return false;
+
+    if (a.kind == Kind::Int && b.kind == Kind::Int) {
+        const int64_t x = a.i;
+        const int64_t y = b.i;
+        int64_t r = 0;
+        switch (op) {
+            case TokenType::PLUS:  if (add_overflow(x, y, r)) return false; break;
+            case TokenType::MINUS: if (sub_overflow(x, y, r)) return false; break;
+            case TokenType::STAR:  if (mul_overflow(x, y, r)) return false; break;
+            case TokenType::SLASH:
+                if (y == 0 || (x == INT64_MIN && y == -1)) return false;
+                r = x / y;
+                break;
+            case TokenType::PERCENT:
+                if (y == 0) return false;
+                r = y == -1 ? 0 : x % y;
+                break;
+            default:
+                return false;
+        }
+        out = Folded::integer(r);
+        return true;
+    }
+
+    const double x = a.number();
+    const double y = b.number();
+    double r;
+    switch (op) {
+        case TokenType::PLUS:    r = x + y; break;
+        case TokenType::MINUS:   r = x - y; break;
+        case TokenType::STAR:    r = x * y; break;
+        case TokenType::SLASH:   r = x / y; break;
+        case TokenType::PERCENT: r = std::fmod(x, y); break;
+        default: return false;
+    }
+    // inf / nan 没有字面量写法，保持原样
+    if (!std::isfinite(r)) return false;
+    out = Folded::real(r);
+    return true;
+}
+
+bool fold_unary(TokenType op, const Folded& v, Folded& out) {
+    switch (op) {
+        case TokenType::BANG:
+            out = Folded::boolean(!v.truthy());
+            return true;
+        case TokenType::MINUS:
+            if (v.kind == Folded::Kind::Int && v.i != INT64_MIN) { out = Folded::integer(-v.i); return true; }
+            if (v.kind == Folded::Kind::Float)                   { out = Folded::real(-v.f); return true; }
+            return false;
+        case TokenType::PLUS:
+            if (!v.is_number()) return false;
+            out = v;
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::string folded_text(const Folded& v) {
+    switch (v.kind) {
+        case Folded::Kind::Unit:  return "()";
+        case Folded::Kind::Null:  return "null";
+        case Folded::Kind::Bool:  return v.b ? "true" : "false";
+        case Folded::Kind::Int:   return fmt::format("{}", v.i);
+        case Folded::Kind::Float: {
+            std::string s = fmt::format("{}", v.f);
+            if (s.find_first_of(".e") == std::string::npos) s += ".0";
+            return s;
+        }
+        case Folded::Kind::Str:   return fmt::format("{:?}", v.s);
+    }
+    return "?";
+}
+
+} // namespace
+
+// ============================================================================
+// 生成节点
+// ============================================================================
+
+Token* Optimizer::make_token(TokenType type, std::string text, uint32_t offset) {
+    const std::string& stored = texts_.emplace_back(std::move(text));
+    return &tokens_.emplace_back(type, stored, offset);
+}
+
+// 常量的字面量节点；负数生成 UnaryExpr(-, Literal)，与源码中的写法相同
+NodeId Optimizer::literal(const Folded& value, uint32_t offset) {
+    switch (value.kind) {
+        case Folded::Kind::Unit:
+            return out_.add(NodeType::Literal);
+        case Folded::Kind::Null:
+            return out_.add(NodeType::Literal, make_token(TokenType::KW_NULL, "null", offset));
+        case Folded::Kind::Bool:
+            return out_.add(NodeType::Literal, value.b ? make_token(TokenType::KW_TRUE, "true", offset)
+                                                       : make_token(TokenType::KW_FALSE, "false", offset));
+        case Folded::Kind::Int: {
+            const uint64_t magnitude = value.i < 0 ? 0 - uint64_t(value.i) : uint64_t(value.i);
+            Token* tok = make_token(TokenType::INT_DEC, fmt::format("{}", magnitude), offset);
+            tok->value.u = magnitude;
+            const NodeId lit = out_.add(NodeType::Literal, tok);
+            if (value.i >= 0) return lit;
+            const NodeId kids[] = {lit};
+            return out_.add(NodeType::UnaryExpr, make_token(TokenType::MINUS, "-", offset), kids);
+        }
+        case Folded::Kind::Float: {
+            const double magnitude = std::signbit(value.f) ? -value.f : value.f;
+            Token* tok = make_token(TokenType::FLOAT_DEC, folded_text(Folded::real(magnitude)), offset);
+            tok->value.f = magnitude;
+            const NodeId lit = out_.add(NodeType::Literal, tok);
+            if (!std::signbit(value.f)) return lit;
+            const NodeId kids[] = {lit};
+            return out_.add(NodeType::UnaryExpr, make_token(TokenType::MINUS, "-", offset), kids);
+        }
+        case Folded::Kind::Str:
+            break;  // 不会出现（折叠结果不是字符串）
+    }
+    return out_.add(NodeType::Literal);
+}
+
+// 求值没有副作用、也不会出错：字面量和由它们组成的容器
+bool Optimizer::pure(NodeId out) const {
+    Folded value;
+    switch (out_[out].type) {
+        case NodeType::Literal:
+        case NodeType::UnaryExpr:
+            return constant(out, value);
+        case NodeType::TupleExpr:
+        case NodeType::ListExpr:
+            for (NodeId item : out_.children(out)) {
+                if (!pure(item)) return false;
+            }
+            return true;
+        case NodeType::DictExpr:
+            // 键只接受标量字面量（容器作键的哈希规则留给运行时）
+            for (NodeId pair : out_.children(out)) {
+                const auto kv = out_.children(pair);
+                if (!constant(kv[0], value) || !pure(kv[1])) return false;
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool Optimizer::contains_break(NodeId out) const {
+    if (out_[out].type == NodeType::BreakStmt) return true;
+    for (NodeId child : out_.children(out)) {
+        if (child != kNoNode && contains_break(child)) return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// 改写记录
+// ============================================================================
+
+// 最左侧的 token 偏移；二元表达式的 token 是运算符，取左操作数的。没有 token 时取最近访问过的位置
+uint32_t Optimizer::offset_of(NodeId in) const {
+    for (;;) {
+        const Token* tok = in_->token(in);
+        if (tok && !is_binary(*in_, in)) return tok->begin;
+        const auto kids = in_->children(in);
+        if (kids.empty() || kids.front() == kNoNode) return tok ? tok->begin : offset_;
+        in = kids.front();
+    }
+}
+
+// 输入 AST 中表达式的简短原文（--show 用），超过 kMaxRendered 后不再展开
+void Optimizer::render(NodeId in, std::string& out) const {
+    if (out.size() > kMaxRendered) return;
+
+    const Ast& ast = *in_;
+    const auto kids = ast.children(in);
+    auto operand = [&](NodeId id) {
+        if (!is_binary(ast, id)) return render(id, out);
+        out += '(';
+        render(id, out);
+        out += ')';
+    };
+    auto list = [&](std::span<const NodeId> items) {
+        for (size_t i = 0; i < items.size(); ++i) {
+            if (i) out += ", ";
+            render(items[i], out);
+        }
+    };
+
+    switch (ast[in].type) {
+        case NodeType::Literal:
+            out += ast.token(in) ? ast.token(in)->text() : "()";
+            break;
+        case NodeType::Identifier:
+            out += ast.token(in)->text();
+            break;
+        case NodeType::UnaryExpr:
+            out += ast.token(in)->text();
+            operand(kids[0]);
+            break;
+        case NodeType::BinaryExpr:
+            operand(kids[0]);
+            out += ' ';
+            out += ast.token(in)->text();
+            out += ' ';
+            operand(kids[1]);
+            break;
+        case NodeType::CallExpr:
+            render(kids[0], out);
+            out += '(';
+            list(kids.subspan(1));
+            out += ')';
+            break;
+        case NodeType::IndexExpr:
+            render(kids[0], out);
+            out += '[';
+            render(kids[1], out);
+            out += ']';
+            break;
+        case NodeType::SliceExpr: {
+            const ASTNode& node = ast[in];
+            size_t next = 1;
+            render(kids[0], out);
+            out += '[';
+            if (node.slice_from()) render(kids[next++], out);
+            out += ':';
+            if (node.slice_to()) render(kids[next], out);
+            out += ']';
+            break;
+        }
+        case NodeType::FieldExpr:
+            render(kids[0], out);
+            out += '.';
+            out += ast.token(in)->text();
+            break;
+        case NodeType::TupleExpr:
+            out += '(';
+            list(kids);
+            out += kids.size() == 1 ? ",)" : ")";
+            break;
+        case NodeType::ListExpr:
+            out += '[';
+            list(kids);
+            out += ']';
+            break;
+        case NodeType::DictExpr:
+            out += '{';
+            list(kids);
+            out += '}';
+            break;
+        case NodeType::DictPair:
+            render(kids[0], out);
+            out += ": ";
+            render(kids[1], out);
+            break;
+        case NodeType::BlockExpr:
+        case NodeType::ScopeExpr:
+            out += "{ ... }";
+            break;
+        case NodeType::IfExpr:
+            out += "if ";
+            render(kids[0], out);
+            out += " { ... }";
+            if (kids.size() == 3 && kids[2] != kNoNode) out += " else ...";
+            break;
+        case NodeType::LoopExpr:
+            out += ast.token(in) ? fmt::format("loop {} {{ ... }}", ast.token(in)->text()) : "loop { ... }";
+            break;
+        default:
+            out += "...";
+            break;
+    }
+}
+
+// 加反引号的原文，过长时截断（不截断 UTF-8 字符）
+std::string Optimizer::quoted(NodeId in) const {
+    std::string text;
+    render(in, text);
+    if (text.size() > kMaxRendered) {
+        size_t cut = kMaxRendered - 3;
+        while (cut > 0 && (static_cast<unsigned char>(text[cut]) & 0xC0) == 0x80) --cut;
+        text.resize(cut);
+        text += "...";
+    }
+    return fmt::format("`{}`", text);
+}
+
+// 记录一次改写；discard_from 之后的记录属于被这次改写取代的子表达式，删除
+void Optimizer::record(NodeId in, std::string message, size_t discard_from) {
+    rewrites_.resize(discard_from);
+    rewrites_.push_back({offset_of(in), std::move(message)});
+}
+
+// ============================================================================
+// 遍历
+// ============================================================================
+
+const Ast& Optimizer::run(const Ast& input) {
+    in_ = &input;
+    out_.clear();
+    out_.reserve(input.size());
+    tokens_.clear();
+    texts_.clear();
+    rewrites_.clear();
+    offset_ = 0;
+
+    if (input.root() != kNoNode) out_.set_root(visit(input.root()));
+    in_ = nullptr;
+    return out_;
+}
+
+NodeId Optimizer::visit(NodeId id) {
+    if (const Token* tok = in_->token(id)) offset_ = tok->begin;
+
+    switch ((*in_)[id].type) {
+        case NodeType::UnaryExpr:  return unary(id);
+        case NodeType::BinaryExpr: return binary(id);
+        case NodeType::IfExpr:     return if_expr(id);
+        case NodeType::LoopExpr:   return loop_expr(id);
+        case NodeType::StmtList:
+        case NodeType::BlockExpr:
+        case NodeType::ScopeExpr:  return stmt_list(id, false);
+        default:                   return copy(id);
+    }
+}
+
+// 原样复制节点，子节点递归优化
+NodeId Optimizer::copy(NodeId id) {
+    std::vector<NodeId> kids;
+    kids.reserve(in_->children(id).size());
+    for (NodeId child : in_->children(id)) kids.push_back(child == kNoNode ? kNoNode : visit(child));
+    return out_.add((*in_)[id].type, in_->token(id), kids, (*in_)[id].flags);
+}
+
+// 语句列表：删除没有副作用的表达式语句；列表的值要用到时保留最后一条
+NodeId Optimizer::stmt_list(NodeId id, bool value_discarded) {
+    const ASTNode& node = (*in_)[id];
+    const bool keep_last = !value_discarded && (node.type == NodeType::StmtList || node.use_tail());
+    const auto items = in_->children(id);
+
+    std::vector<NodeId> kids;
+    kids.reserve(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        const NodeId stmt = visit(items[i]);
+        if (out_[stmt].type == NodeType::ExprStmt && !(keep_last && i + 1 == items.size()) &&
+            pure(out_.children(stmt)[0])) {
+            // 保留语句内部的改写记录（如 if 化简为 ()），说明它为什么没有副作用
+            record(items[i], fmt::format("removed {} (no side effects)", quoted(in_->children(items[i])[0])),
+                   rewrites_.size());
+            continue;
+        }
+        kids.push_back(stmt);
+    }
+    return out_.add(node.type, in_->token(id), kids, node.flags);
+}
+
+NodeId Optimizer::unary(NodeId id) {
+    const size_t mark = rewrites_.size();
+    const NodeId operand = visit(in_->children(id)[0]);
+    const NodeId kids[] = {operand};
+    const NodeId copied = out_.add(NodeType::UnaryExpr, in_->token(id), kids);
+
+    Folded value, result;
+    if (!constant(operand, value) || !fold_unary(in_->token(id)->type, value, result)) return copied;
+    // -N 本身就是常量的写法，不算改写
+    if (constant(copied, value) && (*in_)[in_->children(id)[0]].type == NodeType::Literal) return copied;
+    const NodeId folded = literal(result, offset_of(id));
+    record(id, fmt::format("{} -> `{}`", quoted(id), folded_text(result)), mark);
+    return folded;
+}
+
+NodeId Optimizer::binary(NodeId id) {
+    const Token* op = in_->token(id);
+    const auto in_kids = in_->children(id);
+    const size_t mark = rewrites_.size();
+
+    // && / ||：左侧是常量时结果就是决定结果的那一侧（右侧不是常量也可以）
+    if (op->type == TokenType::ANDAND || op->type == TokenType::OROR) {
+        const NodeId lhs = visit(in_kids[0]);
+        Folded value;
+        if (constant(lhs, value)) {
+            const bool take_lhs = op->type == TokenType::ANDAND ? !value.truthy() : value.truthy();
+            const NodeId taken = take_lhs ? in_kids[0] : in_kids[1];
+            record(id, fmt::format("{} -> {}", quoted(id), quoted(taken)), mark);
+            return take_lhs ? lhs : visit(in_kids[1]);
+        }
+        const NodeId kids[] = {lhs, visit(in_kids[1])};
+        return out_.add(NodeType::BinaryExpr, op, kids);
+    }
+
+    const NodeId kids[] = {visit(in_kids[0]), visit(in_kids[1])};
+    Folded a, b, result;
+    if (op->type != TokenType::EQ && constant(kids[0], a) && constant(kids[1], b) &&
+        fold_binary(op->type, a, b, result)) {
+        const NodeId folded = literal(result, offset_of(id));
+        record(id, fmt::format("{} -> `{}`", quoted(id), folded_text(result)), mark);
+        return folded;
+    }
+    return out_.add(NodeType::BinaryExpr, op, kids);
+}
+
+// if 的条件是常量时只保留执行的分支
+NodeId Optimizer::if_expr(NodeId id) {
+    const auto in_kids = in_->children(id);
+    const size_t mark = rewrites_.size();
+    const NodeId cond = visit(in_kids[0]);
+
+    Folded value;
+    if (constant(cond, value)) {
+        const std::string head = fmt::format("if {}", quoted(in_kids[0]));
+        if (value.truthy()) {
+            record(id, head + " is always true -> then branch", mark);
+            return visit(in_kids[1]);
+        }
+        if (in_kids.size() < 3 || in_kids[2] == kNoNode) {
+            record(id, head + " is always false -> `()`", mark);
+            return out_.add(NodeType::Literal);
+        }
+        record(id, head + " is always false -> else branch", mark);
+        return visit(in_kids[2]);
+    }
+
+    std::vector<NodeId> kids = {cond, visit(in_kids[1])};
+    if (in_kids.size() == 3 && in_kids[2] != kNoNode) {
+        // else if 化简为 () 时等同于没有 else
+        const NodeId other = visit(in_kids[2]);
+        if (out_[other].type != NodeType::Literal) kids.push_back(other);
+    }
+    return out_.add(NodeType::IfExpr, in_->token(id), kids, (*in_)[id].flags);
+}
+
+// 第一条语句是跳出本循环的无条件 break 时，loop 的值就是 break 的值
+NodeId Optimizer::loop_expr(NodeId id) {
+    const Token* label = in_->token(id);
+    const size_t mark = rewrites_.size();
+    const NodeId body = stmt_list(in_->children(id)[0], true);
+    const NodeId kids[] = {body};
+    const NodeId loop = out_.add(NodeType::LoopExpr, label, kids, (*in_)[id].flags);
+
+    const auto stmts = out_.children(body);
+    if (stmts.empty() || out_[stmts[0]].type != NodeType::BreakStmt) return loop;
+    const NodeId brk = stmts[0];
+    const Token* target = out_.token(brk);
+    if (target && (!label || target->text() != label->text())) return loop;  // 跳出外层循环
+
+    const auto value = out_.children(brk);
+    const bool has_value = !value.empty() && value[0] != kNoNode;
+    if (has_value && contains_break(value[0])) return loop;
+
+    // 输入中对应的 break：它之前的语句都是被删除的表达式语句
+    NodeId in_brk = kNoNode;
+    for (NodeId s : in_->children(in_->children(id)[0])) {
+        if ((*in_)[s].type == NodeType::BreakStmt) { in_brk = s; break; }
+    }
+    const auto in_value = in_->children(in_brk);
+    record(id, fmt::format("loop begins with `break` -> {}",
+                           has_value ? quoted(in_value[0]) : std::string("`()`")), mark);
+    return has_value ? value[0] : out_.add(NodeType::Literal);
+}
+
+} // namespace prim
@@ -0,0 +1,165 @@
+#include "parallel_lexer.hpp"
+#include "lexer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace prim {
+
+namespace {
+
+// 一块的扫描结果
+struct Chunk {
+    uint32_t           begin = 0;  // 推测扫描的起点
+    uint32_t           end   = 0;  // 块尾（不含）：起始偏移 >= end 的 token 属于后面的块
+    std::vector<Token> tokens;
+    uint32_t           next  = 0;  // 越过块尾的第一个 token 的起始偏移
+    bool               ended = false;  // tokens 以 END 结尾
+};
+
+// 从 from 开始扫描到块尾
+void lex_chunk(const SourceBuffer& source, uint32_t from, Chunk& chunk) {
+    chunk.tokens.clear();
+    chunk.ended = false;
+    Lexer lexer(source, from);
+    for (;;) {
+        Token tok = lexer.next();
+        if (tok.type == TokenType::END) {
+            chunk.tokens.push_back(tok);
+            chunk.ended = true;
+            return;
+        }
+        if (tok.begin >= chunk.end) {
+            chunk.next = tok.begin;
+            return;
+        }
+        chunk.tokens.push_back(tok);
+    }
+}
+
+// 重新判定右括号：各块从空括号栈开始扫描，块内的判定可能有误
+void match_brackets(std::vector<Token>& tokens) {
+    std::vector<char> stack;
+    for (Token& tok : tokens) {
+        char right = 0;
+        switch (tok.type) {
+            case TokenType::LPAREN: stack.push_back('('); continue;
+            case TokenType::LBRACK: stack.push_back('['); continue;
+            case TokenType::LBRACE: stack.push_back('{'); continue;
+            case TokenType::RPAREN: right = ')'; break;
+            case TokenType::RBRACK: right = ']'; break;
+            case TokenType::RBRACE: right = '}'; break;
+            case TokenType::ERROR:
+                if (tok.err != ErrType::UnmatchedRightBracket) continue;
+                right = tok.emsg.ch;
+                break;
+            default:
+                continue;
+        }
+
+        const char left = stack.empty() ? '\0' : stack.back();
+        const bool matched = (left == '(' && right == ')') ||
+                             (left == '[' && right == ']') ||
+                             (left == '{' && right == '}');
+        if (matched) {
+            stack.pop_back();
+            tok.type = right == ')' ? TokenType::RPAREN
+                     : right == ']' ? TokenType::RBRACK
+                     : TokenType::RBRACE;
+            tok.err  = ErrType::None;
+            tok.emsg = ErrMsg();
+        } else {
+            tok.type = TokenType::ERROR;
+            tok.err  = ErrType::UnmatchedRightBracket;
+            tok.emsg = ErrMsg(right);
+        }
+    }
+}
+
+} // namespace
+
+std::vector<Token> lex_parallel(const SourceBuffer& source, size_t jobs, size_t min_chunk,
+                                ParallelLexStats* stats) {
+    if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+    const size_t size = source.size();
+    const size_t count = std::max<size_t>(1, std::min(jobs, size / std::max<size_t>(min_chunk, 1)));
+
+    // 切分点：名义位置之后的第一个换行之后
+    std::vector<Chunk> chunks;
+    chunks.reserve(count);
+    uint32_t begin = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Chunk chunk;
+        chunk.begin = begin;
+        if (i + 1 == count) {
+            chunk.end = UINT32_MAX;
+        } else {
+            const char* data = source.data();
+            const void* nl = std::memchr(data + size * (i + 1) / count, '\n', size - size * (i + 1) / count);
+            chunk.end = nl ? uint32_t(static_cast<const char*>(nl) - data) + 1 : uint32_t(size);
+            if (chunk.end <= begin) continue;  // 很长的一行跨过了多个名义切分点
+        }
+        begin = std::min<uint32_t>(chunk.end, uint32_t(size));
+        chunks.push_back(std::move(chunk));
+        if (begin == size) {
+            chunks.back().end = UINT32_MAX;  // 剩下的部分没有换行，并入这一块
+            break;
+        }
+    }
+
+    if (stats) *stats = ParallelLexStats{chunks.size(), 0};
+
+    // 推测扫描：块 0 在当前线程，其余各一个线程
+    std::vector<std::thread> threads;
+    threads.reserve(chunks.size() - 1);
+    for (size_t i = 1; i < chunks.size(); ++i) {
+        threads.emplace_back([&source, &chunk = chunks[i]] { lex_chunk(source, chunk.begin, chunk); });
+    }
+    lex_chunk(source, 0, chunks[0]);
+    for (auto& t : threads) {
+        t.join();
+    }
+    if (chunks.size() == 1) {
+        return std::move(chunks[0].tokens);  // 串行扫描，括号判定本来就是对的
+    }
+
+    // 顺序验证并拼接
+    std::vector<Token> tokens;
+    size_t total = 0;
+    for (const auto& chunk : chunks) total += chunk.tokens.size();
+    tokens.reserve(total);
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        Chunk& chunk = chunks[i];
+        size_t from = 0;
+        if (i > 0) {
+            const Chunk& prev = chunks[i - 1];
+            if (prev.ended) break;
+
+            const uint32_t p = prev.next;  // 真实 token 流在本块中的第一个起始位置
+            if (p >= chunk.end) {
+                // 整块都在上一个 token 之内（如很长的注释）
+                chunk.tokens.clear();
+                chunk.next = p;
+                chunk.ended = false;
+                continue;
+            }
+            auto it = std::lower_bound(chunk.tokens.begin(), chunk.tokens.end(), p,
+                [](const Token& tok, uint32_t off) { return tok.begin < off; });
+            if (it != chunk.tokens.end() && it->begin == p) {
+                from = size_t(it - chunk.tokens.begin());
+            } else {
+                lex_chunk(source, p, chunk);
+                if (stats) ++stats->relexed;
+            }
+        }
+        tokens.insert(tokens.end(), chunk.tokens.begin() + std::ptrdiff_t(from), chunk.tokens.end());
+        if (chunk.ended) break;
+    }
+
+    match_brackets(tokens);
+    return tokens;
+}
+
+} // namespace prim
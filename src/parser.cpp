@@ -1,9 +1,61 @@
 #include "parser.hpp"
 #include "parser.tab.hpp"  // Bison 生成的头文件
+#include "pratt_parser.hpp"
+#include "lexer.hpp"
 #include <stdexcept>
 
 namespace prim {
 
+namespace {
+
+// 词法错误 token → ParseError（偏移尽量指向出错的字符）
+ParseError lex_error(const Token& tok) {
+    uint32_t offset = tok.begin;
+    std::string message;
+    switch (tok.err) {
+        case ErrType::IllegalChar:
+            message = fmt::format("Illegal character '{}'", tok.emsg.ch);
+            break;
+        case ErrType::IllegalIdentifier:
+            message = "Illegal identifier";
+            break;
+        case ErrType::UnterminatedString:
+            message = "Unterminated string literal";
+            break;
+        case ErrType::IllegalEscape:
+            message = "Illegal escape sequence in string literal";
+            break;
+        case ErrType::UnterminatedComment:
+            message = "Unterminated block comment";
+            break;
+        case ErrType::UnmatchedLeftBracket:
+            message = fmt::format("Unclosed '{}'", tok.emsg.ch);
+            break;
+        case ErrType::UnmatchedRightBracket:
+            message = fmt::format("Unmatched '{}'", tok.emsg.ch);
+            break;
+        case ErrType::IllegalNumber:
+            message = "Illegal number literal";
+            break;
+        case ErrType::IllegalLabel:
+            message = "Illegal label";
+            break;
+        case ErrType::NumberOutOfRange:
+            message = fmt::format("Number literal '{}' is out of range", tok.text());
+            break;
+        default:
+            message = "Lexical error";
+            break;
+    }
+    if ((tok.err == ErrType::IllegalEscape || tok.err == ErrType::IllegalNumber ||
+         tok.err == ErrType::IllegalLabel) && tok.emsg.pos > 0) {
+        offset += uint32_t(tok.emsg.pos);
+    }
+    return ParseError{ParseErrorType::UnexpectedToken, offset, std::move(message)};
+}
+
+} // namespace
+
 // ============================================================================
 // Parser 类实现
 // ============================================================================
@@ -17,19 +69,46 @@ Parser::~Parser() = default;
 Parser::Parser(Parser&&) noexcept = default;
 Parser& Parser::operator=(Parser&&) noexcept = default;
 
-std::optional<ASTNode> Parser::parse(TokenProvider token_provider) {
+std::optional<NodeRef> Parser::parse(TokenProvider token_provider) {
+    // 按 TokenSource 处理，std::function 本身即是取 token 的闭包
+    return parse<TokenProvider>(token_provider);
+}
+
+std::optional<NodeRef> Parser::parse(Lexer& lexer) {
+    // 重置状态
+    reset();
+    
+    // fetch_token 直接调用 lexer，不经过函数指针
+    lexer_ = &lexer;
+    
+    return run();
+}
+
+std::optional<NodeRef> Parser::parse(std::span<const Token> tokens) {
     // 重置状态
     reset();
     
-    // 保存 token provider
-    token_provider_ = std::move(token_provider);
+    // 直接读取调用方的 token 缓冲区
+    token_buffer_ = tokens;
     
-    // 调用 Bison parser
-    int result = bison_parser_->parse();
+    return run();
+}
+
+std::optional<NodeRef> Parser::run() {
+    // 调用所选后端（返回值含义相同：0 表示接受输入，1 表示中止）
+    int result = backend_ == ParserBackend::Pratt
+        ? detail::PrattParser(*this).parse()
+        : bison_parser_->parse();
+    
+    // 错误恢复失败（如在未闭合的括号内遇到文件结束）时 Bison 直接中止，
+    // 用已归约的顶层语句补上 Program，保留部分 AST
+    if (ast_.root() == kNoNode) {
+        finish_program();
+    }
     
     // 如果解析成功且没有错误，返回结果
-    if (result == 0 && !has_errors()) {
-        return std::move(result_);
+    if (result == 0 && !has_errors() && ast_.root() != kNoNode) {
+        return ast_.ref(ast_.root());
     }
     
     return std::nullopt;
@@ -37,35 +116,135 @@ std::optional<ASTNode> Parser::parse(TokenProvider token_provider) {
 
 void Parser::reset() {
     errors_.clear();
-    result_.reset();
-    token_provider_ = nullptr;
+    error_limit_reached_ = false;
+    ast_.clear();
+    arena_.reset();
+    top_level_ = NodeList{};
+    lookahead_ = nullptr;
+    brace_depth_ = 0;
+    sync_depth_ = 0;
+    error_pending_ = false;
+    syncing_ = false;
+    lexer_ = nullptr;
+    source_ = nullptr;
+    source_fetch_ = nullptr;
     token_storage_.clear();
+    token_buffer_ = {};
+    token_pos_ = 0;
     bison_parser_ = std::make_unique<detail::BisonParser>(*this);
 }
 
 void Parser::add_error(ParseError error) {
+    if (error_limit_ != 0 && errors_.size() >= error_limit_) {
+        error_limit_reached_ = true;
+        return;
+    }
     errors_.push_back(std::move(error));
 }
 
-void Parser::set_result(ASTNode node) {
-    result_ = std::move(node);
+void Parser::add_lex_error(const Token& tok) {
+    add_error(lex_error(tok));
 }
 
-Token Parser::next_token() {
-    if (token_provider_) {
-        return token_provider_();
+void Parser::add_top_level(NodeId stmt) {
+    if (stmt != kNoNode) {
+        top_level_.push_back(arena_, stmt);
     }
-    // 如果没有 provider，返回 END token
-    Token tok;
-    tok.type = TokenType::END;
-    tok.begin = Location{0, 0, 0};
-    tok.end = Location{0, 0, 0};
-    return tok;
+}
+
+bool Parser::begin_sync() {
+    if (!error_pending_) {
+        return false;  // 同一次错误中 Bison 再次丢弃 token 后的归约，按默认方式逐个丢弃
+    }
+    error_pending_ = false;
+    
+    // 出错的 token 本身就是语句边界，Bison 会直接用它继续
+    if (!lookahead_ || lookahead_->type == TokenType::END ||
+        lookahead_->type == TokenType::SEMI || lookahead_->type == TokenType::RBRACE) {
+        return false;
+    }
+    
+    // 出错的 "{" 已计入深度但不会被移进，同步点在它外面一层
+    sync_depth_ = brace_depth_ - (lookahead_->type == TokenType::LBRACE ? 1 : 0);
+    syncing_ = true;
+    return true;
+}
+
+const Token* Parser::skip_to_sync(const Token* tok) {
+    for (;; tok = fetch_token()) {
+        switch (tok->type) {
+            case TokenType::END:
+                syncing_ = false;
+                return tok;
+            case TokenType::SEMI:
+                if (brace_depth_ == sync_depth_) {
+                    syncing_ = false;
+                    return tok;
+                }
+                break;
+            case TokenType::RBRACE:
+                if (brace_depth_ == sync_depth_) {
+                    syncing_ = false;
+                    return tok;  // 闭合当前块，深度由 yylex 更新
+                }
+                --brace_depth_;
+                break;
+            case TokenType::LBRACE:
+                ++brace_depth_;
+                break;
+            case TokenType::ERROR:
+                add_lex_error(*tok);
+                break;
+            default:
+                break;
+        }
+        if (unlikely_(error_limit_reached_)) {
+            syncing_ = false;
+            return tok;
+        }
+    }
+}
+
+NodeId Parser::finish_program() {
+    NodeId stmt_list = ast_.add(ASTNode::NodeType::StmtList, nullptr, top_level_);
+    NodeId program = ast_.add(ASTNode::NodeType::Program, nullptr, {&stmt_list, 1});
+    ast_.set_root(program);
+    return program;
 }
 
 const Token* Parser::store_token(Token tok) {
-    token_storage_.push_back(std::move(tok));
-    return &token_storage_.back();
+    return token_storage_.push(tok);
+}
+
+const Token* Parser::fetch_token() {
+    if (lexer_ || source_fetch_) {
+        // Lexer 模式：next() 内联到这里，token 直接构造在 token_storage_ 中
+        // TokenSource 模式：经由按来源类型实例化的函数取 token
+        const Token* tok = lexer_
+            ? token_storage_.emplace([this] { return lexer_->next(); })
+            : source_fetch_(*this, source_);
+        
+        // 读到 END 后不再向来源要 token（Bison 接受前还会再读一次 $end），
+        // 之后按耗尽的缓冲区处理，在该 token 之后补 END
+        if (unlikely_(tok->type == TokenType::END)) {
+            lexer_ = nullptr;
+            source_fetch_ = nullptr;
+            token_buffer_ = std::span<const Token>(tok, 1);
+            token_pos_ = 1;
+        }
+        return tok;
+    }
+    
+    // token-buffer 模式：直接引用缓冲区中的 token，不再拷贝
+    if (token_pos_ < token_buffer_.size()) {
+        return &token_buffer_[token_pos_++];
+    }
+    
+    // 缓冲区耗尽（或没有任何输入）：在最后一个 token 之后补一个 END
+    Token tok;
+    tok.type = TokenType::END;
+    tok.begin = token_buffer_.empty() ? 0 : token_buffer_.back().end();
+    return store_token(tok);
 }
 
 // ============================================================================
@@ -75,17 +254,22 @@ const Token* Parser::store_token(Token tok) {
 namespace detail {
 
 BisonParser::symbol_type yylex(Parser& parser) {
-    Token tok = parser.next_token();
+    // 获取 Token 的稳定指针（token-buffer 模式下不拷贝）
+    const Token* tok_ptr = parser.fetch_token();
     
-    // 存储 Token 以保持生命周期，并获取指针
-    const Token* tok_ptr = parser.store_token(std::move(tok));
+    // 错误恢复中：跳到下一个语句边界
+    if (unlikely_(parser.syncing())) {
+        tok_ptr = parser.skip_to_sync(tok_ptr);
+    }
+    
+    // 创建 location 信息（字节偏移区间）
+    BisonParser::location_type loc = tok_ptr->span();
     
-    // 创建 location 信息
-    BisonParser::location_type loc;
-    loc.begin.line = tok_ptr->begin.line;
-    loc.begin.column = tok_ptr->begin.col;
-    loc.end.line = tok_ptr->end.line;
-    loc.end.column = tok_ptr->end.col;
+    // 错误数已达上限：按输入结束处理，尽快结束分析（已归约的顶层语句仍保留）
+    if (unlikely_(parser.error_limit_reached())) {
+        return BisonParser::make_END(loc);
+    }
+    parser.set_lookahead(tok_ptr);
     
     // 根据 token 类型返回相应的 symbol
     switch (tok_ptr->type) {
@@ -172,8 +356,10 @@ BisonParser::symbol_type yylex(Parser& parser) {
         case TokenType::RPAREN:
             return BisonParser::make_RPAREN(loc);
         case TokenType::LBRACE:
+            parser.open_brace();
             return BisonParser::make_LBRACE(loc);
         case TokenType::RBRACE:
+            parser.close_brace();
             return BisonParser::make_RBRACE(loc);
         case TokenType::LBRACK:
             return BisonParser::make_LBRACK(loc);
@@ -194,14 +380,11 @@ BisonParser::symbol_type yylex(Parser& parser) {
         case TokenType::PIPE:
             return BisonParser::make_PIPE(loc);
         
-        // 错误 token
+        // 错误 token：记录后交给 Bison 的错误恢复（YYerror 不会再触发 error()），继续分析
         case TokenType::ERROR:
-            parser.add_error(ParseError{
-                ParseErrorType::UnexpectedToken,
-                tok_ptr->begin,
-                "Lexical error"
-            });
-            return BisonParser::make_END(loc);
+            parser.add_lex_error(*tok_ptr);
+            parser.note_syntax_error();
+            return BisonParser::make_YYerror(loc);
         
         default:
             parser.add_error(ParseError{
@@ -209,7 +392,8 @@ BisonParser::symbol_type yylex(Parser& parser) {
                 tok_ptr->begin,
                 "Unknown token type"
             });
-            return BisonParser::make_END(loc);
+            parser.note_syntax_error();
+            return BisonParser::make_YYerror(loc);
     }
 }
 
@@ -0,0 +1,737 @@
+#include "pratt_parser.hpp"
+#include "ast_builder.hpp"
+#include <string>
+
+namespace prim::detail {
+
+using namespace prim::builder;
+
+namespace {
+
+// 二元运算符的优先级（0 表示不是二元运算符），与 parser.y 中表达式规则的层次一一对应
+int binary_precedence(TokenType type) {
+    switch (type) {
+        case TokenType::EQ:
+            return 1;  // assignment_expr（右结合）
+        case TokenType::OROR:
+            return 2;
+        case TokenType::ANDAND:
+            return 3;
+        case TokenType::EQEQ:
+        case TokenType::NEQ:
+            return 4;
+        case TokenType::LT:
+        case TokenType::GT:
+        case TokenType::LE:
+        case TokenType::GE:
+            return 5;
+        case TokenType::PLUS:
+        case TokenType::MINUS:
+            return 6;
+        case TokenType::STAR:
+        case TokenType::SLASH:
+        case TokenType::PERCENT:
+            return 7;
+        default:
+            return 0;
+    }
+}
+
+// FIRST(expr)：可以开始一个表达式的 token
+bool starts_expr(TokenType type) {
+    switch (type) {
+        case TokenType::INT_DEC:
+        case TokenType::INT_HEX:
+        case TokenType::INT_OCT:
+        case TokenType::INT_BIN:
+        case TokenType::FLOAT_DEC:
+        case TokenType::STRING:
+        case TokenType::KW_TRUE:
+        case TokenType::KW_FALSE:
+        case TokenType::KW_NULL:
+        case TokenType::IDENT:
+        case TokenType::LPAREN:
+        case TokenType::LBRACK:
+        case TokenType::LBRACE:
+        case TokenType::KW_IF:
+        case TokenType::KW_LOOP:
+        case TokenType::AT:
+        case TokenType::DOLLAR:
+        case TokenType::BANG:
+        case TokenType::PLUS:
+        case TokenType::MINUS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// 报错时的 token 名，与 parser.y 中 %token 的别名相同
+const char* token_name(TokenType type) {
+    switch (type) {
+        case TokenType::END:       return "end of file";
+        case TokenType::KW_LET:    return "let";
+        case TokenType::KW_DEL:    return "del";
+        case TokenType::KW_IF:     return "if";
+        case TokenType::KW_ELSE:   return "else";
+        case TokenType::KW_LOOP:   return "loop";
+        case TokenType::KW_BREAK:  return "break";
+        case TokenType::KW_RETURN: return "return";
+        case TokenType::KW_TRUE:   return "true";
+        case TokenType::KW_FALSE:  return "false";
+        case TokenType::KW_NULL:   return "null";
+        case TokenType::IDENT:     return "identifier";
+        case TokenType::INT_DEC:   return "int_dec";
+        case TokenType::INT_HEX:   return "int_hex";
+        case TokenType::INT_OCT:   return "int_oct";
+        case TokenType::INT_BIN:   return "int_bin";
+        case TokenType::FLOAT_DEC: return "float";
+        case TokenType::STRING:    return "string";
+        case TokenType::LABEL:     return "label";
+        case TokenType::PLUS:      return "+";
+        case TokenType::MINUS:     return "-";
+        case TokenType::STAR:      return "*";
+        case TokenType::SLASH:     return "/";
+        case TokenType::PERCENT:   return "%";
+        case TokenType::EQ:        return "=";
+        case TokenType::EQEQ:      return "==";
+        case TokenType::NEQ:       return "!=";
+        case TokenType::LT:        return "<";
+        case TokenType::GT:        return ">";
+        case TokenType::LE:        return "<=";
+        case TokenType::GE:        return ">=";
+        case TokenType::ANDAND:    return "&&";
+        case TokenType::OROR:      return "||";
+        case TokenType::BANG:      return "!";
+        case TokenType::AMP:       return "&";
+        case TokenType::LPAREN:    return "(";
+        case TokenType::RPAREN:    return ")";
+        case TokenType::LBRACE:    return "{";
+        case TokenType::RBRACE:    return "}";
+        case TokenType::LBRACK:    return "[";
+        case TokenType::RBRACK:    return "]";
+        case TokenType::SEMI:      return ";";
+        case TokenType::COMMA:     return "\",\"";  // Bison 对 "," 保留引号
+        case TokenType::COLON:     return ":";
+        case TokenType::AT:        return "@";
+        case TokenType::DOLLAR:    return "$";
+        case TokenType::DOT:       return ".";
+        case TokenType::PIPE:      return "|";
+        default:                   return "invalid token";
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// token
+// ============================================================================
+
+// 与 yylex 相同：同步中跳过 token、错误数上限、括号深度、词法错误
+void PrattParser::advance() {
+    const Token* tok = parser_.fetch_token();
+    if (unlikely_(parser_.syncing())) {
+        tok = parser_.skip_to_sync(tok);
+    }
+    tok_ = tok;
+
+    // 错误数已达上限：按输入结束处理
+    if (unlikely_(parser_.error_limit_reached())) {
+        type_ = TokenType::END;
+        return;
+    }
+    parser_.set_lookahead(tok);
+    type_ = tok->type;
+
+    switch (type_) {
+        case TokenType::LBRACE:
+            parser_.open_brace();
+            break;
+        case TokenType::RBRACE:
+            parser_.close_brace();
+            break;
+        case TokenType::ERROR:
+            // 记录后当作不匹配任何规则的 token，由所在的语句列表恢复（不再报告语法错误）
+            parser_.add_lex_error(*tok);
+            parser_.note_syntax_error();
+            break;
+        case TokenType::START:
+            parser_.add_error(ParseError{
+                ParseErrorType::UnexpectedToken,
+                tok->begin,
+                "Unknown token type"
+            });
+            parser_.note_syntax_error();
+            type_ = TokenType::ERROR;
+            break;
+        default:
+            break;
+    }
+}
+
+// 移进当前 token，返回它
+const Token* PrattParser::consume() {
+    const Token* tok = tok_;
+    if (err_status_ > 0) --err_status_;
+    advance();
+    return tok;
+}
+
+// 当前 token 必须是 type，否则报错并返回 nullptr
+const Token* PrattParser::expect(TokenType type) {
+    if (type_ == type) return consume();
+    syntax_error({type});
+    return nullptr;
+}
+
+// ============================================================================
+// 错误
+// ============================================================================
+
+// 在当前 token 处报告语法错误，之后回退到最近的语句列表
+void PrattParser::syntax_error(std::initializer_list<TokenType> expected) {
+    if (failed_) return;
+    failed_ = true;
+
+    // 与 Bison 相同：恢复后还没移进任何 token 就在文件结束处再次出错，中止分析
+    if (err_status_ == 3 && type_ == TokenType::END) {
+        aborted_ = true;
+        return;
+    }
+
+    // 恢复期间（以及词法错误 token 处）不报告新的语法错误
+    if (err_status_ != 0 || type_ == TokenType::ERROR) return;
+
+    std::string message = "syntax error, unexpected ";
+    message += token_name(type_);
+    const char* sep = ", expecting ";
+    for (TokenType t : expected) {
+        message += sep;
+        message += token_name(t);
+        sep = " or ";
+    }
+    parser_.add_error(ParseError{ParseErrorType::InvalidSyntax, tok_->begin, std::move(message)});
+    parser_.note_syntax_error();
+}
+
+// 在语句列表中恢复，相当于归约 stmt: error
+void PrattParser::recover() {
+    failed_ = false;
+    const bool again = err_status_ == 3;  // 上次恢复后没有移进任何 token
+    err_status_ = 3;
+
+    // 正常情况由 begin_sync() 决定是否丢弃出错的 token 并同步到语句边界；
+    // 不报告的连续错误与 Bison 一样逐个丢弃 token，保证每次恢复都向前推进
+    if (parser_.begin_sync() || (again && type_ != TokenType::END)) {
+        advance();
+    }
+}
+
+bool PrattParser::too_deep() {
+    if (depth_ <= kMaxDepth) return false;
+    if (!failed_) {
+        parser_.add_error(ParseError{
+            ParseErrorType::InvalidSyntax,
+            tok_->begin,
+            "expression nested too deeply"
+        });
+        parser_.note_syntax_error();
+        failed_ = true;
+    }
+    return true;
+}
+
+// ============================================================================
+// 语句
+// ============================================================================
+
+int PrattParser::parse() {
+    advance();
+    parse_top_level();
+    if (aborted_) return 1;
+
+    // program: top_stmt_list_opt END
+    parser_.finish_program();
+    return 0;
+}
+
+// top_stmt_list：语句逐条交给 parser 保存，分号可以重复或出现在末尾
+void PrattParser::parse_top_level() {
+    if (type_ == TokenType::END) return;
+
+    NodeId stmt = parse_stmt();
+    for (;;) {
+        if (failed_) {
+            if (aborted_) return;
+            recover();
+            stmt = kNoNode;
+        }
+        parser_.add_top_level(stmt);
+        stmt = kNoNode;
+
+        if (type_ == TokenType::END) return;
+        if (type_ != TokenType::SEMI) {
+            syntax_error({TokenType::END});  // Bison 此时已归约到 program: top_stmt_list_opt . END
+            continue;
+        }
+        while (type_ == TokenType::SEMI) consume();
+        if (type_ == TokenType::END) return;
+        stmt = parse_stmt();
+    }
+}
+
+// stmt_list 中第一条语句之后的部分（stmt 为第一条语句，出错时由 failed_ 表示），
+// 停在 "}" 或文件结束处，由调用方检查
+void PrattParser::parse_stmt_list(NodeList& stmts, NodeId stmt) {
+    for (;;) {
+        if (failed_) {
+            if (aborted_) return;
+            recover();
+            stmt = kNoNode;
+        }
+        stmt_list_add(parser_, stmts, stmt);
+        stmt = kNoNode;
+
+        if (type_ == TokenType::RBRACE || type_ == TokenType::END) return;
+        if (type_ != TokenType::SEMI) {
+            syntax_error({TokenType::RBRACE, TokenType::SEMI});
+            continue;
+        }
+        while (type_ == TokenType::SEMI) consume();
+        if (type_ == TokenType::RBRACE) return;
+        stmt = parse_stmt();
+    }
+}
+
+NodeId PrattParser::parse_stmt() {
+    switch (type_) {
+        case TokenType::KW_LET:
+            return parse_let();
+        case TokenType::KW_DEL:
+            return parse_del();
+        case TokenType::KW_BREAK:
+            return parse_break();
+        case TokenType::KW_RETURN:
+            return parse_return();
+        default: {
+            NodeId expr = parse_expr();
+            return failed_ ? kNoNode : create_expr_stmt(parser_, expr);
+        }
+    }
+}
+
+// "let" let_target ("," let_target)* ["=" (expr | ref_expr)]
+NodeId PrattParser::parse_let() {
+    consume();
+    NodeList targets;
+    for (;;) {
+        NodeId target = parse_let_target();
+        if (failed_) return kNoNode;
+        list_add(parser_, targets, target);
+        if (type_ != TokenType::COMMA) break;
+        consume();
+    }
+
+    NodeId rhs = kNoNode;
+    if (type_ == TokenType::EQ) {
+        consume();
+        rhs = parse_expr_or_ref();
+        if (failed_) return kNoNode;
+    }
+    return create_let_stmt(parser_, targets, rhs);
+}
+
+// ["&"] "identifier" type_hint_opt
+NodeId PrattParser::parse_let_target() {
+    const bool is_ref = type_ == TokenType::AMP;
+    if (is_ref) consume();
+    const Token* name = expect(TokenType::IDENT);
+    if (!name) return kNoNode;
+    NodeId hint = parse_type_hint_opt();
+    if (failed_) return kNoNode;
+    return create_let_target(parser_, name, hint, is_ref);
+}
+
+// "del" "identifier" ("," "identifier")*
+NodeId PrattParser::parse_del() {
+    consume();
+    NodeList idents;
+    for (;;) {
+        const Token* name = expect(TokenType::IDENT);
+        if (!name) return kNoNode;
+        ident_list_add(parser_, idents, name);
+        if (type_ != TokenType::COMMA) break;
+        consume();
+    }
+    return create_del_stmt(parser_, idents);
+}
+
+// "break" ["label"] [expr | ref_expr]
+NodeId PrattParser::parse_break() {
+    consume();
+    const Token* label = type_ == TokenType::LABEL ? consume() : nullptr;
+    NodeId value = kNoNode;
+    if (starts_expr(type_) || type_ == TokenType::AMP) {
+        value = parse_expr_or_ref();
+        if (failed_) return kNoNode;
+    }
+    return create_break_stmt(parser_, label, value);
+}
+
+// "return" [expr | ref_expr]
+NodeId PrattParser::parse_return() {
+    consume();
+    NodeId value = kNoNode;
+    if (starts_expr(type_) || type_ == TokenType::AMP) {
+        value = parse_expr_or_ref();
+        if (failed_) return kNoNode;
+    }
+    return create_return_stmt(parser_, value);
+}
+
+// [":" "identifier" ("|" "identifier")*]
+NodeId PrattParser::parse_type_hint_opt() {
+    if (type_ != TokenType::COLON) return kNoNode;
+    consume();
+    NodeList idents;
+    for (;;) {
+        const Token* name = expect(TokenType::IDENT);
+        if (!name) return kNoNode;
+        ident_list_add(parser_, idents, name);
+        if (type_ != TokenType::PIPE) break;
+        consume();
+    }
+    return create_type_hint(parser_, idents);
+}
+
+// ============================================================================
+// 表达式
+// ============================================================================
+
+// 优先级不低于 min_precedence 的二元运算链；"=" 右结合，其余左结合
+NodeId PrattParser::parse_expr(int min_precedence) {
+    DepthGuard guard(depth_);
+    if (too_deep()) return kNoNode;
+
+    NodeId left = parse_unary();
+    while (!failed_) {
+        const int precedence = binary_precedence(type_);
+        if (precedence < min_precedence || precedence == 0) break;
+        const bool right_assoc = type_ == TokenType::EQ;
+        const Token* op = consume();
+        NodeId right = parse_expr(right_assoc ? precedence : precedence + 1);
+        if (failed_) break;
+        left = create_binary_expr(parser_, op, left, right);
+    }
+    return failed_ ? kNoNode : left;
+}
+
+// expr | "&" primary_expr（let 右侧、break / return 的值、列表元素、dict 的值）
+NodeId PrattParser::parse_expr_or_ref() {
+    if (type_ != TokenType::AMP) return parse_expr();
+    consume();
+    NodeId target = parse_primary();
+    if (failed_) return kNoNode;
+    return create_ref_expr(parser_, target);
+}
+
+// ("!" | "+" | "-")* postfix_expr
+NodeId PrattParser::parse_unary() {
+    if (type_ != TokenType::BANG && type_ != TokenType::PLUS && type_ != TokenType::MINUS) {
+        return parse_postfix();
+    }
+    DepthGuard guard(depth_);
+    if (too_deep()) return kNoNode;
+
+    const Token* op = consume();
+    NodeId operand = parse_unary();
+    if (failed_) return kNoNode;
+    return create_unary_expr(parser_, op, operand);
+}
+
+// primary_expr ("(" expr_list_opt ")" | "[" expr "]" | "[" expr_opt ":" expr_opt "]" | "." "identifier")*
+NodeId PrattParser::parse_postfix() {
+    NodeId expr = parse_primary();
+    while (!failed_) {
+        switch (type_) {
+            case TokenType::LPAREN: {
+                consume();
+                NodeList args;
+                if (type_ != TokenType::RPAREN) parse_expr_list(args);
+                if (failed_ || !expect(TokenType::RPAREN)) return kNoNode;
+                expr = create_call_expr(parser_, expr, args);
+                break;
+            }
+            case TokenType::LBRACK: {
+                consume();
+                NodeId from = kNoNode;
+                if (type_ != TokenType::COLON) {
+                    from = parse_expr();
+                    if (failed_) return kNoNode;
+                    if (type_ == TokenType::RBRACK) {
+                        consume();
+                        expr = create_index_expr(parser_, expr, from);
+                        break;
+                    }
+                    if (type_ != TokenType::COLON) {
+                        syntax_error({TokenType::RBRACK, TokenType::COLON});
+                        return kNoNode;
+                    }
+                }
+                consume();  // 切片
+                NodeId to = kNoNode;
+                if (type_ != TokenType::RBRACK) {
+                    to = parse_expr();
+                    if (failed_) return kNoNode;
+                }
+                if (!expect(TokenType::RBRACK)) return kNoNode;
+                expr = create_slice_expr(parser_, expr, from, to);
+                break;
+            }
+            case TokenType::DOT: {
+                consume();
+                const Token* field = expect(TokenType::IDENT);
+                if (!field) return kNoNode;
+                expr = create_field_expr(parser_, expr, field);
+                break;
+            }
+            default:
+                return expr;
+        }
+    }
+    return kNoNode;
+}
+
+NodeId PrattParser::parse_primary() {
+    switch (type_) {
+        case TokenType::INT_DEC:
+        case TokenType::INT_HEX:
+        case TokenType::INT_OCT:
+        case TokenType::INT_BIN:
+        case TokenType::FLOAT_DEC:
+        case TokenType::STRING:
+        case TokenType::KW_TRUE:
+        case TokenType::KW_FALSE:
+        case TokenType::KW_NULL:
+            return create_literal(parser_, consume());
+        case TokenType::IDENT:
+            return create_identifier(parser_, consume());
+        case TokenType::LPAREN:
+            return parse_paren();
+        case TokenType::LBRACK:
+            return parse_list();
+        case TokenType::LBRACE:
+            return parse_brace();
+        case TokenType::KW_IF:
+            return parse_if();
+        case TokenType::KW_LOOP:
+            return parse_loop();
+        case TokenType::AT:
+            return parse_at();
+        case TokenType::DOLLAR:
+            return parse_named_prim({});
+        default:
+            syntax_error();
+            return kNoNode;
+    }
+}
+
+// (expr | ref_expr) ("," (expr | ref_expr))*，不含尾随逗号
+void PrattParser::parse_expr_list(NodeList& items) {
+    for (;;) {
+        NodeId item = parse_expr_or_ref();
+        if (failed_) return;
+        list_add(parser_, items, item);
+        if (type_ != TokenType::COMMA) return;
+        consume();
+    }
+}
+
+// "(" ")" = null，"(" expr ")" = 括号消除，其余为 tuple
+NodeId PrattParser::parse_paren() {
+    consume();
+    if (type_ == TokenType::RPAREN) {
+        consume();
+        return create_literal(parser_, nullptr);
+    }
+
+    const bool is_ref = type_ == TokenType::AMP;
+    NodeId first = parse_expr_or_ref();
+    if (failed_) return kNoNode;
+    if (type_ == TokenType::RPAREN && !is_ref) {
+        consume();
+        return first;
+    }
+    if (!expect(TokenType::COMMA)) return kNoNode;
+
+    // (expr,) / (a, b) / (a, b,)
+    NodeList rest;
+    bool trailing_comma = true;
+    while (type_ != TokenType::RPAREN) {
+        NodeId item = parse_expr_or_ref();
+        if (failed_) return kNoNode;
+        list_add(parser_, rest, item);
+        trailing_comma = false;
+        if (type_ != TokenType::COMMA) break;
+        consume();
+        trailing_comma = true;
+    }
+    if (!expect(TokenType::RPAREN)) return kNoNode;
+    return create_tuple_expr(parser_, first, rest, trailing_comma);
+}
+
+// "[" expr_list_opt "]"
+NodeId PrattParser::parse_list() {
+    consume();
+    NodeList items;
+    if (type_ != TokenType::RBRACK) parse_expr_list(items);
+    if (failed_ || !expect(TokenType::RBRACK)) return kNoNode;
+    return create_list_expr(parser_, items);
+}
+
+// 表达式位置的 "{"：空 dict、dict 或 scope，由第一个表达式后是否为 ":" 决定
+NodeId PrattParser::parse_brace() {
+    consume();
+    if (type_ == TokenType::RBRACE) {
+        consume();
+        return create_dict_expr(parser_, {});
+    }
+
+    NodeId first = kNoNode;
+    if (starts_expr(type_)) {
+        NodeId expr = parse_expr();
+        if (!failed_ && type_ == TokenType::COLON) {
+            NodeId dict = parse_dict(expr);
+            if (!failed_ || aborted_) return dict;
+            // dict 中出错：与 Bison 相同，回到 "{" 处按 scope 的语句列表恢复
+        } else if (!failed_) {
+            first = create_expr_stmt(parser_, expr);
+        }
+    } else {
+        first = parse_stmt();
+    }
+
+    NodeList stmts;
+    parse_stmt_list(stmts, first);
+    if (failed_ || !expect(TokenType::RBRACE)) return kNoNode;
+    return create_scope_expr(parser_, stmts, !stmts.empty());
+}
+
+// dict_pair ("," dict_pair)* [","] "}"，第一个键已经分析
+NodeId PrattParser::parse_dict(NodeId first_key) {
+    NodeList pairs;
+    NodeId key = first_key;
+    for (;;) {
+        if (!expect(TokenType::COLON)) return kNoNode;
+        NodeId value = parse_expr_or_ref();
+        if (failed_) return kNoNode;
+        list_add(parser_, pairs, create_dict_pair(parser_, key, value));
+
+        if (type_ != TokenType::COMMA) break;
+        consume();
+        if (type_ == TokenType::RBRACE) break;  // 尾随逗号
+        key = parse_expr();
+        if (failed_) return kNoNode;
+    }
+    if (!expect(TokenType::RBRACE)) return kNoNode;
+    return create_dict_expr(parser_, pairs);
+}
+
+// "{" stmt_list "}"：if / loop 的 block 和 prim 的 scope
+NodeId PrattParser::parse_scope(ASTNode::NodeType type) {
+    if (!expect(TokenType::LBRACE)) return kNoNode;
+    NodeList stmts;
+    parse_stmt_list(stmts, parse_stmt());
+    if (failed_ || !expect(TokenType::RBRACE)) return kNoNode;
+    return type == NodeType::BlockExpr
+        ? create_block_expr(parser_, stmts, !stmts.empty())
+        : create_scope_expr(parser_, stmts, !stmts.empty());
+}
+
+// "if" expr block_expr ["else" (block_expr | if_expr)]
+NodeId PrattParser::parse_if() {
+    DepthGuard guard(depth_);
+    if (too_deep()) return kNoNode;
+
+    consume();
+    NodeId cond = parse_expr();
+    if (failed_) return kNoNode;
+    NodeId then_block = parse_scope(NodeType::BlockExpr);
+    if (failed_) return kNoNode;
+
+    NodeId else_expr = kNoNode;
+    if (type_ == TokenType::KW_ELSE) {
+        consume();
+        else_expr = type_ == TokenType::KW_IF ? parse_if() : parse_scope(NodeType::BlockExpr);
+        if (failed_) return kNoNode;
+    }
+    return create_if_expr(parser_, cond, then_block, else_expr);
+}
+
+// "loop" ["label"] block_expr
+NodeId PrattParser::parse_loop() {
+    consume();
+    const Token* label = type_ == TokenType::LABEL ? consume() : nullptr;
+    NodeId body = parse_scope(NodeType::BlockExpr);
+    if (failed_) return kNoNode;
+    return create_loop_expr(parser_, label, body);
+}
+
+// "@" scope_expr，或装饰器 ("@" "identifier")+ 后接 "@" scope_expr / named_prim
+NodeId PrattParser::parse_at() {
+    consume();
+    NodeList decorators;
+    while (type_ != TokenType::LBRACE) {
+        const Token* name = expect(TokenType::IDENT);
+        if (!name) return kNoNode;
+        ident_list_add(parser_, decorators, name);
+
+        if (type_ == TokenType::DOLLAR) return parse_named_prim(decorators);
+        if (!expect(TokenType::AT)) return kNoNode;
+    }
+
+    NodeId scope = parse_scope(NodeType::ScopeExpr);
+    if (failed_) return kNoNode;
+    return create_unnamed_prim(parser_, decorators, scope);
+}
+
+// "$" "identifier" "(" param_list_opt ")" type_hint_opt ["@"] scope_expr
+NodeId PrattParser::parse_named_prim(const NodeList& decorators) {
+    consume();
+    const Token* name = expect(TokenType::IDENT);
+    if (!name || !expect(TokenType::LPAREN)) return kNoNode;
+
+    // 参数之间的逗号可以重复，也可以出现在末尾
+    NodeList params;
+    if (type_ != TokenType::RPAREN) {
+        for (;;) {
+            NodeId param = parse_param();
+            if (failed_) return kNoNode;
+            list_add(parser_, params, param);
+            if (type_ != TokenType::COMMA) break;
+            while (type_ == TokenType::COMMA) consume();
+            if (type_ != TokenType::IDENT && type_ != TokenType::AMP) break;
+        }
+    }
+    if (!expect(TokenType::RPAREN)) return kNoNode;
+
+    NodeId ret = parse_type_hint_opt();
+    if (failed_) return kNoNode;
+    if (type_ == TokenType::AT) consume();
+    NodeId impl = parse_scope(NodeType::ScopeExpr);
+    if (failed_) return kNoNode;
+    return create_named_prim(parser_, decorators, name, params, ret, impl);
+}
+
+// ["&"] "identifier" type_hint_opt
+NodeId PrattParser::parse_param() {
+    const bool is_ref = type_ == TokenType::AMP;
+    if (is_ref) consume();
+    const Token* name = expect(TokenType::IDENT);
+    if (!name) return kNoNode;
+    NodeId hint = parse_type_hint_opt();
+    if (failed_) return kNoNode;
+    return create_param(parser_, name, hint, is_ref);
+}
+
+} // namespace prim::detail
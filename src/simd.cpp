@@ -0,0 +1,105 @@
+// simd.cpp - 扫描内核：标量 / SSE2 实现与运行时选择
+#include "simd_impl.hpp"
+
+#include <atomic>
+
+#if defined(ARCH_X64_)
+    #include <emmintrin.h>
+    #if defined(COMPILER_MSVC_)
+        #include <intrin.h>
+    #endif
+#endif
+
+namespace prim::simd {
+
+namespace {
+
+// ============================================================================
+// 各实现的内核表
+// ============================================================================
+
+constexpr Kernels kScalar{
+    "scalar",
+    skip_whitespace_scalar,
+    skip_line_scalar,
+    skip_string_scalar,
+    skip_comment_scalar,
+};
+
+#if defined(ARCH_X64_)
+
+// SSE2 是 x86-64 的基线指令集，无需运行时检测
+struct Sse2 {
+    using vec = __m128i;
+    static constexpr size_t kWidth = 16;
+
+    static force_inline_ vec load(Ptr p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static force_inline_ vec eq(vec v, char c) { return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); }
+    static force_inline_ vec any(vec a, vec b) { return _mm_or_si128(a, b); }
+    static force_inline_ uint32_t bits(vec v) { return uint32_t(_mm_movemask_epi8(v)); }
+};
+
+constexpr Kernels kSse2 = make_kernels<Sse2>("sse2");
+
+// CPU 和操作系统都支持 AVX2（操作系统须保存 YMM 寄存器状态）
+bool cpu_has_avx2() {
+#if defined(COMPILER_MSVC_)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx     = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(COMPILER_GCC_) || defined(COMPILER_CLANG_)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+#endif // ARCH_X64_
+
+const Kernels* detect() {
+#if defined(ARCH_X64_)
+    if (const Kernels* avx2 = avx2_kernels(); avx2 && cpu_has_avx2()) return avx2;
+    return &kSse2;
+#else
+    return &kScalar;
+#endif
+}
+
+std::atomic<const Kernels*> g_active{nullptr};
+
+} // namespace
+
+// ============================================================================
+// 对外接口
+// ============================================================================
+
+const Kernels& kernels() {
+    const Kernels* k = g_active.load(std::memory_order_acquire);
+    if (unlikely_(!k)) {
+        static const Kernels* const best = detect();
+        k = best;
+        g_active.store(k, std::memory_order_release);
+    }
+    return *k;
+}
+
+const Kernels* find_kernels(std::string_view name) {
+    if (name == "scalar") return &kScalar;
+#if defined(ARCH_X64_)
+    if (name == "sse2") return &kSse2;
+    if (name == "avx2") return cpu_has_avx2() ? avx2_kernels() : nullptr;
+#endif
+    return nullptr;
+}
+
+void use_kernels(const Kernels& k) {
+    g_active.store(&k, std::memory_order_release);
+}
+
+} // namespace prim::simd
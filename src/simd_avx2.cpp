@@ -0,0 +1,40 @@
+// simd_avx2.cpp - 扫描内核：AVX2 实现
+//
+// 本文件单独以 -mavx2（MSVC: /arch:AVX2）编译，见 CMakeLists.txt；
+// 只有 simd.cpp 在运行时确认 CPU 支持 AVX2 后才会调用这里的内核。
+// 本文件中不要包含会实例化共享 inline 函数的头文件（如 <algorithm>），以免 AVX2 代码泄漏到其他编译单元。
+#include "simd_impl.hpp"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+
+namespace prim::simd {
+
+#if defined(__AVX2__)
+
+namespace {
+
+struct Avx2 {
+    using vec = __m256i;
+    static constexpr size_t kWidth = 32;
+
+    static force_inline_ vec load(Ptr p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static force_inline_ vec eq(vec v, char c) { return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)); }
+    static force_inline_ vec any(vec a, vec b) { return _mm256_or_si256(a, b); }
+    static force_inline_ uint32_t bits(vec v) { return uint32_t(_mm256_movemask_epi8(v)); }
+};
+
+constexpr Kernels kAvx2 = make_kernels<Avx2>("avx2");
+
+} // namespace
+
+const Kernels* avx2_kernels() { return &kAvx2; }
+
+#else
+
+const Kernels* avx2_kernels() { return nullptr; }
+
+#endif
+
+} // namespace prim::simd
@@ -0,0 +1,205 @@
+#include "source.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+#include <fmt/format.h>
+
+#if !defined(_WIN32)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace prim {
+
+// ============================================================================
+// SourceBuffer 实现
+// ============================================================================
+
+SourceBuffer::~SourceBuffer() {
+    release();
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept {
+    *this = std::move(other);
+}
+
+SourceBuffer& SourceBuffer::operator=(SourceBuffer&& other) noexcept {
+    if (this == &other) return *this;
+    release();
+
+    size_     = other.size_;
+    map_base_ = std::exchange(other.map_base_, nullptr);
+    map_size_ = std::exchange(other.map_size_, 0);
+    owned_    = std::move(other.owned_);
+
+    // 短字符串优化下移动会改变地址，需要重新指向
+    if (map_base_) {
+        data_ = other.data_;
+    } else if (!owned_.empty()) {
+        data_ = owned_.data();
+    } else {
+        data_ = "";
+    }
+
+    other.data_ = "";
+    other.size_ = 0;
+    other.owned_.clear();
+    return *this;
+}
+
+void SourceBuffer::release() noexcept {
+#if !defined(_WIN32)
+    if (map_base_) {
+        ::munmap(map_base_, map_size_);
+    }
+#endif
+    map_base_ = nullptr;
+    map_size_ = 0;
+    data_ = "";
+    size_ = 0;
+    owned_.clear();
+}
+
+SourceBuffer SourceBuffer::from_string(std::string text) {
+    SourceBuffer buf;
+    buf.size_ = text.size();
+    buf.owned_ = std::move(text);
+    buf.owned_.push_back('\0');  // 哨兵
+    buf.data_ = buf.owned_.data();
+    return buf;
+}
+
+std::optional<SourceBuffer> SourceBuffer::map_file(const std::string& path) {
+#if !defined(_WIN32)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return std::nullopt;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return SourceBuffer{};
+    }
+
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t file_span = (size + page - 1) / page * page;
+    // 恰好整页时，文件映射之后没有可用的零字节，需要额外一页
+    const size_t map_size = (size % page == 0) ? file_span + page : file_span;
+
+    // 先保留整段匿名零页，再把文件覆盖映射到前部
+    void* base = ::mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        ::close(fd);
+        return std::nullopt;
+    }
+    void* file = ::mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    ::close(fd);
+    if (file == MAP_FAILED) {
+        ::munmap(base, map_size);
+        return std::nullopt;
+    }
+
+#if defined(MADV_SEQUENTIAL)
+    // 词法分析按顺序扫描，提示内核预读
+    ::madvise(base, size, MADV_SEQUENTIAL);
+#endif
+
+    SourceBuffer buf;
+    buf.map_base_ = base;
+    buf.map_size_ = map_size;
+    buf.data_ = static_cast<const char*>(base);
+    buf.size_ = size;
+    return buf;
+#else
+    // Windows: 退化为一次性读入
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return std::nullopt;
+    std::stringstream buffer; buffer << file.rdbuf();
+    return from_string(buffer.str());
+#endif
+}
+
+bool write_file_atomic(const std::string& path, std::string_view data) {
+    namespace fs = std::filesystem;
+    std::random_device random;
+    const std::string temp = fmt::format("{}.tmp.{:08x}{:08x}", path, random(), random());
+
+    std::error_code ec;
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), std::streamsize(data.size()));
+        out.close();
+        if (!out) {
+            fs::remove(temp, ec);
+            return false;
+        }
+    }
+    fs::rename(temp, path, ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// LineIndex 实现
+// ============================================================================
+
+void LineIndex::build() const {
+    starts_.push_back(0);
+    const char* base = source_.data();
+    const char* end  = base + source_.size();
+    for (const char* p = base; p < end;) {
+        p = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+        if (!p) break;
+        ++p;
+        starts_.push_back(uint32_t(p - base));
+    }
+}
+
+Location LineIndex::locate(uint32_t offset) const {
+    if (starts_.empty()) build();
+    // 最后一个起始偏移 <= offset 的行
+    auto it = std::upper_bound(starts_.begin(), starts_.end(), offset);
+    const uint32_t start = *(it - 1);
+    const int line = int(it - starts_.begin());
+
+    // '\r' 不占列
+    const uint32_t stop = std::min<uint32_t>(offset, uint32_t(source_.size()));
+    int col = 1 + int(offset - start);
+    for (uint32_t i = start; i < stop; ++i) {
+        if (source_[i] == '\r') --col;
+    }
+    return Location{line, col, int(offset)};
+}
+
+int LineIndex::line_count() const {
+    if (starts_.empty()) build();
+    const bool trailing_newline = !source_.empty() && source_.back() == '\n';
+    return int(starts_.size()) - (trailing_newline || source_.empty() ? 1 : 0);
+}
+
+std::string_view LineIndex::line_text(int line) const {
+    if (line <= 0 || line > line_count()) return {};
+    const size_t begin = starts_[size_t(line - 1)];
+    size_t end = size_t(line) < starts_.size() ? starts_[size_t(line)] - 1 : source_.size();
+    if (end > begin && source_[end - 1] == '\r') --end;
+    return source_.substr(begin, end - begin);
+}
+
+} // namespace prim
@@ -0,0 +1,227 @@
+#include "value.hpp"
+#include "hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fmt/format.h>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace prim {
+
+const char* value_type_name(ValueType type) {
+    switch (type) {
+        case ValueType::Undefined: return "undefined";
+        case ValueType::Unit:      return "unit";
+        case ValueType::Null:      return "null";
+        case ValueType::Bool:      return "bool";
+        case ValueType::Int:       return "int";
+        case ValueType::Float:     return "float";
+        case ValueType::Prim:      return "prim";
+        case ValueType::Builtin:   return "builtin";
+        case ValueType::Str:       return "str";
+        case ValueType::List:      return "list";
+        case ValueType::Tuple:     return "tuple";
+        case ValueType::Dict:      return "dict";
+    }
+    return "?";
+}
+
+void destroy(Object* obj) {
+    switch (obj->type) {
+        case ValueType::Int:   delete static_cast<IntObject*>(obj); break;
+        case ValueType::Str:   delete static_cast<StrObject*>(obj); break;
+        case ValueType::List:
+        case ValueType::Tuple: delete static_cast<ListObject*>(obj); break;
+        case ValueType::Dict:  delete static_cast<DictObject*>(obj); break;
+        default: break;
+    }
+}
+
+uint64_t Value::box_int(int64_t i) {
+    return kObjectTag | std::bit_cast<uint64_t>(static_cast<Object*>(new IntObject(i)));
+}
+
+// ============================================================================
+// 比较和哈希
+// ============================================================================
+//
+// 容器之间可以成环（a.push(a)），递归的比较、哈希和显示都要能结束
+
+namespace {
+
+using ObjectPair = std::pair<const Object*, const Object*>;
+
+// pairs：正在比较的容器对；再次遇到时视为相等（两边按相同的方式展开，之前没有发现差异）
+bool equal(const Value& a, const Value& b, std::vector<ObjectPair>& pairs) {
+    if (a.is_number() && b.is_number()) {
+        if (a.is_int() && b.is_int()) return a.as_int() == b.as_int();
+        return a.number() == b.number();
+    }
+    if (a.type() != b.type()) return false;
+
+    switch (a.type()) {
+        case ValueType::Str:
+            return a.object() == b.object() || as_str(a).text == as_str(b).text;
+        case ValueType::List:
+        case ValueType::Tuple:
+        case ValueType::Dict: {
+            if (a.object() == b.object()) return true;
+            const ObjectPair pair{a.object(), b.object()};
+            if (std::find(pairs.begin(), pairs.end(), pair) != pairs.end()) return true;
+            pairs.push_back(pair);
+            bool same = true;
+            if (a.type() == ValueType::Dict) {
+                DictObject& x = as_dict(a);
+                DictObject& y = as_dict(b);
+                same = x.entries.size() == y.entries.size();
+                for (size_t i = 0; same && i < x.entries.size(); ++i) {
+                    const Value* other = y.find(x.entries[i].first);
+                    same = other && equal(x.entries[i].second, *other, pairs);
+                }
+            } else {
+                const auto& x = as_list(a).items;
+                const auto& y = as_list(b).items;
+                same = x.size() == y.size();
+                for (size_t i = 0; same && i < x.size(); ++i) same = equal(x[i], y[i], pairs);
+            }
+            pairs.pop_back();
+            return same;
+        }
+        case ValueType::Bool:
+            return a.as_bool() == b.as_bool();
+        case ValueType::Prim:
+        case ValueType::Builtin:
+            return a.index() == b.index();
+        default:
+            return true;  // unit、null
+    }
+}
+
+// 整数值的浮点数与对应的整数哈希相同，其余按位模式
+uint64_t float_hash(double f) {
+    if (f == std::trunc(f) && f >= -0x1p63 && f < 0x1p63) return uint64_t(int64_t(f)) * detail::kXxhPrime1;
+    return std::bit_cast<uint64_t>(f) * detail::kXxhPrime2;
+}
+
+// 容器按先序最多哈希 kHashNodes 个值：相等的值展开后相同，结果也相同；成环时同样能结束
+constexpr size_t kHashNodes = 256;
+
+uint64_t hash(const Value& v, size_t& budget) {
+    --budget;
+    switch (v.type()) {
+        case ValueType::Int: {
+            // 超出 2^53 时 int 与 float 按 double 比较（见 equal），按舍入后的 double 哈希
+            constexpr int64_t kExact = int64_t(1) << 53;
+            const int64_t i = v.as_int();
+            if (i > kExact || i < -kExact) return float_hash(double(i));
+            return uint64_t(i) * detail::kXxhPrime1;
+        }
+        case ValueType::Float:
+            return float_hash(v.as_float());
+        case ValueType::Str:
+            return xxh64(as_str(v).text);
+        case ValueType::List:
+        case ValueType::Tuple: {
+            const auto& items = as_list(v).items;
+            uint64_t h = detail::xxh_merge(uint64_t(v.type()), items.size());
+            for (size_t i = 0; i < items.size() && budget > 0; ++i) h = detail::xxh_merge(h, hash(items[i], budget));
+            return h;
+        }
+        case ValueType::Dict:
+            return as_dict(v).entries.size();  // 与顺序无关
+        case ValueType::Bool:
+        case ValueType::Prim:
+        case ValueType::Builtin:
+            return (uint64_t(v.type()) << 32 | v.index()) * detail::kXxhPrime3;
+        default:
+            return uint64_t(v.type());
+    }
+}
+
+// path：正在显示的容器；再次遇到时显示为 [...] / (...) / {...}
+void append(std::string& out, const Value& v, bool quote, std::vector<const Object*>& path) {
+    auto it = std::back_inserter(out);
+    switch (v.type()) {
+        case ValueType::Undefined: out += "<undefined>"; break;
+        case ValueType::Unit:      out += "()"; break;
+        case ValueType::Null:      out += "null"; break;
+        case ValueType::Bool:      out += v.as_bool() ? "true" : "false"; break;
+        case ValueType::Int:       fmt::format_to(it, "{}", v.as_int()); break;
+        case ValueType::Float:     fmt::format_to(it, "{}", v.as_float()); break;
+        case ValueType::Prim:      fmt::format_to(it, "<prim #{}>", v.index()); break;
+        case ValueType::Builtin:   fmt::format_to(it, "<builtin #{}>", v.index()); break;
+        case ValueType::Str:
+            if (quote) fmt::format_to(it, "{:?}", as_str(v).text);
+            else       out += as_str(v).text;
+            break;
+        case ValueType::List:
+        case ValueType::Tuple: {
+            const bool list = v.type() == ValueType::List;
+            if (std::find(path.begin(), path.end(), v.object()) != path.end()) {
+                out += list ? "[...]" : "(...)";
+                break;
+            }
+            path.push_back(v.object());
+            const auto& items = as_list(v).items;
+            out += list ? '[' : '(';
+            for (size_t i = 0; i < items.size(); ++i) {
+                if (i) out += ", ";
+                append(out, items[i], true, path);
+            }
+            if (!list && items.size() == 1) out += ',';
+            out += list ? ']' : ')';
+            path.pop_back();
+            break;
+        }
+        case ValueType::Dict: {
+            if (std::find(path.begin(), path.end(), v.object()) != path.end()) {
+                out += "{...}";
+                break;
+            }
+            path.push_back(v.object());
+            out += '{';
+            bool first = true;
+            for (const auto& [key, value] : as_dict(v).entries) {
+                if (!first) out += ", ";
+                first = false;
+                append(out, key, true, path);
+                out += ": ";
+                append(out, value, true, path);
+            }
+            out += '}';
+            path.pop_back();
+            break;
+        }
+    }
+}
+
+} // namespace
+
+bool values_equal(const Value& a, const Value& b) {
+    std::vector<ObjectPair> pairs;
+    return equal(a, b, pairs);
+}
+
+uint64_t value_hash(const Value& v) {
+    size_t budget = kHashNodes;
+    return hash(v, budget);
+}
+
+// ============================================================================
+// 显示
+// ============================================================================
+
+void append_display(std::string& out, const Value& v, bool quote) {
+    std::vector<const Object*> path;
+    append(out, v, quote, path);
+}
+
+std::string display(const Value& v, bool quote) {
+    std::string out;
+    append_display(out, v, quote);
+    return out;
+}
+
+} // namespace prim
@@ -0,0 +1,823 @@
+#include "vm.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fmt/format.h>
+#include <string_view>
+
+// computed goto 需要 GCC / Clang 的 "labels as values" 扩展
+#if (defined(COMPILER_GCC_) || defined(COMPILER_CLANG_)) && !defined(PRIM_VM_SWITCH)
+    #define PRIM_VM_THREADED 1
+#else
+    #define PRIM_VM_THREADED 0
+#endif
+
+namespace prim {
+
+namespace {
+
+// ============================================================================
+// 内置函数
+// ============================================================================
+
+struct BuiltinContext {
+    std::FILE*  out;
+    std::string error;
+};
+
+// args 指向寄存器文件中连续的参数；结果写入 result，出错时设置 ctx.error 并返回 false
+using BuiltinFn = bool (*)(BuiltinContext& ctx, Value* args, size_t argc, Value& result);
+
+struct Builtin {
+    const char* name;
+    size_t      min_args;
+    size_t      max_args;  // SIZE_MAX 表示不限
+    BuiltinFn   fn;
+};
+
+bool wrong_type(BuiltinContext& ctx, const char* name, const Value& v) {
+    ctx.error = fmt::format("{}() does not accept a {}", name, value_type_name(v.type()));
+    return false;
+}
+
+bool builtin_print(BuiltinContext& ctx, Value* args, size_t argc, Value& result) {
+    std::string line;
+    for (size_t i = 0; i < argc; ++i) {
+        if (i) line += ' ';
+        append_display(line, args[i]);
+    }
+    line += '\n';
+    std::fwrite(line.data(), 1, line.size(), ctx.out);
+    result.clear();
+    return true;
+}
+
+bool builtin_push(BuiltinContext& ctx, Value* args, size_t, Value& result) {
+    if (args[0].type() != ValueType::List) return wrong_type(ctx, "push", args[0]);
+    as_list(args[0]).items.push_back(args[1]);
+    result.clear();
+    return true;
+}
+
+bool builtin_pop(BuiltinContext& ctx, Value* args, size_t, Value& result) {
+    if (args[0].type() != ValueType::List) return wrong_type(ctx, "pop", args[0]);
+    auto& items = as_list(args[0]).items;
+    if (items.empty()) {
+        ctx.error = "pop() from an empty list";
+        return false;
+    }
+    result = std::move(items.back());
+    items.pop_back();
+    return true;
+}
+
+// 字符串（字节数）、list、tuple、dict 的长度；不是这些类型时返回 -1
+int64_t length_of(const Value& v) {
+    switch (v.type()) {
+        case ValueType::Str:   return int64_t(as_str(v).text.size());
+        case ValueType::List:
+        case ValueType::Tuple: return int64_t(as_list(v).items.size());
+        case ValueType::Dict:  return int64_t(as_dict(v).entries.size());
+        default:               return -1;
+    }
+}
+
+bool builtin_len(BuiltinContext& ctx, Value* args, size_t, Value& result) {
+    const int64_t n = length_of(args[0]);
+    if (n < 0) return wrong_type(ctx, "len", args[0]);
+    result = Value::integer(n);
+    return true;
+}
+
+bool builtin_is_empty(BuiltinContext& ctx, Value* args, size_t, Value& result) {
+    const int64_t n = length_of(args[0]);
+    if (n < 0) return wrong_type(ctx, "is_empty", args[0]);
+    result = Value::boolean(n == 0);
+    return true;
+}
+
+bool dict_items(BuiltinContext& ctx, const char* name, const Value& dict, bool keys, Value& result) {
+    if (dict.type() != ValueType::Dict) return wrong_type(ctx, name, dict);
+    auto* list = new ListObject(ValueType::List);
+    for (const auto& [key, value] : as_dict(dict).entries) list->items.push_back(keys ? key : value);
+    result = Value::adopt(list);
+    return true;
+}
+
+bool builtin_keys(BuiltinContext& ctx, Value* args, size_t, Value& result) {
+    return dict_items(ctx, "keys", args[0], true, result);
+}
+
+bool builtin_values(BuiltinContext& ctx, Value* args, size_t, Value& result) {
+    return dict_items(ctx, "values", args[0], false, result);
+}
+
+constexpr Builtin kBuiltins[] = {
+    {"print",    0, SIZE_MAX, builtin_print},
+    {"push",     2, 2,        builtin_push},
+    {"pop",      1, 1,        builtin_pop},
+    {"len",      1, 1,        builtin_len},
+    {"is_empty", 1, 1,        builtin_is_empty},
+    {"keys",     1, 1,        builtin_keys},
+    {"values",   1, 1,        builtin_values},
+};
+
+int16_t find_builtin(std::string_view name) {
+    for (size_t i = 0; i < std::size(kBuiltins); ++i) {
+        if (name == kBuiltins[i].name) return int16_t(i);
+    }
+    return -1;
+}
+
+bool call_builtin(BuiltinContext& ctx, uint32_t id, Value* args, size_t argc, Value& result) {
+    const Builtin& b = kBuiltins[id];
+    if (argc < b.min_args || argc > b.max_args) {
+        ctx.error = fmt::format("{}() takes {} argument{}, got {}", b.name, b.min_args,
+                                b.min_args == 1 ? "" : "s", argc);
+        return false;
+    }
+    return b.fn(ctx, args, argc, result);
+}
+
+// ============================================================================
+// 运算的慢路径（快路径在分派循环中内联：两个 int）
+// ============================================================================
+
+const char* op_symbol(Op op) {
+    switch (op) {
+        case Op::Add: return "+";
+        case Op::Sub: return "-";
+        case Op::Mul: return "*";
+        case Op::Div: return "/";
+        case Op::Mod: return "%";
+        case Op::Lt:  return "<";
+        case Op::Le:  return "<=";
+        case Op::Neg: return "-";
+        case Op::Pos: return "+";
+        default:      return "?";
+    }
+}
+
+std::string operand_error(Op op, const Value& a, const Value& b) {
+    return fmt::format("unsupported operand types for '{}': {} and {}", op_symbol(op),
+                       value_type_name(a.type()), value_type_name(b.type()));
+}
+
+bool arith(Op op, Value& dest, const Value& a, const Value& b, std::string& error) {
+    // str + x / x + str：拼接文本形式
+    if (op == Op::Add && (a.type() == ValueType::Str || b.type() == ValueType::Str)) {
+        std::string text;
+        append_display(text, a);
+        append_display(text, b);
+        dest = make_str(std::move(text));
+        return true;
+    }
+    if (op == Op::Add && a.type() == ValueType::List && b.type() == ValueType::List) {
+        auto* list = new ListObject(ValueType::List);
+        list->items = as_list(a).items;
+        list->items.insert(list->items.end(), as_list(b).items.begin(), as_list(b).items.end());
+        dest = Value::adopt(list);
+        return true;
+    }
+    if (!a.is_number() || !b.is_number()) {
+        error = operand_error(op, a, b);
+        return false;
+    }
+
+    if (a.is_int() && b.is_int()) {
+        const int64_t x = a.as_int();
+        const int64_t y = b.as_int();
+        int64_t r = 0;
+        bool overflow = false;
+        switch (op) {
+            case Op::Add: overflow = add_overflow(x, y, r); break;
+            case Op::Sub: overflow = sub_overflow(x, y, r); break;
+            case Op::Mul: overflow = mul_overflow(x, y, r); break;
+            case Op::Div:
+            case Op::Mod:
+                if (y == 0) {
+                    error = op == Op::Div ? "division by zero" : "modulo by zero";
+                    return false;
+                }
+                if (x == INT64_MIN && y == -1) {
+                    overflow = op == Op::Div;
+                    r = 0;
+                } else {
+                    r = op == Op::Div ? x / y : x % y;
+                }
+                break;
+            default: break;
+        }
+        if (overflow) {
+            error = fmt::format("integer overflow in '{}'", op_symbol(op));
+            return false;
+        }
+        dest = Value::integer(r);
+        return true;
+    }
+
+    const double x = a.number();
+    const double y = b.number();
+    switch (op) {
+        case Op::Add: dest = Value::real(x + y); break;
+        case Op::Sub: dest = Value::real(x - y); break;
+        case Op::Mul: dest = Value::real(x * y); break;
+        case Op::Div: dest = Value::real(x / y); break;
+        case Op::Mod: dest = Value::real(std::fmod(x, y)); break;
+        default: break;
+    }
+    return true;
+}
+
+// < / <=：数字按数值，字符串按字节序
+bool compare(Op op, Value& dest, const Value& a, const Value& b, std::string& error) {
+    if (a.is_number() && b.is_number()) {
+        bool r;
+        if (a.is_int() && b.is_int()) r = op == Op::Lt ? a.as_int() < b.as_int() : a.as_int() <= b.as_int();
+        else                           r = op == Op::Lt ? a.number() < b.number() : a.number() <= b.number();
+        dest = Value::boolean(r);
+        return true;
+    }
+    if (a.type() == ValueType::Str && b.type() == ValueType::Str) {
+        const int c = as_str(a).text.compare(as_str(b).text);
+        dest = Value::boolean(op == Op::Lt ? c < 0 : c <= 0);
+        return true;
+    }
+    error = operand_error(op, a, b);
+    return false;
+}
+
+// list / tuple / str 的下标检查
+bool sequence_index(const Value& index, size_t size, size_t& out, std::string& error) {
+    if (!index.is_int()) {
+        error = fmt::format("index must be an int, not {}", value_type_name(index.type()));
+        return false;
+    }
+    const int64_t i = index.as_int();
+    if (i < 0 || uint64_t(i) >= size) {
+        error = fmt::format("index {} out of range (size {})", i, size);
+        return false;
+    }
+    out = size_t(i);
+    return true;
+}
+
+bool get_index(Value& dest, const Value& target, const Value& index, std::string& error) {
+    size_t i = 0;
+    switch (target.type()) {
+        case ValueType::List:
+        case ValueType::Tuple: {
+            const auto& items = as_list(target).items;
+            if (!sequence_index(index, items.size(), i, error)) return false;
+            dest = items[i];
+            return true;
+        }
+        case ValueType::Str: {
+            const std::string& text = as_str(target).text;
+            if (!sequence_index(index, text.size(), i, error)) return false;
+            dest = make_str(std::string(1, text[i]));
+            return true;
+        }
+        case ValueType::Dict:
+            if (const Value* v = as_dict(target).find(index)) {
+                dest = *v;
+                return true;
+            }
+            error = fmt::format("key {} not found", display(index, true));
+            return false;
+        default:
+            error = fmt::format("{} is not indexable", value_type_name(target.type()));
+            return false;
+    }
+}
+
+// 切片的一个下标：null 表示省略（取 fallback），否则同下标一样不能为负，但可以等于长度
+bool slice_bound(const Value& bound, size_t size, size_t fallback, size_t& out, std::string& error) {
+    if (bound.type() == ValueType::Null) {
+        out = fallback;
+        return true;
+    }
+    if (!bound.is_int()) {
+        error = fmt::format("slice index must be an int, not {}", value_type_name(bound.type()));
+        return false;
+    }
+    const int64_t i = bound.as_int();
+    if (i < 0 || uint64_t(i) > size) {
+        error = fmt::format("slice index {} out of range (size {})", i, size);
+        return false;
+    }
+    out = size_t(i);
+    return true;
+}
+
+// target[from:to]：list / tuple / str 的拷贝，from > to 时为空
+bool get_slice(Value& dest, const Value& target, const Value& from, const Value& to, std::string& error) {
+    const ValueType type = target.type();
+    if (type != ValueType::List && type != ValueType::Tuple && type != ValueType::Str) {
+        error = fmt::format("{} cannot be sliced", value_type_name(type));
+        return false;
+    }
+    const size_t size = type == ValueType::Str ? as_str(target).text.size() : as_list(target).items.size();
+    size_t begin = 0, end = 0;
+    if (!slice_bound(from, size, 0, begin, error) || !slice_bound(to, size, size, end, error)) return false;
+    end = std::max(begin, end);
+
+    if (type == ValueType::Str) {
+        dest = make_str(as_str(target).text.substr(begin, end - begin));
+        return true;
+    }
+    const auto& items = as_list(target).items;
+    auto* slice = new ListObject(type);
+    slice->items.assign(items.begin() + ptrdiff_t(begin), items.begin() + ptrdiff_t(end));
+    dest = Value::adopt(slice);
+    return true;
+}
+
+bool set_index(const Value& target, const Value& index, const Value& value, std::string& error) {
+    switch (target.type()) {
+        case ValueType::List: {
+            auto& items = as_list(target).items;
+            size_t i = 0;
+            if (!sequence_index(index, items.size(), i, error)) return false;
+            items[i] = value;
+            return true;
+        }
+        case ValueType::Dict:
+            as_dict(target).set(index, value);
+            return true;
+        default:
+            error = fmt::format("{} does not support item assignment", value_type_name(target.type()));
+            return false;
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// VM
+// ============================================================================
+
+VM::VM() : registers_(std::make_unique<Value[]>(kMaxRegisters)) {
+    frames_.reserve(kMaxFrames);
+}
+
+VM::~VM() = default;
+
+const char* VM::dispatch_mode() noexcept {
+    return PRIM_VM_THREADED ? "threaded" : "switch";
+}
+
+void VM::load(const Module& module) {
+    module_ = &module;
+    error_ = {};
+    frames_.clear();
+
+    prims_.resize(module.prims.size());
+    for (size_t p = 0; p < module.prims.size(); ++p) {
+        const PrimCode& code = module.prims[p];
+        PrimInfo& info = prims_[p];
+        info.code = &code;
+        info.constants.clear();
+        info.methods.assign(code.constants.size(), -1);
+        for (size_t i = 0; i < code.constants.size(); ++i) {
+            const Constant& k = code.constants[i];
+            switch (k.kind) {
+                case Constant::Kind::Int:   info.constants.push_back(Value::integer(k.i)); break;
+                case Constant::Kind::Float: info.constants.push_back(Value::real(k.f)); break;
+                case Constant::Kind::String:
+                    info.constants.push_back(make_str(k.s));
+                    info.methods[i] = find_builtin(k.s);
+                    break;
+            }
+        }
+    }
+
+    globals_.assign(module.globals.size(), Value::undefined());
+    for (size_t g = 0; g < module.globals.size(); ++g) {
+        const int16_t id = find_builtin(module.globals[g]);
+        if (id >= 0) globals_[g] = Value::builtin(uint32_t(id));
+    }
+}
+
+// 释放本次执行持有的所有值（正常返回时寄存器已经清空，出错时清空到出错帧的末尾）
+void VM::unload() {
+    for (size_t i = 0; i < live_; ++i) registers_[i].clear();
+    live_ = 0;
+    frames_.clear();
+    globals_.clear();
+    prims_.clear();
+    module_ = nullptr;
+}
+
+void VM::fail(const PrimInfo* prim, const Instr* ip, const Value* R, std::string message) {
+    const auto at = [](const PrimInfo* p, const Instr* next) {
+        return p->code->offsets[size_t(next - p->code->code.data()) - 1];
+    };
+    error_.offset = at(prim, ip);
+    error_.message = std::move(message);
+    error_.trace.clear();
+    live_ = std::min(size_t(R - registers_.get()) + prim->code->registers, kMaxRegisters);
+    for (size_t i = frames_.size(); i-- > 0;) error_.trace.push_back(at(frames_[i].prim, frames_[i].ip));
+}
+
+std::optional<Value> VM::run(const Module& module) {
+    if (module.prims.empty()) return Value();
+    load(module);
+    Value result;
+    uint64_t executed = 0;
+    const bool ok = execute<false>(result, executed);
+    unload();
+    if (!ok) return std::nullopt;
+    return result;
+}
+
+std::optional<Value> VM::run_counted(const Module& module, uint64_t& executed) {
+    if (module.prims.empty()) return Value();
+    load(module);
+    Value result;
+    executed = 0;
+    const bool ok = execute<true>(result, executed);
+    unload();
+    if (!ok) return std::nullopt;
+    return result;
+}
+
+// ============================================================================
+// 分派循环
+// ============================================================================
+//
+// VM_CASE 定义一条指令的处理代码，VM_NEXT 取下一条指令并跳转：
+// threaded 模式下是 goto *kLabels[op]（每个处理代码末尾各有一个间接跳转，分支预测按指令对区分），
+// switch 模式下回到 dispatch 处的 switch。两种模式共用同一份处理代码。
+//
+// in 指向当前指令，操作数在处理代码中按需读取：VM_NEXT 只有取操作码、跳转两步，
+// 短到编译器愿意复制进每个处理代码。GCC 的 crossjumping 仍会把相同的结尾合并成少数几个公共跳转，
+// 所以 CMakeLists.txt 为本文件关闭了它（-fno-crossjumping）。
+
+template <bool kCount>
+bool VM::execute(Value& result, uint64_t& executed) {
+    const PrimInfo* prim = &prims_[0];
+    const Instr*    ip   = prim->code->code.data();
+    const Value*    K    = prim->constants.data();
+    Value*          R    = registers_.get();
+    Value* const    register_end = registers_.get() + kMaxRegisters;
+    BuiltinContext  ctx{out_, {}};
+    std::string     error;
+    const Instr*    in = nullptr;
+
+    // 调用：callee 的参数位于 R[dest+1] ~ R[dest+argc]
+    uint32_t call_prim = 0;
+    uint16_t call_dest = 0;
+    uint16_t call_argc = 0;
+
+    if (prim->code->registers > kMaxRegisters) {
+        fail(prim, ip + 1, R, "stack overflow");
+        return false;
+    }
+
+#if PRIM_VM_THREADED
+    // 顺序必须与 Op 一致
+    static const void* const kLabels[] = {
+        &&op_Move, &&op_LoadK, &&op_LoadInt, &&op_LoadNull, &&op_LoadTrue, &&op_LoadFalse, &&op_LoadUnit,
+        &&op_MakePrim, &&op_GetGlobal, &&op_SetGlobal, &&op_DelGlobal,
+        &&op_Add, &&op_Sub, &&op_Mul, &&op_Div, &&op_Mod, &&op_Eq, &&op_Ne, &&op_Lt, &&op_Le,
+        &&op_Not, &&op_Neg, &&op_Pos, &&op_Jump, &&op_JumpIf, &&op_JumpIfNot,
+        &&op_NewList, &&op_NewTuple, &&op_NewDict, &&op_Index, &&op_SetIndex, &&op_Slice, &&op_GetField, &&op_SetField,
+        &&op_Call, &&op_Invoke, &&op_Return,
+    };
+    static_assert(std::size(kLabels) == kOpCount, "kLabels 与 Op 不一致");
+    #define VM_CASE(name) op_##name:
+    #define VM_DISPATCH() goto *kLabels[size_t(in->op)]
+#else
+    #define VM_CASE(name) case Op::name:
+    #define VM_DISPATCH() goto dispatch
+#endif
+#define VM_NEXT()                         \
+    do {                                  \
+        if constexpr (kCount) ++executed; \
+        in = ip++;                        \
+        VM_DISPATCH();                    \
+    } while (0)
+#define VM_ERROR(...)                                   \
+    do {                                                \
+        fail(prim, ip, R, fmt::format(__VA_ARGS__));       \
+        return false;                                   \
+    } while (0)
+#define VM_CHECK(expr)                                  \
+    do {                                                \
+        if (unlikely_(!(expr))) {                       \
+            fail(prim, ip, R, std::move(error));           \
+            return false;                               \
+        }                                               \
+    } while (0)
+
+    VM_NEXT();
+
+#if !PRIM_VM_THREADED
+dispatch:
+    switch (in->op) {
+#endif
+
+    // ===== 载入 =====
+    VM_CASE(Move) {
+        R[in->a] = R[in->b];
+        VM_NEXT();
+    }
+    VM_CASE(LoadK) {
+        R[in->a] = K[in->b];
+        VM_NEXT();
+    }
+    VM_CASE(LoadInt) {
+        R[in->a] = Value::small_int(in->sbc());
+        VM_NEXT();
+    }
+    VM_CASE(LoadNull) {
+        R[in->a] = Value::null();
+        VM_NEXT();
+    }
+    VM_CASE(LoadTrue) {
+        R[in->a] = Value::boolean(true);
+        VM_NEXT();
+    }
+    VM_CASE(LoadFalse) {
+        R[in->a] = Value::boolean(false);
+        VM_NEXT();
+    }
+    VM_CASE(LoadUnit) {
+        R[in->a].clear();
+        VM_NEXT();
+    }
+    VM_CASE(MakePrim) {
+        R[in->a] = Value::prim(in->b);
+        VM_NEXT();
+    }
+
+    // ===== 全局变量 =====
+    VM_CASE(GetGlobal) {
+        const Value& g = globals_[in->b];
+        if (unlikely_(g.is_undefined())) VM_ERROR("undefined variable '{}'", module_->globals[in->b]);
+        R[in->a] = g;
+        VM_NEXT();
+    }
+    VM_CASE(SetGlobal) {
+        globals_[in->b] = R[in->a];
+        VM_NEXT();
+    }
+    VM_CASE(DelGlobal) {
+        globals_[in->b] = Value::undefined();
+        VM_NEXT();
+    }
+
+    // ===== 运算 =====
+    VM_CASE(Add) {
+        const Value& a = R[in->b];
+        const Value& b = R[in->c];
+        if (!likely_(Value::both_small_ints(a, b) && Value::small_add(a, b, R[in->a]))) {
+            VM_CHECK(arith(Op::Add, R[in->a], a, b, error));
+        }
+        VM_NEXT();
+    }
+    VM_CASE(Sub) {
+        const Value& a = R[in->b];
+        const Value& b = R[in->c];
+        if (!likely_(Value::both_small_ints(a, b) && Value::small_sub(a, b, R[in->a]))) {
+            VM_CHECK(arith(Op::Sub, R[in->a], a, b, error));
+        }
+        VM_NEXT();
+    }
+    VM_CASE(Mul) {
+        const Value& a = R[in->b];
+        const Value& b = R[in->c];
+        if (!likely_(Value::both_small_ints(a, b) && Value::small_mul(a, b, R[in->a]))) {
+            VM_CHECK(arith(Op::Mul, R[in->a], a, b, error));
+        }
+        VM_NEXT();
+    }
+    VM_CASE(Div) {
+        VM_CHECK(arith(Op::Div, R[in->a], R[in->b], R[in->c], error));
+        VM_NEXT();
+    }
+    VM_CASE(Mod) {
+        const Value& a = R[in->b];
+        const Value& b = R[in->c];
+        if (likely_(Value::both_small_ints(a, b) && b.as_small_int() > 0)) {
+            R[in->a] = Value::small_int(a.as_small_int() % b.as_small_int());
+        } else {
+            VM_CHECK(arith(Op::Mod, R[in->a], a, b, error));
+        }
+        VM_NEXT();
+    }
+    VM_CASE(Eq) {
+        const Value& a = R[in->b];
+        const Value& b = R[in->c];
+        const bool eq = Value::both_small_ints(a, b) ? a.as_small_int() == b.as_small_int() : values_equal(a, b);
+        R[in->a] = Value::boolean(eq);
+        VM_NEXT();
+    }
+    VM_CASE(Ne) {
+        const Value& a = R[in->b];
+        const Value& b = R[in->c];
+        const bool eq = Value::both_small_ints(a, b) ? a.as_small_int() == b.as_small_int() : values_equal(a, b);
+        R[in->a] = Value::boolean(!eq);
+        VM_NEXT();
+    }
+    VM_CASE(Lt) {
+        const Value& a = R[in->b];
+        const Value& b = R[in->c];
+        if (likely_(Value::both_small_ints(a, b))) R[in->a] = Value::boolean(a.as_small_int() < b.as_small_int());
+        else VM_CHECK(compare(Op::Lt, R[in->a], a, b, error));
+        VM_NEXT();
+    }
+    VM_CASE(Le) {
+        const Value& a = R[in->b];
+        const Value& b = R[in->c];
+        if (likely_(Value::both_small_ints(a, b))) R[in->a] = Value::boolean(a.as_small_int() <= b.as_small_int());
+        else VM_CHECK(compare(Op::Le, R[in->a], a, b, error));
+        VM_NEXT();
+    }
+    VM_CASE(Not) {
+        R[in->a] = Value::boolean(!R[in->b].truthy());
+        VM_NEXT();
+    }
+    VM_CASE(Neg) {
+        const Value& v = R[in->b];
+        if (v.is_small_int())                           R[in->a] = Value::integer(-v.as_small_int());
+        else if (v.is_float())                          R[in->a] = Value::real(-v.as_float());
+        else if (v.is_int() && v.as_int() != INT64_MIN) R[in->a] = Value::integer(-v.as_int());
+        else if (v.is_int())                            VM_ERROR("integer overflow in '-'");
+        else VM_ERROR("unsupported operand type for unary '-': {}", value_type_name(v.type()));
+        VM_NEXT();
+    }
+    VM_CASE(Pos) {
+        const Value& v = R[in->b];
+        if (!v.is_number()) VM_ERROR("unsupported operand type for unary '+': {}", value_type_name(v.type()));
+        R[in->a] = v;
+        VM_NEXT();
+    }
+
+    // ===== 跳转 =====
+    VM_CASE(Jump) {
+        ip += in->sbc();
+        VM_NEXT();
+    }
+    VM_CASE(JumpIf) {
+        if (R[in->a].truthy()) ip += in->sbc();
+        VM_NEXT();
+    }
+    VM_CASE(JumpIfNot) {
+        if (!R[in->a].truthy()) ip += in->sbc();
+        VM_NEXT();
+    }
+
+    // ===== 容器 =====
+    VM_CASE(NewList) {
+        auto* list = new ListObject(ValueType::List);
+        list->items.assign(R + in->b, R + in->b + in->c);
+        R[in->a] = Value::adopt(list);
+        VM_NEXT();
+    }
+    VM_CASE(NewTuple) {
+        auto* tuple = new ListObject(ValueType::Tuple);
+        tuple->items.assign(R + in->b, R + in->b + in->c);
+        R[in->a] = Value::adopt(tuple);
+        VM_NEXT();
+    }
+    VM_CASE(NewDict) {
+        auto* dict = new DictObject();
+        for (uint16_t i = 0; i < in->c; ++i) dict->set(R[in->b + 2 * i], R[in->b + 2 * i + 1]);
+        R[in->a] = Value::adopt(dict);
+        VM_NEXT();
+    }
+    VM_CASE(Index) {
+        VM_CHECK(get_index(R[in->a], R[in->b], R[in->c], error));
+        VM_NEXT();
+    }
+    VM_CASE(SetIndex) {
+        VM_CHECK(set_index(R[in->a], R[in->b], R[in->c], error));
+        VM_NEXT();
+    }
+    VM_CASE(Slice) {
+        VM_CHECK(get_slice(R[in->a], R[in->b], R[in->c], R[in->c + 1], error));
+        VM_NEXT();
+    }
+    VM_CASE(GetField) {
+        const Value& target = R[in->b];
+        if (target.type() != ValueType::Dict) {
+            VM_ERROR("{} has no field '{}'", value_type_name(target.type()), as_str(K[in->c]).text);
+        }
+        const Value* field = as_dict(target).find(K[in->c]);
+        if (!field) VM_ERROR("no field '{}'", as_str(K[in->c]).text);
+        R[in->a] = *field;
+        VM_NEXT();
+    }
+    VM_CASE(SetField) {
+        const Value& target = R[in->a];
+        if (target.type() != ValueType::Dict) {
+            VM_ERROR("cannot set field '{}' on {}", as_str(K[in->b]).text, value_type_name(target.type()));
+        }
+        as_dict(target).set(K[in->b], R[in->c]);
+        VM_NEXT();
+    }
+
+    // ===== 调用 =====
+    VM_CASE(Call) {
+        const Value& callee = R[in->a];
+        if (likely_(callee.type() == ValueType::Prim)) {
+            call_prim = callee.index();
+            call_dest = in->a;
+            call_argc = in->b;
+            goto enter_prim;
+        }
+        if (callee.type() == ValueType::Builtin) {
+            Value out;
+            if (!call_builtin(ctx, callee.index(), R + in->a + 1, in->b, out)) {
+                fail(prim, ip, R, std::move(ctx.error));
+                return false;
+            }
+            R[in->a] = std::move(out);
+            VM_NEXT();
+        }
+        VM_ERROR("{} is not callable", value_type_name(callee.type()));
+    }
+    VM_CASE(Invoke) {
+        const Value& receiver = R[in->a];
+        // dict 中的 prim 字段（闭包空间的方法）
+        if (receiver.type() == ValueType::Dict) {
+            if (const Value* field = as_dict(receiver).find(K[in->c])) {
+                if (field->type() == ValueType::Prim) {
+                    call_prim = field->index();
+                    call_dest = in->a;
+                    call_argc = in->b;
+                    goto enter_prim;
+                }
+                if (field->type() != ValueType::Builtin) {
+                    VM_ERROR("field '{}' is not callable", as_str(K[in->c]).text);
+                }
+                Value out;
+                if (!call_builtin(ctx, field->index(), R + in->a + 1, in->b, out)) {
+                    fail(prim, ip, R, std::move(ctx.error));
+                    return false;
+                }
+                R[in->a] = std::move(out);
+                VM_NEXT();
+            }
+        }
+        // 内置方法：接收者作为第一个参数
+        const int16_t method = prim->methods[in->c];
+        if (method < 0) VM_ERROR("{} has no method '{}'", value_type_name(receiver.type()), as_str(K[in->c]).text);
+        Value out;
+        if (!call_builtin(ctx, uint32_t(method), R + in->a, size_t(in->b) + 1, out)) {
+            fail(prim, ip, R, std::move(ctx.error));
+            return false;
+        }
+        R[in->a] = std::move(out);
+        VM_NEXT();
+    }
+    VM_CASE(Return) {
+        Value value = std::move(R[in->a]);
+        for (uint16_t i = 0, n = prim->code->registers; i < n; ++i) R[i].clear();
+        if (frames_.empty()) {
+            result = std::move(value);
+            return true;
+        }
+        const Frame frame = frames_.back();
+        frames_.pop_back();
+        prim = frame.prim;
+        ip = frame.ip;
+        K = prim->constants.data();
+        R = frame.base;
+        R[frame.dest] = std::move(value);
+        VM_NEXT();
+    }
+
+#if !PRIM_VM_THREADED
+    }
+#endif
+
+    // 进入命名 prim：新帧从 R[call_dest+1] 开始，参数已经就位
+enter_prim: {
+        const PrimInfo& target = prims_[call_prim];
+        if (unlikely_(call_argc != target.code->params)) {
+            VM_ERROR("{}() takes {} argument{}, got {}", target.code->name, target.code->params,
+                     target.code->params == 1 ? "" : "s", call_argc);
+        }
+        Value* base = R + call_dest + 1;
+        if (unlikely_(frames_.size() == kMaxFrames || target.code->registers > register_end - base)) {
+            VM_ERROR("stack overflow");
+        }
+        frames_.push_back({prim, ip, R, call_dest});
+        prim = &target;
+        ip = target.code->code.data();
+        K = target.constants.data();
+        R = base;
+        VM_NEXT();
+    }
+
+#undef VM_CASE
+#undef VM_DISPATCH
+#undef VM_NEXT
+#undef VM_ERROR
+#undef VM_CHECK
+}
+
+} // namespace prim
@@ -0,0 +1,240 @@
+// ast_file_test.cpp - 二进制 AST 文件的往返与校验检查（由 ctest 运行，见 CMakeLists.txt）
+//
+// 用法: ast_file_test [--dir DIR] file.prim ...
+//   每个文件解析后用 write_ast_file() 写入 DIR/<文件名>.past（与 --emit-ast 相同的写入路径，默认为临时目录），
+//   再用 AstFile::open() 映射载入，逐个节点比较：
+//   - 节点数、边数、根节点；每个节点的类型、标志位、token 下标、子节点列表
+//   - 节点引用的 token：偏移、长度、类型、错误、文本（取自字符串表）、数字字面量的值
+//   然后把文件改坏（截断、多出字节、魔数 / 版本 / 字节序不符、节点类型越界、token 下标越界、
+//   子节点不先于父节点、根节点越界、文本越出字符串表）写入 DIR/<文件名>.bad.past，AstFile::open() 必须拒绝
+// 有差异时打印第一处差异，返回 1
+
+#include "ast_file.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "source.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+
+using namespace prim;
+
+namespace {
+
+// ============================================================================
+// 往返比较
+// ============================================================================
+
+bool same_node(const std::string& name, const Ast& ast, const AstView& view, NodeId id) {
+    const ASTNode& e = ast[id];
+    const ASTNode& a = view[id];
+    if (e.type != a.type || e.flags != a.flags || e.token != a.token) {
+        fmt::print(stderr, "{}: node {} differs: type {}/{}, flags {:#x}/{:#x}, token {}/{}\n", name, id,
+                   int(e.type), int(a.type), e.flags, a.flags, e.token, a.token);
+        return false;
+    }
+    const auto expected_children = ast.children(id);
+    const auto actual_children = view.children(id);
+    if (!std::equal(expected_children.begin(), expected_children.end(),
+                    actual_children.begin(), actual_children.end())) {
+        fmt::print(stderr, "{}: children of node {} differ ({} / {} children)\n",
+                   name, id, expected_children.size(), actual_children.size());
+        return false;
+    }
+
+    const Token* tok = ast.token(id);
+    const AstFileToken* loaded = view.token(id);
+    if (!tok || !loaded) {
+        if (tok || loaded) {
+            fmt::print(stderr, "{}: node {} token {} in the file\n", name, id, loaded ? "unexpected" : "missing");
+            return false;
+        }
+        return true;
+    }
+    // 符号编号不写入文件（见 serialize_ast），只有数字字面量比较值
+    const uint64_t value = tok->is_number() ? tok->value.u : 0;
+    if (tok->begin != loaded->begin || tok->length != loaded->length || tok->type != loaded->type ||
+        tok->err != loaded->err || std::bit_cast<uint32_t>(tok->emsg) != loaded->emsg ||
+        tok->text() != view.text(*loaded) || value != loaded->value().u) {
+        fmt::print(stderr, "{}: token of node {} differs\n  expected: {} @{} '{}' value={:#x}\n"
+                   "  actual:   {} @{} '{}' value={:#x}\n", name, id,
+                   token_type_name(tok->type), tok->begin, tok->text(), value,
+                   token_type_name(loaded->type), loaded->begin, view.text(*loaded), loaded->value().u);
+        return false;
+    }
+    return true;
+}
+
+bool round_trip(const std::string& path, const Ast& ast, const std::string& out) {
+    if (!write_ast_file(out, ast)) {
+        fmt::print(stderr, "Error: cannot write {}\n", out);
+        return false;
+    }
+    auto file = AstFile::open(out);
+    if (!file) {
+        fmt::print(stderr, "{}: AstFile::open rejected {}\n", path, out);
+        return false;
+    }
+    const AstView& view = file->view();
+    if (view.size() != ast.size() || view.edge_count() != ast.edge_count() || view.root() != ast.root()) {
+        fmt::print(stderr, "{}: {} nodes, {} edges, root {} loaded; expected {}, {}, {}\n", path,
+                   view.size(), view.edge_count(), view.root(), ast.size(), ast.edge_count(), ast.root());
+        return false;
+    }
+    for (NodeId id = 0; id < ast.size(); ++id) {
+        if (!same_node(path, ast, view, id)) return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// 校验：改坏的文件必须被拒绝
+// ============================================================================
+
+template <typename T>
+void patch(std::string& bytes, size_t offset, T value) {
+    std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+T peek(const std::string& bytes, size_t offset) {
+    T value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    return value;
+}
+
+struct Corruption {
+    const char* name;
+    std::function<bool(std::string&)> apply;  // 文件不含所需的记录时返回 false（跳过）
+};
+
+std::vector<Corruption> corruptions() {
+    const size_t nodes = sizeof(AstFileHeader);
+    auto header = [](const std::string& b, size_t field) { return peek<uint32_t>(b, field); };
+    auto edges  = [=](const std::string& b) { return nodes + header(b, offsetof(AstFileHeader, node_count)) * sizeof(ASTNode); };
+    auto tokens = [=](const std::string& b) { return edges(b) + header(b, offsetof(AstFileHeader, edge_count)) * sizeof(NodeId); };
+
+    return {
+        {"truncated", [](std::string& b) { b.pop_back(); return true; }},
+        {"trailing byte", [](std::string& b) { b.push_back('\0'); return true; }},
+        {"magic", [](std::string& b) { b[0] = 'X'; return true; }},
+        {"version", [](std::string& b) {
+            patch(b, offsetof(AstFileHeader, version), AstView::kVersion + 1);
+            return true;
+        }},
+        {"byte order", [](std::string& b) {
+            patch(b, offsetof(AstFileHeader, byte_order), uint32_t(0x04030201));
+            return true;
+        }},
+        {"root", [=](std::string& b) {
+            patch(b, offsetof(AstFileHeader, root), header(b, offsetof(AstFileHeader, node_count)));
+            return true;
+        }},
+        {"node type", [=](std::string& b) {
+            if (header(b, offsetof(AstFileHeader, node_count)) == 0) return false;
+            patch(b, nodes + offsetof(ASTNode, type), uint8_t(uint8_t(ASTNode::NodeType::Program) + 1));
+            return true;
+        }},
+        {"token index", [=](std::string& b) {
+            if (header(b, offsetof(AstFileHeader, node_count)) == 0) return false;
+            patch(b, nodes + offsetof(ASTNode, token), header(b, offsetof(AstFileHeader, token_count)));
+            return true;
+        }},
+        {"child range", [=](std::string& b) {
+            if (header(b, offsetof(AstFileHeader, node_count)) == 0) return false;
+            patch(b, nodes + offsetof(ASTNode, child_count), header(b, offsetof(AstFileHeader, edge_count)) + 1);
+            return true;
+        }},
+        {"child cycle", [=](std::string& b) {
+            // 根节点的第一个子节点改为根节点自身
+            const uint32_t root = header(b, offsetof(AstFileHeader, root));
+            if (root == kNoNode) return false;
+            const size_t node = nodes + root * sizeof(ASTNode);
+            if (peek<uint32_t>(b, node + offsetof(ASTNode, child_count)) == 0) return false;
+            const uint32_t first = peek<uint32_t>(b, node + offsetof(ASTNode, first_child));
+            patch(b, edges(b) + first * sizeof(NodeId), root);
+            return true;
+        }},
+        {"token text", [=](std::string& b) {
+            if (header(b, offsetof(AstFileHeader, token_count)) == 0) return false;
+            patch(b, tokens(b) + offsetof(AstFileToken, text), header(b, offsetof(AstFileHeader, string_bytes)) + 1);
+            return true;
+        }},
+    };
+}
+
+bool rejects_corrupt(const std::string& path, const Ast& ast, const std::string& out) {
+    const std::string bytes = serialize_ast(ast);
+    bool ok = true;
+    for (const Corruption& c : corruptions()) {
+        std::string bad = bytes;
+        if (!c.apply(bad)) continue;
+        if (!write_file_atomic(out, bad)) {
+            fmt::print(stderr, "Error: cannot write {}\n", out);
+            return false;
+        }
+        if (AstFile::open(out)) {
+            fmt::print(stderr, "{}: AstFile::open accepted a corrupt file ({})\n", path, c.name);
+            ok = false;
+        }
+    }
+    std::filesystem::remove(out);
+    if (AstFile::open(out)) {
+        fmt::print(stderr, "{}: AstFile::open accepted a missing file\n", path);
+        ok = false;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--dir" && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (arg == "--help" || arg == "-h") {
+            fmt::print("Usage: {} [--dir DIR] file.prim ...\n", argv[0]);
+            return 0;
+        } else {
+            files.emplace_back(arg);
+        }
+    }
+
+    size_t failures = 0;
+    for (const auto& path : files) {
+        auto source = SourceBuffer::map_file(path);
+        if (!source) {
+            fmt::print(stderr, "Error: cannot open {}\n", path);
+            return 1;
+        }
+        // 有语法错误的文件同样往返：部分 AST 也是合法的树
+        Parser parser;
+        Lexer lexer(*source);
+        parser.parse(lexer);
+        const Ast& ast = parser.ast();
+
+        const std::string stem = std::filesystem::path(path).stem().string();
+        const std::string out = (dir / (stem + ".past")).string();
+        if (!round_trip(path, ast, out) || !rejects_corrupt(path, ast, (dir / (stem + ".bad.past")).string())) {
+            ++failures;
+            continue;
+        }
+        std::filesystem::remove(out);
+        fmt::print("{}: {} nodes round-tripped\n", path, ast.size());
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,322 @@
+// document_test.cpp - Document 增量重新分析的正确性检查（由 ctest 运行，见 CMakeLists.txt）
+//
+// 用法: document_test [--edits N] [--seed S] file.prim ...
+//   对每个文件先做一组预设编辑，再做 N 次（默认 300）随机编辑，每次编辑之后与从头分析比较：
+//   - doc.text() 与同样编辑过的参考文本相同
+//   - 各段 token 按 segment_start(i) 平移后拼接，与对整份文本的一次词法分析逐个相同
+//     （类型、错误、偏移、长度、词素；符号 token 比较符号内容，数字字面量比较值）
+//   - diagnostics() 的第一个错误（没有错误时为 statement_count()）与对整份文本的一次语法分析相同；
+//     全部错误和 statement_count() 与对同一文本新建的 Document 相同（各段的错误恢复不跨越段边界）
+//   预设编辑覆盖会让重新分析越过旧段边界的情形：删掉顶层的 ";"、打开未闭合的注释或括号、
+//   在段首插入 ";"（并入前一段）
+// 有差异时打印第一处差异和导致差异的编辑，返回 1
+
+#include "document.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "source.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+using namespace prim;
+
+namespace {
+
+// ============================================================================
+// 参考结果：对整份文本从头分析
+// ============================================================================
+
+struct Reference {
+    SourceBuffer            source;
+    Interner                symbols;
+    std::vector<Token>      tokens;  // 不含 END
+    std::vector<ParseError> errors;
+    size_t                  statements = 0;
+};
+
+void analyze(Reference& ref, const std::string& text) {
+    ref.source = SourceBuffer::from_string(text);
+    ref.tokens.clear();
+    Lexer lexer(ref.source);
+    lexer.set_interner(&ref.symbols);
+    for (Token tok = lexer.next(); tok.type != TokenType::END; tok = lexer.next()) {
+        ref.tokens.push_back(tok);
+    }
+
+    Parser parser;
+    parser.set_error_limit(SIZE_MAX);
+    parser.parse(std::span<const Token>(ref.tokens));
+    ref.errors = parser.get_errors();
+    const Ast& ast = parser.ast();
+    ref.statements = ast.ref(ast.root()).child(0).child_count();
+}
+
+// ============================================================================
+// 比较
+// ============================================================================
+
+std::string describe(const Token& tok, const Interner& symbols) {
+    std::string out = fmt::format("{} @{}+{} '{}'", token_type_name(tok.type), tok.begin, tok.length, tok.text());
+    if (tok.err != ErrType::None) out += fmt::format(" [{}]", err_type_name(tok.err));
+    if (tok.is_symbol()) out += fmt::format(" sym='{}'", symbols.view(tok.value.sym));
+    return out;
+}
+
+// begin 为文档偏移（段内 token 已平移）
+bool same_token(const Token& expected, const Interner& ref_symbols, const Token& actual, const Interner& doc_symbols) {
+    if (expected.type != actual.type || expected.err != actual.err || expected.begin != actual.begin ||
+        expected.length != actual.length || expected.text() != actual.text()) {
+        return false;
+    }
+    // 两边的符号表不同，符号编号不可比，比较符号内容
+    if (expected.is_symbol()) return ref_symbols.view(expected.value.sym) == doc_symbols.view(actual.value.sym);
+    return expected.value.u == actual.value.u;
+}
+
+bool check_tokens(const std::string& name, const Document& doc, const Reference& ref) {
+    size_t i = 0;
+    const auto& segments = doc.segments();
+    for (size_t s = 0; s < segments.size(); ++s) {
+        for (Token tok : segments[s]->tokens) {
+            tok.begin += doc.segment_start(s);
+            if (i >= ref.tokens.size()) {
+                fmt::print(stderr, "{}: extra token {} in segment {}: {}\n",
+                           name, i, s, describe(tok, doc.symbols()));
+                return false;
+            }
+            if (!same_token(ref.tokens[i], ref.symbols, tok, doc.symbols())) {
+                fmt::print(stderr, "{}: token {} (segment {}) differs\n  expected: {}\n  actual:   {}\n",
+                           name, i, s, describe(ref.tokens[i], ref.symbols), describe(tok, doc.symbols()));
+                return false;
+            }
+            ++i;
+        }
+    }
+    if (i != ref.tokens.size()) {
+        fmt::print(stderr, "{}: {} tokens expected, segments hold {}\n", name, ref.tokens.size(), i);
+        return false;
+    }
+    return true;
+}
+
+bool same_diagnostics(const std::string& name, const char* against, const std::vector<ParseError>& expected,
+                      const std::vector<ParseError>& actual, size_t limit) {
+    const size_t n = std::min({expected.size(), actual.size(), limit});
+    for (size_t i = 0; i < n; ++i) {
+        const ParseError& e = expected[i];
+        const ParseError& a = actual[i];
+        if (e.type != a.type || e.offset != a.offset || e.message != a.message) {
+            fmt::print(stderr, "{}: diagnostic {} differs from {}\n  expected: @{} {}\n  actual:   @{} {}\n",
+                       name, i, against, e.offset, e.message, a.offset, a.message);
+            return false;
+        }
+    }
+    if (std::min(expected.size(), limit) != std::min(actual.size(), limit)) {
+        fmt::print(stderr, "{}: {} diagnostics in {}, got {}\n", name, expected.size(), against, actual.size());
+        for (const ParseError& a : actual) fmt::print(stderr, "  @{} {}\n", a.offset, a.message);
+        return false;
+    }
+    return true;
+}
+
+// 各段分别做错误恢复（不跨越段边界），第一个错误之后的错误与整份文本的一次解析可以不同：
+// 与整份文本的解析比较有无错误、第一个错误和（没有错误时的）语句数，
+// 与对同一文本新建的 Document 比较全部错误和语句数
+bool check_parse(const std::string& name, const Document& doc, const Reference& ref, const std::string& text) {
+    const std::vector<ParseError> actual = doc.diagnostics();
+    if (!same_diagnostics(name, "full parse", ref.errors, actual, 1)) return false;
+    if (ref.errors.empty() && doc.statement_count() != ref.statements) {
+        fmt::print(stderr, "{}: {} statements in full parse, got {}\n", name, ref.statements, doc.statement_count());
+        return false;
+    }
+
+    Document fresh;
+    fresh.set_error_limit(SIZE_MAX);
+    fresh.assign(text);
+    if (!same_diagnostics(name, "fresh document", fresh.diagnostics(), actual, SIZE_MAX)) return false;
+    if (doc.statement_count() != fresh.statement_count()) {
+        fmt::print(stderr, "{}: {} statements in fresh document, got {}\n",
+                   name, fresh.statement_count(), doc.statement_count());
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// 编辑
+// ============================================================================
+
+struct Edit {
+    uint32_t    offset;
+    uint32_t    removed;
+    std::string inserted;
+};
+
+std::string describe(const Edit& e) {
+    std::string text;
+    for (char ch : e.inserted) text += ch == '\n' ? std::string("\\n") : std::string(1, ch);
+    return fmt::format("edit @{} -{} +'{}'", e.offset, e.removed, text);
+}
+
+class Session {
+public:
+    Session(std::string path, std::string_view text) : path_(std::move(path)), text_(text) {
+        // 错误数不设上限：每段各有一个上限，与整份文本的上限不可比
+        doc_.set_error_limit(SIZE_MAX);
+        doc_.assign(text_);
+    }
+
+    const std::string& text() const { return text_; }
+
+    // 应用一次编辑并与从头分析比较
+    bool apply(const Edit& e) {
+        ++count_;
+        if (!doc_.edit(e.offset, e.removed, e.inserted)) {
+            fmt::print(stderr, "{}: {} rejected (size {})\n", path_, describe(e), text_.size());
+            return false;
+        }
+        text_.replace(e.offset, e.removed, e.inserted);
+        return check(fmt::format("{} (edit {}: {})", path_, count_, describe(e)));
+    }
+
+    bool check_initial() { return check(path_ + " (initial)"); }
+
+    // 与从头分析比较
+    bool check(const std::string& name) {
+        if (doc_.text() != text_) {
+            fmt::print(stderr, "{}: text differs\n", name);
+            return false;
+        }
+        Reference ref;
+        analyze(ref, text_);
+        return check_tokens(name, doc_, ref) && check_parse(name, doc_, ref, text_);
+    }
+
+    // 顶层（括号深度为 0）的 ";" 的偏移
+    std::vector<uint32_t> top_level_semis() const {
+        Reference ref;
+        analyze(ref, text_);
+        std::vector<uint32_t> out;
+        uint32_t depth = 0;
+        for (const Token& tok : ref.tokens) {
+            switch (tok.type) {
+                case TokenType::LPAREN: case TokenType::LBRACK: case TokenType::LBRACE: ++depth; break;
+                case TokenType::RPAREN: case TokenType::RBRACK: case TokenType::RBRACE: if (depth > 0) --depth; break;
+                case TokenType::SEMI: if (depth == 0) out.push_back(tok.begin); break;
+                default: break;
+            }
+        }
+        return out;
+    }
+
+    size_t segments() const { return doc_.segments().size(); }
+    uint32_t segment_start(size_t i) const { return doc_.segment_start(i); }
+
+private:
+    std::string path_;
+    std::string text_;
+    Document    doc_;
+    size_t      count_ = 0;
+};
+
+// 插入后再删掉，两步都检查
+bool toggle(Session& s, uint32_t offset, std::string_view inserted) {
+    return s.apply({offset, 0, std::string(inserted)}) &&
+           s.apply({offset, uint32_t(inserted.size()), ""});
+}
+
+// 预设编辑：每一种都让新的切分偏离旧的段边界
+bool scripted(Session& s) {
+    if (!s.check_initial()) return false;
+
+    // 删掉顶层的 ";"，两段合并；再补回来
+    for (uint32_t at : s.top_level_semis()) {
+        if (!s.apply({at, 1, ""}) || !s.apply({at, 0, ";"})) return false;
+    }
+
+    // 在各段段首打开未闭合的注释 / 括号 / 字符串，后面的段都要重新分析；
+    // 插入 ";"：段首的 ";" 与前一段末尾的 ";" 连续，并入前一段
+    const size_t n = s.segments();
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t at = s.segment_start(i);
+        for (std::string_view text : {"/*", "(", "[", "{", "\"", "`", ";", "let inserted = 1;"}) {
+            if (!toggle(s, at, text)) return false;
+        }
+    }
+
+    // 关闭再打开：在文末打开注释之后于文首关闭
+    const uint32_t end = uint32_t(s.text().size());
+    return s.apply({end, 0, "/* tail"}) && s.apply({0, 0, "/* head */"}) && s.apply({0, 10, ""}) &&
+           s.apply({end, 7, ""});
+}
+
+// 随机编辑：插入 / 删除 / 替换结构性的片段，偏移均匀分布（可能落在 UTF-8 字符中间）
+bool random_edits(Session& s, size_t count, uint32_t seed) {
+    static constexpr std::array<std::string_view, 20> pieces = {
+        ";", ";", "/*", "*/", "//", "\n", "(", ")", "[", "]", "{", "}", "\"", "`", " ", "x",
+        "1.5", "let t = (1, 2);", "$f() { 1 };", "'\\n'",
+    };
+    std::mt19937 rng(seed);
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t size = uint32_t(s.text().size());
+        const uint32_t offset = std::uniform_int_distribution<uint32_t>(0, size)(rng);
+        const uint32_t removed = std::min(size - offset, std::uniform_int_distribution<uint32_t>(0, 3)(rng));
+        // 删除与插入大致持平，文本大小不漂移
+        std::string inserted;
+        if (rng() % 2) inserted = pieces[rng() % pieces.size()];
+        if (!s.apply({offset, removed, std::move(inserted)})) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t edits = 300;
+    uint32_t seed = 1;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--edits" && i + 1 < argc) {
+            edits = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--help" || arg == "-h") {
+            fmt::print("Usage: {} [--edits N] [--seed S] file.prim ...\n", argv[0]);
+            return 0;
+        } else {
+            files.emplace_back(arg);
+        }
+    }
+
+    size_t failures = 0;
+    for (const auto& path : files) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            fmt::print(stderr, "Error: cannot open {}\n", path);
+            return 1;
+        }
+        std::ostringstream text;
+        text << in.rdbuf();
+
+        Session session(path, text.str());
+        if (!scripted(session) || !random_edits(session, edits, seed)) {
+            ++failures;
+            continue;
+        }
+        fmt::print("{}: {} segments after edits\n", path, session.segments());
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+// lexer_test.cpp - 词法分析器一致性检查（由 ctest 运行，见 CMakeLists.txt）
+//
+// 用法: lexer_test [--stream BYTES] [--parallel JOBS] [--golden DIR] [--print] file.prim ...
+//   每个文件先用当前平台支持的每一组扫描内核（scalar / sse2 / avx2）在内存模式下分析，结果必须相同
+//   --stream  再用流模式分析（缓冲区 BYTES 字节），token 序列必须与内存模式 scan() 逐个相同。
+//             Reader 每次分别最多提供 1 字节、7 字节和填满缓冲区，YYFILL 落在 token 内部的各个位置，
+//             字符串内容跨越补充边界时经 spill_ 拼接
+//   --parallel 再用 lex_parallel 依次分 2 ~ JOBS 块分析（min_chunk 为 1 字节，小文件也切分），
+//             切分点落在注释、括号嵌套内部，token 序列必须与串行 next() 逐个相同
+//   --golden  与 DIR/<文件名>.tokens 逐行比较（格式见 render）
+//   --print   按 .tokens 的格式打印 token，不做比较
+// 有差异时打印第一处差异，返回 1
+//
+// tests/lexer/*.tokens 由 DFA 改为 rules/use 块与 SIMD 内核之前的词法分析器生成，
+// 只记录类型、错误和词素：那一版的 Location 在字符串之后偏移不准，不作为基准
+
+#include "lexer.hpp"
+#include "parallel_lexer.hpp"
+#include "source.hpp"
+
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+using namespace prim;
+
+namespace {
+
+// ============================================================================
+// token 快照
+// ============================================================================
+
+// 流模式下 Token::text 只在下一次 next() 之前有效，比较前拷贝下来
+struct Lexed {
+    TokenType   type;
+    ErrType     err;
+    uint32_t    begin;
+    uint64_t    value;
+    std::string text;
+
+    bool operator==(const Lexed&) const = default;
+};
+
+Lexed snapshot(const Token& tok) {
+    return {tok.type, tok.err, tok.begin, tok.value.u, std::string(tok.text())};
+}
+
+std::string describe(const Lexed& t) {
+    std::string out = fmt::format("{} @{} '{}'", token_type_name(t.type), t.begin, t.text);
+    if (t.err != ErrType::None) out += fmt::format(" [{}]", err_type_name(t.err));
+    if (t.value != 0) out += fmt::format(" value={:#x}", t.value);
+    return out;
+}
+
+// .tokens 的一行：类型 错误 '词素'；控制字符转义，其余字节（含 UTF-8）原样输出；END 不带词素（各版本的 END 长度不同）
+std::string render(const Lexed& t) {
+    std::string out = fmt::format("{} {} '", token_type_name(t.type), err_type_name(t.err));
+    if (t.type != TokenType::END) {
+        for (unsigned char ch : t.text) {
+            switch (ch) {
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                case '\\': out += "\\\\"; break;
+                case '\'': out += "\\'"; break;
+                default:
+                    if (ch < 0x20 || ch == 0x7F) out += fmt::format("\\x{:02x}", ch);
+                    else out += char(ch);
+            }
+        }
+    }
+    out += '\'';
+    return out;
+}
+
+// 分析到 END 为止；token 数超过 limit 视为没有停在输入末尾
+std::vector<Lexed> lex_all(Lexer& lexer, size_t limit) {
+    std::vector<Lexed> tokens;
+    for (;;) {
+        tokens.push_back(snapshot(lexer.next()));
+        if (tokens.back().type == TokenType::END || tokens.size() > limit) break;
+    }
+    return tokens;
+}
+
+// ============================================================================
+// 比较
+// ============================================================================
+
+// 流模式下未闭合注释的内容已被 fill() 丢弃，该错误 token 只比较类型和位置（见 lexer.re）
+bool same_token(const Lexed& expected, const Lexed& actual, bool stream) {
+    if (stream && expected.err == ErrType::UnterminatedComment) {
+        return expected.type == actual.type && expected.err == actual.err && expected.begin == actual.begin;
+    }
+    return expected == actual;
+}
+
+bool same_tokens(const std::string& name, const std::vector<Lexed>& expected, const std::vector<Lexed>& actual,
+                 bool stream) {
+    const size_t n = std::min(expected.size(), actual.size());
+    for (size_t i = 0; i < n; ++i) {
+        if (!same_token(expected[i], actual[i], stream)) {
+            fmt::print(stderr, "{}: token {} differs\n  expected: {}\n  actual:   {}\n",
+                       name, i, describe(expected[i]), describe(actual[i]));
+            return false;
+        }
+    }
+    if (expected.size() != actual.size()) {
+        fmt::print(stderr, "{}: {} tokens expected, got {}\n", name, expected.size(), actual.size());
+        return false;
+    }
+    return true;
+}
+
+// 流模式：缓冲区 buffer 字节，Reader 每次最多提供 chunk 字节（0 表示不限）
+bool check_stream(const std::string& path, const SourceBuffer& source,
+                  const std::vector<Lexed>& expected, size_t buffer, size_t chunk) {
+    const std::string_view text = source.view();
+    size_t read = 0;
+    Lexer lexer([&](char* dst, size_t cap) -> size_t {
+        size_t n = std::min(cap, text.size() - read);
+        if (chunk != 0) n = std::min(n, chunk);
+        std::memcpy(dst, text.data() + read, n);
+        read += n;
+        return n;
+    }, buffer);
+    const auto actual = lex_all(lexer, expected.size());
+    return same_tokens(fmt::format("{} (stream, buffer {}, chunk {})", path, buffer, chunk), expected, actual, true);
+}
+
+// 并行：切成 jobs 块（每块至少 1 字节），与串行结果比较
+bool check_parallel(const std::string& path, const SourceBuffer& source,
+                    const std::vector<Lexed>& expected, size_t jobs) {
+    ParallelLexStats stats;
+    const std::vector<Token> tokens = lex_parallel(source, jobs, 1, &stats);
+    std::vector<Lexed> actual;
+    actual.reserve(tokens.size());
+    for (const Token& tok : tokens) actual.push_back(snapshot(tok));
+    return same_tokens(fmt::format("{} (parallel, {} chunks, {} re-lexed)", path, stats.chunks, stats.relexed),
+                       expected, actual, false);
+}
+
+// 与 golden 文件逐行比较
+bool check_golden(const std::string& path, const std::string& golden, const std::vector<Lexed>& tokens) {
+    std::ifstream in(golden, std::ios::binary);
+    if (!in) {
+        fmt::print(stderr, "Error: cannot open {}\n", golden);
+        return false;
+    }
+    std::string line;
+    size_t i = 0;
+    for (; std::getline(in, line); ++i) {
+        if (i >= tokens.size()) {
+            fmt::print(stderr, "{}: {} has more tokens than the {} lexed\n", path, golden, tokens.size());
+            return false;
+        }
+        const std::string actual = render(tokens[i]);
+        if (actual != line) {
+            fmt::print(stderr, "{}: token {} differs from {}\n  expected: {}\n  actual:   {}\n",
+                       path, i, golden, line, actual);
+            return false;
+        }
+    }
+    if (i != tokens.size()) {
+        fmt::print(stderr, "{}: {} tokens in {}, {} lexed\n", path, i, golden, tokens.size());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t stream_buffer = 0;
+    size_t parallel_jobs = 0;
+    std::string golden_dir;
+    bool print = false;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--stream" && i + 1 < argc) {
+            stream_buffer = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--parallel" && i + 1 < argc) {
+            parallel_jobs = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--golden" && i + 1 < argc) {
+            golden_dir = argv[++i];
+        } else if (arg == "--print") {
+            print = true;
+        } else if (arg == "--help" || arg == "-h") {
+            fmt::print("Usage: {} [--stream BYTES] [--parallel JOBS] [--golden DIR] [--print] file.prim ...\n", argv[0]);
+            return 0;
+        } else {
+            files.emplace_back(arg);
+        }
+    }
+
+    std::vector<const simd::Kernels*> kernels;
+    for (const char* name : {"scalar", "sse2", "avx2"}) {
+        if (const simd::Kernels* k = simd::find_kernels(name)) kernels.push_back(k);
+    }
+
+    size_t failures = 0;
+    for (const auto& path : files) {
+        auto source = SourceBuffer::map_file(path);
+        if (!source) {
+            fmt::print(stderr, "Error: cannot open {}\n", path);
+            return 1;
+        }
+
+        // 内存模式：各组内核的结果相同，以标量内核的结果为准
+        std::vector<Lexed> expected;
+        bool consistent = true;
+        for (const simd::Kernels* k : kernels) {
+            simd::use_kernels(*k);
+            Lexer lexer(*source);
+            auto tokens = lex_all(lexer, source->size() + 1);
+            if (tokens.back().type != TokenType::END) {
+                fmt::print(stderr, "{} ({}): no END after {} tokens\n", path, k->name, tokens.size());
+                consistent = false;
+                break;
+            }
+            if (expected.empty()) {
+                expected = std::move(tokens);
+            } else if (!same_tokens(fmt::format("{} ({} kernels)", path, k->name), expected, tokens, false)) {
+                consistent = false;
+            }
+        }
+        if (!consistent) {
+            ++failures;
+            continue;
+        }
+
+        if (print) {
+            for (const auto& t : expected) fmt::print("{}\n", render(t));
+            continue;
+        }
+        if (!golden_dir.empty()) {
+            const std::string stem = path.substr(path.find_last_of("/\\") + 1);
+            const std::string golden = golden_dir + "/" + stem.substr(0, stem.rfind('.')) + ".tokens";
+            if (!check_golden(path, golden, expected)) ++failures;
+        }
+
+        if (stream_buffer != 0) {
+            for (size_t chunk : {size_t(1), size_t(7), size_t(0)}) {
+                if (!check_stream(path, *source, expected, stream_buffer, chunk)) ++failures;
+            }
+        }
+        // 切分点随块数移动，逐个块数检查，覆盖切分点落在各行之后的情形
+        for (size_t jobs = 2; jobs <= parallel_jobs; ++jobs) {
+            if (!check_parallel(path, *source, expected, jobs)) {
+                ++failures;
+                break;
+            }
+        }
+        fmt::print("{}: {} tokens\n", path, expected.size());
+    }
+    return failures == 0 ? 0 : 1;
+}